@@ -35,7 +35,7 @@
    fmtdytst.c for details of the Dylan object structure.*/
 #define N_SLOT_TESTOBJ 100
 
-static void test_main(void)
+static void test_main(mps_bool_t object_starts)
 {
   mps_arena_t arena;
   mps_pool_t amcz_pool, mvff_pool;
@@ -73,6 +73,7 @@ static void test_main(void)
   /* Create the pool */
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_FORMAT, obj_fmt);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_OBJECT_STARTS, object_starts);
     die(mps_pool_create_k(&amcz_pool, arena, mps_class_amcz(), args), "mps_pool_create_k amcz");
   } MPS_ARGS_END(args);
 
@@ -203,7 +204,8 @@ int main(int argc, char *argv[])
 {
   testlib_init(argc, argv);
 
-  test_main();
+  test_main(FALSE);
+  test_main(TRUE);
 
   printf("%s: Conclusion, failed to find any defects.\n", argv[0]);
 
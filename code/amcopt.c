@@ -0,0 +1,693 @@
+/* amcopt.c: POOL CLASS AMC OPTIONS TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Focused checks of the optional AMC behaviours, and of the
+ * optional arena and chain behaviours that matter most to AMC, each
+ * run in a setting where it is guaranteed to take effect, which the
+ * stress test <code/amcss.c> cannot promise.
+ */
+
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "testlib.h"
+#include "mpm.h"
+#include "mpslib.h"
+#include "mpscamc.h"
+#include "mpsavm.h"
+#include "mps.h"
+
+#include <stdio.h> /* fclose, fgets, printf, rewind, tmpfile */
+#include <string.h> /* strstr */
+
+
+#define testArenaSIZE   ((size_t)16 << 20)
+#define rootsCOUNT      20000
+#define genCOUNT        2
+#define largeGRAIN      ((size_t)64 << 10) /* bigger than AMC's largeSize */
+#define largeSIZE       ((size_t)40 << 10)
+#define churnCOUNT      200000
+#define startsCOUNT     1000
+#define nurseryCACHE    ((size_t)64 << 10)
+
+/* objNULL needs to be odd so that it's ignored in roots. */
+#define objNULL         ((mps_addr_t)MPS_WORD_CONST(0xDECEA5ED))
+
+static mps_addr_t roots[rootsCOUNT];
+
+
+/* make_size -- allocate one object of the given size */
+
+static mps_addr_t make_size(mps_ap_t ap, size_t size)
+{
+  mps_addr_t p;
+  mps_res_t res;
+
+  do {
+    MPS_RESERVE_BLOCK(res, p, ap, size);
+    if (res)
+      die(res, "MPS_RESERVE_BLOCK");
+    res = dylan_init(p, size, roots, rootsCOUNT);
+    if (res)
+      die(res, "dylan_init");
+  } while (!mps_commit(ap, p, size));
+
+  return p;
+}
+
+
+/* make -- allocate one small object */
+
+static mps_addr_t make(mps_ap_t ap)
+{
+  size_t length = rnd() % 10;
+  return make_size(ap, (length + 2) * sizeof(mps_word_t));
+}
+
+
+/* make_zeroed -- allocate one small object, checking it is zeroed */
+
+static mps_addr_t make_zeroed(mps_ap_t ap)
+{
+  size_t size = (rnd() % 10 + 2) * sizeof(mps_word_t);
+  mps_addr_t p;
+  mps_res_t res;
+  size_t i;
+
+  do {
+    MPS_RESERVE_BLOCK(res, p, ap, size);
+    if (res)
+      die(res, "MPS_RESERVE_BLOCK");
+    for (i = 0; i < size / sizeof(mps_word_t); ++i)
+      Insist(((mps_word_t *)p)[i] == 0);
+    res = dylan_init(p, size, roots, rootsCOUNT);
+    if (res)
+      die(res, "dylan_init");
+  } while (!mps_commit(ap, p, size));
+
+  return p;
+}
+
+
+/* roots_create -- clear the roots and register them */
+
+static void roots_create(mps_root_t *rootReturn, mps_arena_t arena)
+{
+  size_t i;
+
+  for (i = 0; i < rootsCOUNT; ++i)
+    roots[i] = objNULL;
+  die(mps_root_create_table_masked(rootReturn, arena, mps_rank_exact(),
+                                   (mps_rm_t)0, &roots[0], rootsCOUNT,
+                                   (mps_word_t)1),
+      "root_create_table");
+}
+
+
+/* churn -- allocate many objects, of which only a few stay alive */
+
+static void churn(mps_ap_t ap, size_t live)
+{
+  size_t i;
+
+  for (i = 0; i < churnCOUNT; ++i)
+    roots[rnd() % live] = make(ap);
+}
+
+
+/* check_roots -- check the objects that the roots refer to */
+
+static void check_roots(void)
+{
+  size_t i;
+
+  for (i = 0; i < rootsCOUNT; ++i) {
+    if (roots[i] != objNULL) {
+      Insist(dylan_check(roots[i]));
+    }
+  }
+}
+
+
+/* pool_says -- does the pool's description include some text? */
+
+static mps_bool_t pool_says(mps_pool_t pool, const char *text)
+{
+  FILE *stream = tmpfile();
+  char line[256];
+  mps_bool_t found = FALSE;
+
+  Insist(stream != NULL);
+  die(PoolDescribe(pool, (mps_lib_FILE *)stream, 0), "PoolDescribe");
+  rewind(stream);
+  while (!found && fgets(line, sizeof line, stream) != NULL)
+    found = strstr(line, text) != NULL;
+  (void)fclose(stream);
+  return found;
+}
+
+
+/* test_promote -- survivors are promoted and counted as survivors
+ *
+ * Every object stays alive, so the nursery's survival rate climbs
+ * above the threshold and its segments are promoted in place. The
+ * test does not ramp, because promotion is off during ramps.
+ * <design/poolamc#.promote>
+ */
+
+static void test_promote(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 64, 0.85 }, { 8192, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  Size promoted;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_PROMOTE_SURVIVAL, 0.5);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  for (i = 0; i < rootsCOUNT; ++i)
+    roots[i] = objNULL;
+  die(mps_root_create_table_masked(&root, arena, mps_rank_exact(),
+                                   (mps_rm_t)0, &roots[0], rootsCOUNT,
+                                   (mps_word_t)1),
+      "root_create_table");
+
+  for (i = 0; i < rootsCOUNT; ++i)
+    roots[i] = make(ap);
+
+  mps_arena_park(arena);
+  promoted = 0;
+  for (i = 0; i < genCOUNT; ++i)
+    promoted += ChainGen(chain, i)->promotedSize;
+  printf("collections %lu, promoted %lu bytes\n",
+         (unsigned long)mps_collections(arena), (unsigned long)promoted);
+  Insist(promoted > 0);
+
+  mps_root_destroy(root);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_large -- only large objects keep their address
+ *
+ * The arena grain is bigger than the pool's largeSize, so every
+ * segment is at least that big, but only a segment created for a
+ * large reserve holds a single object that can be preserved in
+ * place. A small object at the base of an ordinary segment must
+ * still be copied. <design/poolamc#.large.promote>
+ */
+
+static void test_large(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 1024, 0.85 }, { 4096, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  mps_addr_t small, large;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  for (i = 0; i < rootsCOUNT; ++i)
+    roots[i] = objNULL;
+  die(mps_root_create_table_masked(&root, arena, mps_rank_exact(),
+                                   (mps_rm_t)0, &roots[0], rootsCOUNT,
+                                   (mps_word_t)1),
+      "root_create_table");
+
+  /* The large object comes first so that the small one is at the
+   * base of the next segment rather than in the large one's buffer. */
+  roots[0] = large = make_size(ap, largeSIZE);
+  roots[1] = small = make(ap);
+  for (i = 2; i < 100; ++i)
+    roots[i] = make(ap);
+  /* Detach the buffer, or its segment would be nailed. */
+  mps_ap_destroy(ap);
+
+  mps_arena_collect(arena);
+  Insist(roots[0] == large);
+  Insist(roots[1] != small);
+  for (i = 0; i < 100; ++i)
+    Insist(dylan_check(roots[i]));
+
+  mps_arena_park(arena);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+}
+
+
+/* test_object_starts -- objects are found from interior addresses
+ *
+ * With object-start tables, mps_addr_object finds each object from
+ * an address inside it, and an ambiguous reference into an object
+ * pins the whole object. <design/poolamc#.starts>
+ */
+
+static void test_object_starts(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 1024, 0.85 }, { 4096, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root, ambigRoot;
+  mps_addr_t ambig[1], obj, pinned;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_OBJECT_STARTS, TRUE);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  roots_create(&root, arena);
+
+  for (i = 0; i < startsCOUNT; ++i)
+    roots[i] = make(ap);
+
+  mps_arena_park(arena);
+  for (i = 0; i < startsCOUNT; ++i) {
+    mps_addr_t interior = (char *)roots[i] + sizeof(mps_word_t);
+    die(mps_addr_object(&obj, arena, interior), "mps_addr_object");
+    Insist(obj == roots[i]);
+  }
+
+  /* Detach the buffer, or its segment would be nailed. */
+  mps_ap_destroy(ap);
+  pinned = roots[startsCOUNT / 2];
+  ambig[0] = (char *)pinned + sizeof(mps_word_t);
+  die(mps_root_create_table(&ambigRoot, arena, mps_rank_ambig(),
+                            (mps_rm_t)0, ambig, NELEMS(ambig)),
+      "root_create_table(ambig)");
+  mps_arena_collect(arena);
+  Insist(roots[startsCOUNT / 2] == pinned);
+  check_roots();
+
+  mps_root_destroy(ambigRoot);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_adapt -- adaptive capacities respect their bounds
+ *
+ * The targets ask for collections more often than the test can
+ * manage, and pauses shorter than any collection, so the nursery's
+ * capacity is pushed down to its lower bound.
+ * <design/strategy#.policy.adapt>
+ */
+
+static void test_adapt(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 256, 0.85 }, { 4096, 0.45 } };
+  mps_gen_bounds_s bounds[1];
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  bounds[0].mps_min_capacity = params[0].mps_capacity / 2;
+  bounds[0].mps_max_capacity = params[0].mps_capacity * 2;
+  mps_chain_adapt(chain, NELEMS(bounds), bounds, 1e-6, 1e-6);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  roots_create(&root, arena);
+
+  churn(ap, 100);
+  mps_arena_park(arena);
+  Insist(ChainGen(chain, 0)->capacity
+         == bounds[0].mps_min_capacity * 1024);
+  Insist(ChainGen(chain, 1)->capacity == params[1].mps_capacity * 1024);
+  check_roots();
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_auto_ramp -- the pool detects the start and end of a ramp
+ *
+ * First every object survives, which looks like the start of a
+ * ramp, then nearly every object dies, which looks like its end.
+ * <design/poolamc#.ramp.auto>
+ */
+
+static void test_auto_ramp(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 64, 0.85 }, { 8192, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_AUTO_RAMP, TRUE);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  roots_create(&root, arena);
+
+  for (i = 0; i < rootsCOUNT; ++i)
+    roots[i] = make(ap);
+  Insist(pool_says(pool, "autoRamping YES"));
+
+  churn(ap, 10);
+  Insist(pool_says(pool, "autoRamping NO"));
+  check_roots();
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_zeroed -- a zeroed allocation point only returns zeroed memory
+ *
+ * The nursery is collected many times, so most of the memory is
+ * reused after being filled with objects. <design/buffer#.zeroed>
+ */
+
+static void test_zeroed(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 64, 0.85 }, { 4096, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  unsigned long collections;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_RANK, mps_rank_exact());
+    MPS_ARGS_ADD(args, MPS_KEY_AP_ZEROED, TRUE);
+    die(mps_ap_create_k(&ap, pool, args), "ap_create");
+  } MPS_ARGS_END(args);
+  roots_create(&root, arena);
+
+  collections = mps_collections(arena);
+  for (i = 0; i < churnCOUNT; ++i)
+    roots[rnd() % 100] = make_zeroed(ap);
+  Insist(mps_collections(arena) > collections);
+  check_roots();
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_nursery_cache -- the nursery fits in the cache
+ *
+ * The arena limits the nursery's capacity to the cache size, and
+ * remembers no more than that much freed nursery memory for reuse.
+ * <design/strategy#.policy.nursery>
+ */
+
+static void test_nursery_cache(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 1024, 0.85 }, { 4096, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  GenDesc nursery;
+  unsigned long collections;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  nursery = ChainGen(chain, 0);
+  Insist(nursery->capacity == nurseryCACHE);
+  Insist(nursery->recycleLimit == nurseryCACHE);
+  Insist(ChainGen(chain, 1)->recycleLimit == 0);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  roots_create(&root, arena);
+
+  collections = mps_collections(arena);
+  churn(ap, 100);
+  Insist(mps_collections(arena) > collections);
+  Insist(nursery->recycledSize <= nurseryCACHE);
+  check_roots();
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_nursery_cache_adapt -- adaptation keeps the nursery in cache
+ *
+ * Make the nursery adaptive with a maximum capacity well above the
+ * nursery cache size and an interval target that can only be met by
+ * growing it, and check that its capacity never exceeds the cache.
+ * <design/strategy#.policy.nursery.adapt>.
+ */
+
+static void test_nursery_cache_adapt(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 1024, 0.85 }, { 4096, 0.45 } };
+  mps_gen_bounds_s bounds[1];
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  GenDesc nursery;
+  unsigned long collections;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  nursery = ChainGen(chain, 0);
+  bounds[0].mps_min_capacity = 16;
+  bounds[0].mps_max_capacity = 16 * nurseryCACHE / 1024;
+  mps_chain_adapt(chain, NELEMS(bounds), bounds, 1e6, 0.0);
+  Insist(nursery->maxCapacity == nurseryCACHE);
+  Insist(nursery->capacity <= nurseryCACHE);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  roots_create(&root, arena);
+
+  collections = mps_collections(arena);
+  churn(ap, 100);
+  mps_arena_park(arena);
+  Insist(mps_collections(arena) > collections);
+  Insist(nursery->capacity == nurseryCACHE);
+  Insist(nursery->recycledSize <= nurseryCACHE);
+  check_roots();
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* test_fine_zones -- the fine zone filter keeps live objects
+ *
+ * The nursery is collected many times while older objects refer to
+ * it, so any reference to a white object that the filter wrongly
+ * rejected would leave a dangling reference for check_roots to find.
+ * <design/trace#.fix.fine>
+ */
+
+static void test_fine_zones(mps_arena_t arena)
+{
+  mps_gen_param_s params[genCOUNT] = { { 64, 0.85 }, { 4096, 0.45 } };
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+
+  Insist(arena->fineZones);
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, params), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  roots_create(&root, arena);
+
+  churn(ap, 1000);
+  check_roots();
+  mps_arena_collect(arena);
+  check_roots();
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+
+  testlib_init(argc, argv);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  test_promote(arena);
+  test_object_starts(arena);
+  test_adapt(arena);
+  test_auto_ramp(arena);
+  test_zeroed(arena);
+  mps_arena_destroy(arena);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_NURSERY_CACHE_SIZE, nurseryCACHE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  test_nursery_cache(arena);
+  test_nursery_cache_adapt(arena);
+  mps_arena_destroy(arena);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_FINE_ZONES, TRUE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  test_fine_zones(arena);
+  mps_arena_destroy(arena);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, largeGRAIN);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  test_large(arena);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
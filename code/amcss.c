@@ -122,6 +122,26 @@ static mps_addr_t make(size_t rootsCount)
 }
 
 
+/* pressureHandler -- count reports of memory pressure
+ *
+ * Releases nothing, so the MPS should go ahead and collect.
+ */
+
+static unsigned long pressureCalls = 0;
+
+static size_t pressureHandler(mps_arena_t pressureArena,
+                              mps_pressure_level_t level,
+                              size_t target, void *closure)
+{
+  Insist(pressureArena == arena);
+  Insist(level == MPS_PRESSURE_MODERATE || level == MPS_PRESSURE_CRITICAL);
+  testlib_unused(target);
+  Insist(closure == &pressureCalls);
+  ++ pressureCalls;
+  return 0;
+}
+
+
 /* test_stepper -- stepping function for walk */
 
 static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
@@ -350,6 +370,27 @@ int main(int argc, char *argv[])
   report();
   mps_arena_destroy(arena);
 
+  /* Run again with a soft limit that the test exceeds, so that the
+   * pressure handler is called, and some collections start because of
+   * the limit. */
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, scale * testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, grainSize);
+    MPS_ARGS_ADD(args, MPS_KEY_SOFT_LIMIT, scale * testArenaSIZE / 4);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
+  } MPS_ARGS_END(args);
+  mps_message_type_enable(arena, mps_message_type_gc());
+  mps_message_type_enable(arena, mps_message_type_gc_start());
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  mps_arena_pressure_handler_set(arena, pressureHandler, &pressureCalls,
+                                 0.8, 0.95);
+  test(mps_class_amc(), exactRootsCOUNT);
+  mps_thread_dereg(thread);
+  report();
+  printf("Pressure handler called %lu times.\n", pressureCalls);
+  Insist(pressureCalls > 0);
+  mps_arena_destroy(arena);
+
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
 }
@@ -39,6 +39,7 @@ static mps_ap_t ap;
 static mps_addr_t exactRoots[exactRootsCOUNT];
 static mps_addr_t ambigRoots[ambigRootsCOUNT];
 static size_t totalSize = 0;
+static size_t objectSize = 0;  /* fixed object size, or 0 if variable */
 
 
 /* report - report statistics from any messages */
@@ -87,6 +88,9 @@ static mps_addr_t make(void)
   mps_addr_t p;
   mps_res_t res;
 
+  if (objectSize != 0)
+    size = objectSize;
+
   do {
     MPS_RESERVE_BLOCK(res, p, ap, size);
     if (res)
@@ -195,6 +199,100 @@ static void test_pool(mps_pool_class_t pool_class, mps_arg_s args[],
 }
 
 
+/* test_object_size_params -- check that bad object sizes are rejected */
+
+static void test_object_size_params(mps_fmt_t format)
+{
+  mps_pool_t pool;
+
+  /* Not a multiple of the format's alignment. */
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_AMS_OBJECT_SIZE, 8 * sizeof(mps_word_t) + 1);
+    cdie(mps_pool_create_k(&pool, arena, mps_class_ams(), args)
+         == MPS_RES_PARAM, "misaligned object size");
+  } MPS_ARGS_END(args);
+
+  /* Fenceposts change the object size, so the debug class refuses. */
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_AMS_OBJECT_SIZE, 8 * sizeof(mps_word_t));
+    MPS_ARGS_ADD(args, MPS_KEY_POOL_DEBUG_OPTIONS, &freecheckOptions);
+    cdie(mps_pool_create_k(&pool, arena, mps_class_ams_debug(), args)
+         == MPS_RES_PARAM, "object size in debug pool");
+  } MPS_ARGS_END(args);
+}
+
+
+/* test_seg_cache -- check that an empty segment is kept and reused
+ *
+ * <design/poolams#.reclaim.cache>. Uses its own arena with the default
+ * grain size, so that a segment for a small object fits in the cache.
+ */
+
+#define cacheObjSIZE    (8 * sizeof(mps_word_t))
+
+static void seg_cache_alloc(mps_ap_t cacheAp, size_t count)
+{
+  size_t i;
+  for (i = 0; i < count; ++i) {
+    mps_addr_t p;
+    do {
+      die(mps_reserve(&p, cacheAp, cacheObjSIZE), "reserve");
+      die(dylan_init(p, cacheObjSIZE, NULL, 0), "dylan_init");
+    } while (!mps_commit(cacheAp, p, cacheObjSIZE));
+  }
+}
+
+static void test_seg_cache(void)
+{
+  mps_arena_t cacheArena;
+  mps_fmt_t format;
+  mps_pool_t pool;
+  mps_ap_t cacheAp;
+  size_t kept;
+
+  die(mps_arena_create_k(&cacheArena, mps_arena_class_vm(), mps_args_none),
+      "arena_create");
+  mps_arena_park(cacheArena);
+  if (ArenaGrainSize((Arena)cacheArena) > AMS_SEG_CACHE_SIZE) {
+    printf("Grain too large to test the AMS segment cache.\n");
+    mps_arena_destroy(cacheArena);
+    return;
+  }
+  die(mps_fmt_create_A(&format, cacheArena, dylan_fmt_A()), "fmt_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    die(mps_pool_create_k(&pool, cacheArena, mps_class_ams(), args),
+        "pool_create");
+  } MPS_ARGS_END(args);
+
+  /* Fill several cachefuls of segments with garbage: reclaim frees
+     all but a cacheful of them. */
+  die(mps_ap_create_k(&cacheAp, pool, mps_args_none), "ap_create");
+  seg_cache_alloc(cacheAp, 4 * AMS_SEG_CACHE_SIZE / cacheObjSIZE);
+  mps_ap_destroy(cacheAp);
+  Insist(mps_pool_total_size(pool) > 2 * AMS_SEG_CACHE_SIZE);
+  mps_arena_collect(cacheArena);
+  kept = mps_pool_total_size(pool);
+  printf("AMS kept %lu bytes of empty segments.\n", (unsigned long)kept);
+  Insist(kept > 0);
+  Insist(kept <= AMS_SEG_CACHE_SIZE);
+  Insist(mps_pool_free_size(pool) == kept);
+
+  /* The next allocation uses a kept segment instead of a new one. */
+  die(mps_ap_create_k(&cacheAp, pool, mps_args_none), "ap_create");
+  seg_cache_alloc(cacheAp, 1);
+  Insist(mps_pool_total_size(pool) == kept);
+  Insist(mps_pool_free_size(pool) < kept);
+  mps_ap_destroy(cacheAp);
+
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(cacheArena);
+}
+
+
 int main(int argc, char *argv[])
 {
   int i;
@@ -216,19 +314,30 @@ int main(int argc, char *argv[])
   die(mps_fmt_create_A(&format, arena, dylan_fmt_A()), "fmt_create");
   die(mps_chain_create(&chain, arena, 1, testChain), "chain_create");
 
-  for (i = 0; i < 8; i++) {
+  test_object_size_params(format);
+  test_seg_cache();
+
+  for (i = 0; i < 16; i++) {
     int debug = i % 2;
     int ownChain = (i / 2) % 2;
     int ambig = (i / 4) % 2;
-    printf("\n\n*** AMS%s with %sCHAIN and %sSUPPORT_AMBIGUOUS\n",
+    int fixed = (i / 8) % 2;
+    if (debug && fixed)
+      continue; /* see test_object_size_params */
+    objectSize = fixed ? 8 * sizeof(mps_word_t) : 0;
+    printf("\n\n*** AMS%s with %sCHAIN, %sSUPPORT_AMBIGUOUS"
+           " and %sOBJECT_SIZE\n",
            debug ? " Debug" : "",
            ownChain ? "" : "!",
-           ambig ? "" : "!");
+           ambig ? "" : "!",
+           fixed ? "" : "!");
     MPS_ARGS_BEGIN(args) {
       MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
       if (ownChain)
         MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
       MPS_ARGS_ADD(args, MPS_KEY_AMS_SUPPORT_AMBIGUOUS, ambig);
+      if (fixed)
+        MPS_ARGS_ADD(args, MPS_KEY_AMS_OBJECT_SIZE, objectSize);
       MPS_ARGS_ADD(args, MPS_KEY_POOL_DEBUG_OPTIONS, &freecheckOptions);
       test_pool(debug ? mps_class_ams_debug() : mps_class_ams(), args, ambig);
     } MPS_ARGS_END(args);
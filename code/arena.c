@@ -9,6 +9,7 @@
 #include "poolmvff.h"
 #include "mpm.h"
 #include "cbs.h"
+#include "btree.h"
 #include "bt.h"
 #include "poolmfs.h"
 #include "mpscmfs.h"
@@ -19,7 +20,10 @@ SRCID(arena, "$Id$");
 
 #define ArenaControlPool(arena) MVFFPool(&(arena)->controlPoolStruct)
 #define ArenaCBSBlockPool(arena) MFSPool(&(arena)->freeCBSBlockPoolStruct)
-#define ArenaFreeLand(arena) CBSLand(&(arena)->freeLandStruct)
+#define ArenaFreeLand(arena) \
+  ((arena)->freeBTree \
+   ? BTreeLand(&(arena)->freeLandStruct.btree) \
+   : CBSLand(&(arena)->freeLandStruct.cbs))
 
 
 /* ArenaGrainSizeCheck -- check that size is a valid arena grain size */
@@ -40,11 +44,15 @@ Bool ArenaGrainSizeCheck(Size size)
 /* Forward declarations */
 
 static void ArenaTrivCompact(Arena arena, Trace trace);
-static void arenaFreePage(Arena arena, Addr base, Pool pool);
+static void arenaFreePages(Arena arena, Addr base, Size size, Pool pool);
 static void arenaFreeLandFinish(Arena arena);
+static Res arenaDescribeFreeZones(Arena arena, mps_lib_FILE *stream,
+                                  Count depth);
 static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args);
 static void ArenaAbsFinish(Inst inst);
 static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth);
+static void arenaSoftLimitPurge(Arena arena);
+static Res arenaReadSoftLimit(Arena arena);
 
 
 static void ArenaNoFree(Addr base, Size size, Pool pool)
@@ -132,6 +140,8 @@ DEFINE_CLASS(Arena, AbstractArena, klass)
   klass->compact = ArenaTrivCompact;
   klass->pagesMarkAllocated = ArenaNoPagesMarkAllocated;
   klass->chunkPageMapped = ArenaNoChunkPageMapped;
+  klass->zero = ArenaTrivZero;
+  klass->zeroSpare = ArenaNoZeroSpare;
   klass->sig = ArenaClassSig;
   AVERT(ArenaClass, klass);
 }
@@ -156,6 +166,8 @@ Bool ArenaClassCheck(ArenaClass klass)
   CHECKL(FUNCHECK(klass->compact));
   CHECKL(FUNCHECK(klass->pagesMarkAllocated));
   CHECKL(FUNCHECK(klass->chunkPageMapped));
+  CHECKL(FUNCHECK(klass->zero));
+  CHECKL(FUNCHECK(klass->zeroSpare));
 
   /* Check that arena classes override sets of related methods. */
   CHECKL((klass->init == ArenaAbsInit)
@@ -189,9 +201,15 @@ Bool ArenaCheck(Arena arena)
    * reserved until ChunkInit calls ArenaChunkInsert.
    */
   CHECKL(arena->committed <= arena->commitLimit);
+  /* softLimit and osSoftLimit are arbitrary. */
+  CHECKL(0.0 <= arena->softLimitFraction);
+  CHECKL(arena->softLimitFraction <= 1.0);
   CHECKL(arena->spareCommitted <= arena->committed);
   CHECKL(0.0 <= arena->spare);
   CHECKL(arena->spare <= 1.0);
+  CHECKL(0.0 <= arena->spareHalfLife);
+  CHECKL(arena->spareZeroed <= arena->spareCommitted);
+  CHECKL(BoolCheck(arena->zeroedWanted));
   CHECKL(0.0 <= arena->pauseTime);
 
   CHECKL(arena->zoneShift == ZoneShiftUNSET
@@ -201,11 +219,15 @@ Bool ArenaCheck(Arena arena)
   /* Stripes can't be smaller than grains. */
   CHECKL(arena->zoneShift == ZoneShiftUNSET
          || ((Size)1 << arena->zoneShift) >= arena->grainSize);
+  CHECKL(BoolCheck(arena->fineZones));
+  CHECKL(arena->fineZoneShift == ZoneShiftUNSET
+         || arena->fineZoneShift + MPS_WORD_SHIFT == arena->zoneShift);
 
   if (arena->lastTract == NULL) {
     CHECKL(arena->lastTractBase == (Addr)0);
   } else {
-    CHECKL(TractBase(arena->lastTract) == arena->lastTractBase);
+    /* Not TractBase, which checks the arena. */
+    CHECKD_NOSIG(Tract, arena->lastTract);
   }
 
   if (arena->primary != NULL) {
@@ -220,6 +242,7 @@ Bool ArenaCheck(Arena arena)
   CHECKL(LocusCheck(arena));
 
   CHECKL(BoolCheck(arena->hasFreeLand));
+  CHECKL(BoolCheck(arena->freeBTree));
   if (arena->hasFreeLand)
     CHECKD(Land, ArenaFreeLand(arena));
 
@@ -235,16 +258,27 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
 {
   Res res;
   Bool zoned = ARENA_DEFAULT_ZONED;
+  Bool fineZones = ARENA_DEFAULT_FINE_ZONES;
+  Bool freeBTree = ARENA_DEFAULT_FREE_BTREE;
   Size commitLimit = ARENA_DEFAULT_COMMIT_LIMIT;
+  Size softLimit = ARENA_DEFAULT_SOFT_LIMIT;
+  double softLimitFraction = ARENA_DEFAULT_SOFT_LIMIT_FRACTION;
   double spare = ARENA_SPARE_DEFAULT;
+  double spareHalfLife = ARENA_DEFAULT_SPARE_HALF_LIFE;
   double pauseTime = ARENA_DEFAULT_PAUSE_TIME;
+  Size nurseryCacheSize = ARENA_DEFAULT_NURSERY_CACHE_SIZE;
   mps_arg_s arg;
+  Index i;
 
   AVER(arena != NULL);
   AVERT(ArenaGrainSize, grainSize);
 
   if (ArgPick(&arg, args, MPS_KEY_ARENA_ZONED))
     zoned = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_FINE_ZONES))
+    fineZones = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_FREE_BTREE))
+    freeBTree = arg.val.b;
   if (ArgPick(&arg, args, MPS_KEY_COMMIT_LIMIT))
     commitLimit = arg.val.size;
   /* MPS_KEY_SPARE_COMMIT_LIMIT is deprecated */
@@ -256,8 +290,19 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   }
   if (ArgPick(&arg, args, MPS_KEY_SPARE))
     spare = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_SPARE_HALF_LIFE))
+    spareHalfLife = arg.val.d;
+  AVER(0.0 <= spareHalfLife);
   if (ArgPick(&arg, args, MPS_KEY_PAUSE_TIME))
     pauseTime = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_NURSERY_CACHE_SIZE))
+    nurseryCacheSize = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_SOFT_LIMIT))
+    softLimit = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_SOFT_LIMIT_FRACTION))
+    softLimitFraction = arg.val.d;
+  AVER(0.0 <= softLimitFraction);
+  AVER(softLimitFraction <= 1.0);
 
   /* Superclass init */
   InstInit(CouldBeA(Inst, arena));
@@ -265,9 +310,21 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->reserved = (Size)0;
   arena->committed = (Size)0;
   arena->commitLimit = commitLimit;
+  arena->softLimit = softLimit;
+  arena->osSoftLimit = SizeMAX;
+  arena->softLimitFraction = softLimitFraction;
+  /* Failure to find the operating system's limit is not an error:
+   * the client can call ArenaRefreshSoftLimit to find out why. */
+  if (softLimitFraction > 0.0)
+    (void)arenaReadSoftLimit(arena);
   arena->spareCommitted = (Size)0;
   arena->spare = spare;
+  arena->spareHalfLife = spareHalfLife;
+  arena->spareDecayClock = ClockNow();
+  arena->spareZeroed = (Size)0;
+  arena->zeroedWanted = FALSE;
   arena->pauseTime = pauseTime;
+  arena->nurseryCacheSize = nurseryCacheSize;
   arena->grainSize = grainSize;
   /* zoneShift must be overridden by arena class init */
   arena->zoneShift = ZoneShiftUNSET;
@@ -275,8 +332,15 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->lastTract = NULL;
   arena->lastTractBase = NULL;
   arena->hasFreeLand = FALSE;
+  arena->freeBTree = freeBTree;
   arena->freeZones = ZoneSetUNIV;
   arena->zoned = zoned;
+  arena->freeLandZones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(arena->freeLandZoneSize); ++i)
+    arena->freeLandZoneSize[i] = 0;
+  arena->fineZones = fineZones;
+  /* fineZoneShift is set once zoneShift is known, in ArenaCreate */
+  arena->fineZoneShift = ZoneShiftUNSET;
 
   arena->primary = NULL;
   RingInit(ArenaChunkRing(arena));
@@ -293,15 +357,25 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->sig = ArenaSig;
   AVERC(Arena, arena);
 
-  /* Initialise a pool to hold the CBS blocks for the arena's free
-   * land. This pool can't be allowed to extend itself using
-   * ArenaAlloc because it is used to implement ArenaAlloc, so
-   * MFSExtendSelf is set to FALSE. Failures to extend are handled
-   * where the free land is used: see arenaFreeLandInsertExtend. */
+  /* Initialise a pool to hold the CBS blocks (or B-tree nodes) for
+   * the arena's free land. This pool can't be allowed to extend
+   * itself using ArenaAlloc because it is used to implement
+   * ArenaAlloc, so MFSExtendSelf is set to FALSE. Failures to extend
+   * are handled where the free land is used: see
+   * arenaFreeLandInsertExtend. A B-tree may need several nodes for
+   * each operation, so its pool is extended by enough for any two
+   * operations <design/arena#.free.btree.extend>. */
 
   MPS_ARGS_BEGIN(piArgs) {
-    MPS_ARGS_ADD(piArgs, MPS_KEY_MFS_UNIT_SIZE, sizeof(CBSZonedBlockStruct));
-    MPS_ARGS_ADD(piArgs, MPS_KEY_EXTEND_BY, ArenaGrainSize(arena));
+    if (freeBTree) {
+      MPS_ARGS_ADD(piArgs, MPS_KEY_MFS_UNIT_SIZE, sizeof(BTreeNodeStruct));
+      MPS_ARGS_ADD(piArgs, MPS_KEY_EXTEND_BY,
+                   ARENA_BTREE_EXTEND_NODES * sizeof(BTreeNodeStruct)
+                   + sizeof(RingStruct));
+    } else {
+      MPS_ARGS_ADD(piArgs, MPS_KEY_MFS_UNIT_SIZE, sizeof(CBSZonedBlockStruct));
+      MPS_ARGS_ADD(piArgs, MPS_KEY_EXTEND_BY, ArenaGrainSize(arena));
+    }
     MPS_ARGS_ADD(piArgs, MFSExtendSelf, FALSE);
     res = PoolInit(ArenaCBSBlockPool(arena), arena, PoolClassMFS(), piArgs);
   } MPS_ARGS_END(piArgs);
@@ -329,6 +403,8 @@ failGlobalsInit:
  * exist on all platforms. */
 
 ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
+ARG_DEFINE_KEY(ARENA_HUGE_PAGES, Bool);
+ARG_DEFINE_KEY(ARENA_SINGLE_CHUNK, Bool);
 
 
 /* ArenaCreate -- create the arena and call initializers */
@@ -336,9 +412,15 @@ ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
 ARG_DEFINE_KEY(ARENA_GRAIN_SIZE, Size);
 ARG_DEFINE_KEY(ARENA_SIZE, Size);
 ARG_DEFINE_KEY(ARENA_ZONED, Bool);
+ARG_DEFINE_KEY(ARENA_FINE_ZONES, Bool);
+ARG_DEFINE_KEY(ARENA_FREE_BTREE, Bool);
 ARG_DEFINE_KEY(COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(SPARE_COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(PAUSE_TIME, double);
+ARG_DEFINE_KEY(NURSERY_CACHE_SIZE, Size);
+ARG_DEFINE_KEY(SPARE_HALF_LIFE, double);
+ARG_DEFINE_KEY(SOFT_LIMIT, Size);
+ARG_DEFINE_KEY(SOFT_LIMIT_FRACTION, double);
 
 static Res arenaFreeLandInit(Arena arena)
 {
@@ -350,9 +432,15 @@ static Res arenaFreeLandInit(Arena arena)
 
   /* Initialise the free land. */
   MPS_ARGS_BEGIN(liArgs) {
-    MPS_ARGS_ADD(liArgs, CBSBlockPool, ArenaCBSBlockPool(arena));
-    res = LandInit(ArenaFreeLand(arena), CLASS(CBSZoned), arena,
-                   ArenaGrainSize(arena), arena, liArgs);
+    if (arena->freeBTree) {
+      MPS_ARGS_ADD(liArgs, BTreeNodePool, ArenaCBSBlockPool(arena));
+      res = LandInit(ArenaFreeLand(arena), CLASS(BTreeZoned), arena,
+                     ArenaGrainSize(arena), arena, liArgs);
+    } else {
+      MPS_ARGS_ADD(liArgs, CBSBlockPool, ArenaCBSBlockPool(arena));
+      res = LandInit(ArenaFreeLand(arena), CLASS(CBSZoned), arena,
+                     ArenaGrainSize(arena), arena, liArgs);
+    }
   } MPS_ARGS_END(liArgs);
   AVER(res == ResOK); /* no allocation, no failure expected */
   if (res != ResOK)
@@ -407,6 +495,13 @@ Res ArenaCreate(Arena *arenaReturn, ArenaClass klass, ArgList args)
     goto failStripeSize;
   }
 
+  /* Divide each zone stripe into as many fine stripes as there are
+     zones. <design/trace#.fix.fine> */
+  if (arena->zoneShift >= MPS_WORD_SHIFT)
+    arena->fineZoneShift = arena->zoneShift - MPS_WORD_SHIFT;
+  else
+    arena->fineZones = FALSE; /* stripes too small to divide */
+
   res = arenaFreeLandInit(arena);
   if (res != ResOK)
     goto failFreeLandInit;
@@ -459,20 +554,25 @@ static void arenaMFSPageFreeVisitor(Pool pool, Addr base, Size size,
   AVERT(Pool, pool);
   AVER(closure == UNUSED_POINTER);
   UNUSED(closure);
-  UNUSED(size);
-  AVER(size == ArenaGrainSize(PoolArena(pool)));
-  arenaFreePage(PoolArena(pool), base, pool);
+  AVER(SizeIsArenaGrains(size, PoolArena(pool)));
+  arenaFreePages(PoolArena(pool), base, size, pool);
 }
 
 static void arenaFreeLandFinish(Arena arena)
 {
+  Index i;
+
   AVERT(Arena, arena);
   AVER(arena->hasFreeLand);
 
   /* We're about to free the memory occupied by the free land, which
-     contains a CBS.  We want to make sure that LandFinish doesn't try
-     to check the CBS, so nuke it here.  TODO: LandReset? */
-  arena->freeLandStruct.splayTreeStruct.root = TreeEMPTY;
+     contains a CBS or a B-tree.  We want to make sure that LandFinish
+     doesn't try to check or free its nodes, so nuke it here.  TODO:
+     LandReset? */
+  if (arena->freeBTree)
+    arena->freeLandStruct.btree.root = NULL;
+  else
+    arena->freeLandStruct.cbs.splayTreeStruct.root = TreeEMPTY;
 
   /* The CBS block pool can't free its own memory via ArenaFree because
    * that would use the free land. */
@@ -481,6 +581,9 @@ static void arenaFreeLandFinish(Arena arena)
 
   arena->hasFreeLand = FALSE;
   LandFinish(ArenaFreeLand(arena));
+  arena->freeLandZones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(arena->freeLandZoneSize); ++i)
+    arena->freeLandZoneSize[i] = 0;
 }
 
 void ArenaDestroy(Arena arena)
@@ -562,23 +665,42 @@ static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "reserved         $W\n", (WriteFW)arena->reserved,
                "committed        $W\n", (WriteFW)arena->committed,
                "commitLimit      $W\n", (WriteFW)arena->commitLimit,
+               "softLimit        $W\n", (WriteFW)arena->softLimit,
+               "osSoftLimit      $W\n", (WriteFW)arena->osSoftLimit,
+               "softLimitFraction $D\n", (WriteFD)arena->softLimitFraction,
                "spareCommitted   $W\n", (WriteFW)arena->spareCommitted,
                "spare            $D\n", (WriteFD)arena->spare,
+               "spareHalfLife    $D\n", (WriteFD)arena->spareHalfLife,
+               "spareZeroed      $W\n", (WriteFW)arena->spareZeroed,
+               "zeroedWanted     $S\n", WriteFYesNo(arena->zeroedWanted),
                "zoneShift        $U\n", (WriteFU)arena->zoneShift,
                "grainSize        $W\n", (WriteFW)arena->grainSize,
                "lastTract        $P\n", (WriteFP)arena->lastTract,
                "lastTractBase    $P\n", (WriteFP)arena->lastTractBase,
                "primary          $P\n", (WriteFP)arena->primary,
                "hasFreeLand      $S\n", WriteFYesNo(arena->hasFreeLand),
+               "freeBTree        $S\n", WriteFYesNo(arena->freeBTree),
                "freeZones        $B\n", (WriteFB)arena->freeZones,
                "zoned            $S\n", WriteFYesNo(arena->zoned),
+               "freeLandZones    $B\n", (WriteFB)arena->freeLandZones,
+               "fineZones        $S\n", WriteFYesNo(arena->fineZones),
+               "fineZoneShift    $U\n", (WriteFU)arena->fineZoneShift,
                NULL);
   if (res != ResOK)
     return res;
 
+  if (arena->hasFreeLand) {
+    res = arenaDescribeFreeZones(arena, stream, depth + 2);
+    if (res != ResOK)
+      return res;
+  }
+
   res = WriteF(stream, depth + 2,
                "droppedMessages $U$S\n", (WriteFU)arena->droppedMessages,
                (arena->droppedMessages == 0 ? "" : "  -- MESSAGES DROPPED!"),
+               "droppedGCEvents $U\n", (WriteFU)arena->droppedGCEvents,
+               "pressureLevel   $U\n", (WriteFU)arena->pressureLevel,
+               "pressureReleased $W\n", (WriteFW)arena->pressureReleased,
                NULL);
   if (res != ResOK)
     return res;
@@ -618,9 +740,10 @@ static Res arenaDescribeTractsInChunk(Chunk chunk, mps_lib_FILE *stream, Count d
   for (pi = chunk->allocBase; pi < chunk->pages; ++pi) {
     if (BTGet(chunk->allocTable, pi)) {
       Tract tract = PageTract(ChunkPage(chunk, pi));
+      Addr base = PageIndexBase(chunk, pi);
       res = WriteF(stream, depth + 2, "[$P, $P)",
-                   (WriteFP)TractBase(tract),
-                   (WriteFP)TractLimit(tract, ChunkArena(chunk)),
+                   (WriteFP)base,
+                   (WriteFP)AddrAdd(base, ChunkPageSize(chunk)),
                    NULL);
       if (res != ResOK)
         return res;
@@ -788,7 +911,7 @@ void ArenaChunkRemoved(Arena arena, Chunk chunk)
 }
 
 
-/* arenaAllocPage -- allocate one page from the arena
+/* arenaAllocPages -- allocate contiguous pages from the arena
  *
  * This is a primitive allocator used to allocate pages for the arena
  * Land. It is called rarely and can use a simple search. It may not
@@ -796,7 +919,8 @@ void ArenaChunkRemoved(Arena arena, Chunk chunk)
  * bootstrap.  <design/bootstrap#.land.sol.alloc>.
  */
 
-static Res arenaAllocPageInChunk(Addr *baseReturn, Chunk chunk, Pool pool)
+static Res arenaAllocPagesInChunk(Addr *baseReturn, Chunk chunk,
+                                  Count pages, Pool pool)
 {
   Res res;
   Index basePageIndex, limitPageIndex;
@@ -809,11 +933,11 @@ static Res arenaAllocPageInChunk(Addr *baseReturn, Chunk chunk, Pool pool)
 
   if (!BTFindShortResRange(&basePageIndex, &limitPageIndex,
                            chunk->allocTable,
-                           chunk->allocBase, chunk->pages, 1))
+                           chunk->allocBase, chunk->pages, pages))
     return ResRESOURCE;
 
   res = Method(Arena, arena, pagesMarkAllocated)(arena, chunk,
-                                                 basePageIndex, 1,
+                                                 basePageIndex, pages,
                                                  pool);
   if (res != ResOK)
     return res;
@@ -822,24 +946,26 @@ static Res arenaAllocPageInChunk(Addr *baseReturn, Chunk chunk, Pool pool)
   return ResOK;
 }
 
-static Res arenaAllocPage(Addr *baseReturn, Arena arena, Pool pool)
+static Res arenaAllocPages(Addr *baseReturn, Arena arena, Count pages,
+                           Pool pool)
 {
   Res res;
 
   AVER(baseReturn != NULL);
   AVERT(Arena, arena);
+  AVER(pages > 0);
   AVERT(Pool, pool);
 
   /* Favour the primary chunk, because pages allocated this way aren't
      currently freed, and we don't want to prevent chunks being destroyed. */
   /* TODO: Consider how the ArenaCBSBlockPool might free pages. */
-  res = arenaAllocPageInChunk(baseReturn, arena->primary, pool);
+  res = arenaAllocPagesInChunk(baseReturn, arena->primary, pages, pool);
   if (res != ResOK) {
     Ring node, next;
     RING_FOR(node, ArenaChunkRing(arena), next) {
       Chunk chunk = RING_ELT(Chunk, arenaRing, node);
       if (chunk != arena->primary) {
-        res = arenaAllocPageInChunk(baseReturn, chunk, pool);
+        res = arenaAllocPagesInChunk(baseReturn, chunk, pages, pool);
         if (res == ResOK)
           break;
       }
@@ -849,37 +975,196 @@ static Res arenaAllocPage(Addr *baseReturn, Arena arena, Pool pool)
 }
 
 
-/* arenaFreePage -- free page allocated by arenaAllocPage */
+/* arenaFreePages -- free pages allocated by arenaAllocPages */
 
-static void arenaFreePage(Arena arena, Addr base, Pool pool)
+static void arenaFreePages(Arena arena, Addr base, Size size, Pool pool)
 {
   AVERT(Arena, arena);
   AVERT(Pool, pool);
-  Method(Arena, arena, free)(base, ArenaGrainSize(arena), pool);
+  Method(Arena, arena, free)(base, size, pool);
 }
 
 
-/* arenaExtendCBSBlockPool -- add a page of memory to the CBS block pool
+/* arenaExtendCBSBlockPool -- add pages of memory to the CBS block pool
+ *
+ * Adds one extent of the pool: a page for CBS blocks, or enough pages
+ * for ARENA_BTREE_EXTEND_NODES B-tree nodes.
  *
  * IMPORTANT: Must be followed by arenaExcludePage to ensure that the
- * page doesn't get allocated by ArenaAlloc.  See .insert.exclude.
+ * pages don't get allocated by ArenaAlloc.  See .insert.exclude.
  */
 
 static Res arenaExtendCBSBlockPool(Range pageRangeReturn, Arena arena)
 {
+  Size extendBy = arena->freeCBSBlockPoolStruct.extendBy;
   Addr pageBase, pageLimit;
   Res res;
 
-  res = arenaAllocPage(&pageBase, arena, ArenaCBSBlockPool(arena));
+  res = arenaAllocPages(&pageBase, arena,
+                        extendBy / ArenaGrainSize(arena),
+                        ArenaCBSBlockPool(arena));
   if (res != ResOK)
     return res;
-  pageLimit = AddrAdd(pageBase, ArenaGrainSize(arena));
+  pageLimit = AddrAdd(pageBase, extendBy);
   MFSExtend(ArenaCBSBlockPool(arena), pageBase, pageLimit);
 
   RangeInit(pageRangeReturn, pageBase, pageLimit);
   return ResOK;
 }
 
+/* arenaRangeZonesIterate -- visit the parts of a range in each zone
+ *
+ * Calls visitor for each zone stripe that the range overlaps, with
+ * the zone, the size of the overlap, and a count of 1. Whole cycles
+ * of MPS_WORD_WIDTH stripes are visited in one call per zone, with
+ * the count of stripes, so that the cost is bounded
+ * <design/arena#.impl.free.zones>.
+ */
+
+typedef void (*ArenaZoneVisitor)(Arena arena, Index zone, Size size,
+                                 Count pieces, void *closure);
+
+static void arenaRangeZonesIterate(Arena arena, Range range,
+                                   ArenaZoneVisitor visitor, void *closure)
+{
+  Addr base = RangeBase(range), limit = RangeLimit(range);
+  Size stripe = (Size)1 << arena->zoneShift;
+  Shift cycleShift = arena->zoneShift + MPS_WORD_SHIFT;
+
+  if (cycleShift < MPS_WORD_WIDTH) {
+    Count cycles = RangeSize(range) >> cycleShift;
+    if (cycles > 0) {
+      Index zone;
+      for (zone = 0; zone < MPS_WORD_WIDTH; ++zone)
+        (*visitor)(arena, zone, stripe, cycles, closure);
+      base = AddrAdd(base, cycles << cycleShift);
+    }
+  }
+
+  while (base < limit) {
+    Addr stripeLimit = (Addr)(((Word)base | (stripe - 1)) + 1);
+    if (stripeLimit <= base || stripeLimit > limit) /* wrapped or past end */
+      stripeLimit = limit;
+    (*visitor)(arena, AddrZone(arena, base), AddrOffset(base, stripeLimit),
+               1, closure);
+    base = stripeLimit;
+  }
+}
+
+
+/* arenaFreeLandNote -- account for a change to the free land
+ *
+ * Must be called with each range inserted into the free land (insert
+ * is TRUE) or deleted from it (insert is FALSE), to keep
+ * freeLandZoneSize and freeLandZones up to date
+ * <design/arena#.impl.free.zones>.
+ */
+
+static void arenaFreeLandNoteInsert(Arena arena, Index zone, Size size,
+                                    Count pieces, void *closure)
+{
+  UNUSED(closure);
+  arena->freeLandZoneSize[zone] += size * pieces;
+  arena->freeLandZones = BS_ADD(ZoneSet, arena->freeLandZones, zone);
+}
+
+static void arenaFreeLandNoteDelete(Arena arena, Index zone, Size size,
+                                    Count pieces, void *closure)
+{
+  UNUSED(closure);
+  AVER(arena->freeLandZoneSize[zone] >= size * pieces);
+  arena->freeLandZoneSize[zone] -= size * pieces;
+  if (arena->freeLandZoneSize[zone] == 0)
+    arena->freeLandZones = BS_DEL(ZoneSet, arena->freeLandZones, zone);
+}
+
+static void arenaFreeLandNote(Arena arena, Range range, Bool insert)
+{
+  AVERT(Arena, arena);
+  AVERT(Range, range);
+  AVERT(Bool, insert);
+
+  arenaRangeZonesIterate(arena, range,
+                         insert ? arenaFreeLandNoteInsert
+                         : arenaFreeLandNoteDelete,
+                         UNUSED_POINTER);
+}
+
+
+/* arenaFreeLandZonesSize -- total free address space in a zone set */
+
+static Size arenaFreeLandZonesSize(Arena arena, ZoneSet zones)
+{
+  Size size = 0;
+  Index zone;
+
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone)
+    if (ZoneSetIsMember(zones, zone))
+      size += arena->freeLandZoneSize[zone];
+  return size;
+}
+
+
+/* arenaDescribeFreeZones -- describe fragmentation of free land by zone
+ *
+ * <design/arena#.impl.free.zones.describe>
+ */
+
+typedef struct ArenaFreeZonesStatsStruct {
+  Count fragments[MPS_WORD_WIDTH];   /* free fragments in each zone */
+  Size largest[MPS_WORD_WIDTH];      /* largest fragment in each zone */
+} ArenaFreeZonesStatsStruct, *ArenaFreeZonesStats;
+
+static void arenaFreeZonesStatsVisit(Arena arena, Index zone, Size size,
+                                     Count pieces, void *closure)
+{
+  ArenaFreeZonesStats stats = closure;
+  UNUSED(arena);
+  stats->fragments[zone] += pieces;
+  if (size > stats->largest[zone])
+    stats->largest[zone] = size;
+}
+
+static Bool arenaFreeZonesStatsRange(Land land, Range range, void *closure)
+{
+  arenaRangeZonesIterate(LandArena(land), range,
+                         arenaFreeZonesStatsVisit, closure);
+  return TRUE;
+}
+
+static Res arenaDescribeFreeZones(Arena arena, mps_lib_FILE *stream,
+                                  Count depth)
+{
+  ArenaFreeZonesStatsStruct stats;
+  Land land = ArenaFreeLand(arena);
+  Index zone;
+  Res res;
+
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+    stats.fragments[zone] = 0;
+    stats.largest[zone] = 0;
+  }
+  (void)LandIterate(land, arenaFreeZonesStatsRange, &stats);
+
+  res = WriteF(stream, depth, "freeLandZoneSize {\n", NULL);
+  if (res != ResOK)
+    return res;
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+    if (arena->freeLandZoneSize[zone] == 0)
+      continue;
+    res = WriteF(stream, depth + 2,
+                 "zone $U: $W free in $U fragments, largest $W\n",
+                 (WriteFU)zone, (WriteFW)arena->freeLandZoneSize[zone],
+                 (WriteFU)stats.fragments[zone],
+                 (WriteFW)stats.largest[zone],
+                 NULL);
+    if (res != ResOK)
+      return res;
+  }
+  return WriteF(stream, depth, "} freeLandZoneSize\n", NULL);
+}
+
+
 /* arenaExcludePage -- exclude CBS block pool's page from free land
  *
  * Exclude the page we specially allocated for the CBS block pool
@@ -894,6 +1179,7 @@ static void arenaExcludePage(Arena arena, Range pageRange)
 
   res = LandDelete(&oldRange, land, pageRange);
   AVER(res == ResOK); /* we just gave memory to the Land */
+  arenaFreeLandNote(arena, pageRange, FALSE);
 }
 
 
@@ -930,9 +1216,13 @@ static Res arenaFreeLandInsertExtend(Range rangeReturn, Arena arena,
        bootstrap when the zoned CBS is empty. */
     res = LandInsert(rangeReturn, land, range);
     AVER(res == ResOK); /* we just gave memory to the CBS block pool */
+    arenaFreeLandNote(arena, range, TRUE);
     arenaExcludePage(arena, &pageRange);
+    return ResOK;
   }
 
+  if (res == ResOK)
+    arenaFreeLandNote(arena, range, TRUE);
   return ResOK;
 }
 
@@ -982,11 +1272,59 @@ Res ArenaFreeLandDelete(Arena arena, Addr base, Addr limit)
   RangeInit(&range, base, limit);
   land = ArenaFreeLand(arena);
   res = LandDelete(&oldRange, land, &range);
+  if (res == ResOK)
+    arenaFreeLandNote(arena, &range, FALSE);
 
   return res;
 }
 
 
+/* arenaFreeLandAllocRange -- make a range taken from the free land
+ * available to a pool
+ *
+ * range has just been deleted from the arena's free land, and
+ * oldRange is the block of the free land that contained it. Mark the
+ * tracts in range as belonging to pool and set *tractReturn to point
+ * to the first of them. If this fails, return range to the free land.
+ */
+
+static Res arenaFreeLandAllocRange(Tract *tractReturn, Arena arena,
+                                   Range range, Range oldRange, Pool pool)
+{
+  Chunk chunk = NULL; /* suppress uninit warning */
+  Bool b;
+  Index baseIndex;
+  Count pages;
+  Res res;
+
+  b = ChunkOfAddr(&chunk, arena, RangeBase(range));
+  AVER(b);
+  AVER(RangeIsAligned(range, ChunkPageSize(chunk)));
+  baseIndex = INDEX_OF_ADDR(chunk, RangeBase(range));
+  pages = ChunkSizeToPages(chunk, RangeSize(range));
+
+  res = Method(Arena, arena, pagesMarkAllocated)(arena, chunk, baseIndex, pages, pool);
+  if (res != ResOK)
+    goto failMark;
+
+  arena->freeZones = ZoneSetDiff(arena->freeZones,
+                                 ZoneSetOfRange(arena,
+                                                RangeBase(range),
+                                                RangeLimit(range)));
+
+  *tractReturn = PageTract(ChunkPage(chunk, baseIndex));
+  return ResOK;
+
+failMark:
+   {
+     Res insertRes = arenaFreeLandInsertExtend(oldRange, arena, range);
+     AVER(insertRes == ResOK); /* We only just deleted it. */
+     /* If the insert does fail, we lose some address space permanently. */
+   }
+   return res;
+}
+
+
 /* ArenaFreeLandAlloc -- allocate a contiguous range of tracts of
  * size bytes from the arena's free land.
  *
@@ -1001,10 +1339,7 @@ Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
                        Bool high, Size size, Pool pool)
 {
   RangeStruct range, oldRange;
-  Chunk chunk = NULL; /* suppress uninit warning */
-  Bool found, b;
-  Index baseIndex;
-  Count pages;
+  Bool found;
   Res res;
   Land land;
 
@@ -1019,9 +1354,17 @@ Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
   if (!arena->zoned)
     zones = ZoneSetUNIV;
 
-  /* Step 1. Find a range of address space. */
+  /* Step 1. Find a range of address space. Zones with no free address
+     space can't contribute, and if there isn't enough free address
+     space in the rest, the search must fail, so don't do it.
+     <design/arena#.impl.free.zones.alloc> */
 
   land = ArenaFreeLand(arena);
+  AVER_CRITICAL(arenaFreeLandZonesSize(arena, ZoneSetUNIV) == LandSize(land));
+  zones = ZoneSetInter(zones, arena->freeLandZones);
+  if (zones == ZoneSetEMPTY || arenaFreeLandZonesSize(arena, zones) < size)
+    return ResRESOURCE;
+
   res = LandFindInZones(&found, &range, &oldRange, land, size, zones, high);
 
   if (res == ResLIMIT) { /* found block, but couldn't store info */
@@ -1041,33 +1384,60 @@ Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
   if (!found) /* out of address space */
     return ResRESOURCE;
 
+  arenaFreeLandNote(arena, &range, FALSE);
+
   /* Step 2. Make memory available in the address space range. */
 
-  b = ChunkOfAddr(&chunk, arena, RangeBase(&range));
-  AVER(b);
-  AVER(RangeIsAligned(&range, ChunkPageSize(chunk)));
-  baseIndex = INDEX_OF_ADDR(chunk, RangeBase(&range));
-  pages = ChunkSizeToPages(chunk, RangeSize(&range));
+  return arenaFreeLandAllocRange(tractReturn, arena, &range, &oldRange,
+                                 pool);
+}
 
-  res = Method(Arena, arena, pagesMarkAllocated)(arena, chunk, baseIndex, pages, pool);
-  if (res != ResOK)
-    goto failMark;
 
-  arena->freeZones = ZoneSetDiff(arena->freeZones,
-                                 ZoneSetOfRange(arena,
-                                                RangeBase(&range),
-                                                RangeLimit(&range)));
+/* ArenaFreeLandAllocAt -- allocate a contiguous range of tracts of
+ * size bytes at base from the arena's free land.
+ *
+ * If the range is free, mark the allocated tracts as belonging to
+ * pool, set *tractReturn to point to the first tract in the range,
+ * and return ResOK. If any of the range is not free, return ResFAIL.
+ */
 
-  *tractReturn = PageTract(ChunkPage(chunk, baseIndex));
-  return ResOK;
+Res ArenaFreeLandAllocAt(Tract *tractReturn, Arena arena, Addr base,
+                         Size size, Pool pool)
+{
+  RangeStruct range, oldRange;
+  Res res;
+  Land land;
 
-failMark:
-   {
-     Res insertRes = arenaFreeLandInsertExtend(&oldRange, arena, &range);
-     AVER(insertRes == ResOK); /* We only just deleted it. */
-     /* If the insert does fail, we lose some address space permanently. */
-   }
-   return res;
+  AVER(tractReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(AddrIsArenaGrain(base, arena));
+  AVER(size > (Size)0);
+  AVERT(Pool, pool);
+  AVER(arena == PoolArena(pool));
+  AVER(SizeIsArenaGrains(size, arena));
+
+  RangeInitSize(&range, base, size);
+  land = ArenaFreeLand(arena);
+  res = LandDelete(&oldRange, land, &range);
+
+  if (res == ResLIMIT) { /* range is free, but couldn't split block */
+    RangeStruct pageRange;
+    res = arenaExtendCBSBlockPool(&pageRange, arena);
+    if (res != ResOK) /* disastrously short on memory */
+      return res;
+    arenaExcludePage(arena, &pageRange);
+    /* The page might have been taken from range, so this can fail. */
+    res = LandDelete(&oldRange, land, &range);
+    AVER(res != ResLIMIT);
+  }
+
+  if (res != ResOK)
+    return res;
+
+  arenaFreeLandNote(arena, &range, FALSE);
+
+  return arenaFreeLandAllocRange(tractReturn, arena, &range, &oldRange,
+                                 pool);
 }
 
 
@@ -1099,8 +1469,16 @@ Res ArenaAlloc(Addr *baseReturn, LocusPref pref, Size size, Pool pool)
   arena->lastTract = tract;
   arena->lastTractBase = base;
 
+  /* <design/arena#.spare-committed.zeroed> */
+  if (pref->zeroed) {
+    arena->zeroedWanted = TRUE;
+    Method(Arena, arena, zero)(arena, base, size);
+  }
+
   EVENT5(ArenaAlloc, arena, tract, base, size, pool);
 
+  ArenaPressureCheck(arena);
+
   *baseReturn = base;
   return ResOK;
 
@@ -1117,6 +1495,7 @@ void ArenaFree(Addr base, Size size, Pool pool)
   Arena arena;
   RangeStruct range, oldRange;
   Res res;
+  Bool wasSpare;
 
   AVERT(Pool, pool);
   AVER(base != NULL);
@@ -1142,14 +1521,23 @@ void ArenaFree(Addr base, Size size, Pool pool)
     AVER(res == ResOK);
     if (RangeIsEmpty(&range))
       goto done;
+    arenaFreeLandNote(arena, &range, TRUE);
   }
+  wasSpare = arena->spareCommitted > 0;
   Method(Arena, arena, free)(RangeBase(&range), RangeSize(&range), pool);
+  /* Spare memory starts to decay when it appears. */
+  if (!wasSpare && arena->spareCommitted > 0 && arena->spareHalfLife > 0.0)
+    arena->spareDecayClock = ClockNow();
 
 done:
+  arenaSoftLimitPurge(arena);
+
   /* Freeing memory might create spare pages, but not more than this. */
   AVER(arena->spareCommitted <= ArenaSpareCommitLimit(arena));
 
   EVENT4(ArenaFree, arena, base, size, pool);
+
+  ArenaPressureCheck(arena);
 }
 
 
@@ -1195,6 +1583,92 @@ void ArenaSetSpare(Arena arena, double spare)
   }
 }
 
+/* arenaHalfPower -- approximate 2 to the power -x
+ *
+ * Exact at whole numbers of half-lives, and linear in between, which
+ * is close enough for deciding how much memory to purge, and avoids
+ * depending on the C maths library.
+ */
+
+static double arenaHalfPower(double x)
+{
+  double r = 1.0;
+
+  AVER(x >= 0.0);
+  if (x >= (double)MPS_WORD_WIDTH)
+    return 0.0;
+  while (x >= 1.0) {
+    r /= 2.0;
+    x -= 1.0;
+  }
+  return r * (1.0 - x / 2.0);
+}
+
+
+/* ArenaSpareDecay -- return spare memory to the operating system
+ * gradually
+ *
+ * If the arena has a spare half-life, purge spare committed memory
+ * so that it decays exponentially with that half-life. To avoid
+ * lots of small unmappings, nothing is purged until at least a grain
+ * is due, and the time carries over until then.
+ * <design/arena#.spare-committed.decay>.
+ */
+
+void ArenaSpareDecay(Arena arena)
+{
+  Clock now;
+  double halfLives;
+  Size keep;
+
+  AVERT(Arena, arena);
+
+  if (arena->spareHalfLife == 0.0)
+    return;
+  now = ClockNow();
+  if (arena->spareCommitted == 0) {
+    arena->spareDecayClock = now;
+    return;
+  }
+
+  halfLives = (double)(now - arena->spareDecayClock)
+    / (double)ClocksPerSec() / arena->spareHalfLife;
+  keep = (Size)((double)arena->spareCommitted * arenaHalfPower(halfLives));
+  AVER(keep <= arena->spareCommitted);
+  if (arena->spareCommitted - keep < ArenaGrainSize(arena))
+    return;
+
+  (void)Method(Arena, arena, purgeSpare)(arena, arena->spareCommitted - keep);
+  arena->spareDecayClock = now;
+}
+
+/* ArenaZeroSpare -- zero spare memory in advance
+ *
+ * Once the client program has allocated zeroed memory, keep up to
+ * ARENA_ZEROED_RESERVE bytes of the spare committed memory zeroed,
+ * so that zeroed allocations can take it without paying for the
+ * zeroing. At most ARENA_ZEROED_STEP bytes are zeroed per call, to
+ * bound the pause. <design/arena#.spare-committed.zeroed>.
+ */
+
+void ArenaZeroSpare(Arena arena)
+{
+  Size size;
+
+  AVERT(Arena, arena);
+
+  if (!arena->zeroedWanted || arena->spareZeroed >= ARENA_ZEROED_RESERVE)
+    return;
+  if (arena->spareZeroed >= arena->spareCommitted)
+    return;
+
+  size = ARENA_ZEROED_RESERVE - arena->spareZeroed;
+  if (size > ARENA_ZEROED_STEP)
+    size = ARENA_ZEROED_STEP;
+  (void)Method(Arena, arena, zeroSpare)(arena, size);
+  AVER(arena->spareZeroed <= arena->spareCommitted);
+}
+
 double ArenaPauseTime(Arena arena)
 {
   AVERT(Arena, arena);
@@ -1218,6 +1692,24 @@ Size ArenaNoPurgeSpare(Arena arena, Size size)
 }
 
 
+/* Used by arenas which don't know whether their memory contains zeros */
+void ArenaTrivZero(Arena arena, Addr base, Size size)
+{
+  AVERT(Arena, arena);
+  AVER(base != NULL);
+  AVER(size > 0);
+  (void)mps_lib_memset(base, 0, size);
+}
+
+/* Used by arenas which don't keep spare memory zeroed in advance */
+Size ArenaNoZeroSpare(Arena arena, Size size)
+{
+  AVERT(Arena, arena);
+  UNUSED(size);
+  return 0;
+}
+
+
 Res ArenaNoGrow(Arena arena, LocusPref pref, Size size)
 {
   AVERT(Arena, arena);
@@ -1262,6 +1754,93 @@ Res ArenaSetCommitLimit(Arena arena, Size limit)
 }
 
 
+/* arenaSoftLimitPurge -- purge spare memory that exceeds the soft limit
+ *
+ * <design/arena#.soft-limit.purge>
+ */
+
+static void arenaSoftLimitPurge(Arena arena)
+{
+  Size limit = ArenaSoftLimit(arena);
+
+  if (arena->committed > limit && arena->spareCommitted > 0) {
+    Size excess = arena->committed - limit;
+    if (excess > arena->spareCommitted)
+      excess = arena->spareCommitted;
+    (void)Method(Arena, arena, purgeSpare)(arena, excess);
+  }
+}
+
+
+/* ArenaSoftLimit -- return the soft limit
+ *
+ * This is the lesser of the limit set by the client and the limit
+ * derived from the operating system's memory limit.
+ * <design/arena#.soft-limit>.
+ */
+
+Size ArenaSoftLimit(Arena arena)
+{
+  AVERT(Arena, arena);
+  if (arena->osSoftLimit < arena->softLimit)
+    return arena->osSoftLimit;
+  return arena->softLimit;
+}
+
+void ArenaSetSoftLimit(Arena arena, Size limit)
+{
+  AVERT(Arena, arena);
+  /* Can't check limit, as all possible values are allowed. */
+  arena->softLimit = limit;
+  EVENT2(SoftLimitSet, arena, ArenaSoftLimit(arena));
+  arenaSoftLimitPurge(arena);
+}
+
+
+/* arenaReadSoftLimit -- derive soft limit from operating system */
+
+static Res arenaReadSoftLimit(Arena arena)
+{
+  Size limit;
+  Res res;
+
+  AVER(arena->softLimitFraction > 0.0);
+
+  res = MemoryLimit(&limit);
+  if (res != ResOK)
+    return res;
+  if (limit == SizeMAX)
+    arena->osSoftLimit = SizeMAX;
+  else
+    arena->osSoftLimit = (Size)((double)limit * arena->softLimitFraction);
+  return ResOK;
+}
+
+
+/* ArenaRefreshSoftLimit -- update soft limit from operating system
+ *
+ * Does nothing unless the arena was created with a soft limit
+ * fraction. If the operating system's limit can't be found, the soft
+ * limit is unchanged.
+ */
+
+Res ArenaRefreshSoftLimit(Arena arena)
+{
+  Res res;
+
+  AVERT(Arena, arena);
+
+  if (arena->softLimitFraction == 0.0)
+    return ResOK;
+  res = arenaReadSoftLimit(arena);
+  if (res != ResOK)
+    return res;
+  EVENT2(SoftLimitSet, arena, ArenaSoftLimit(arena));
+  arenaSoftLimitPurge(arena);
+  return ResOK;
+}
+
+
 /* ArenaAvail -- return available memory in the arena */
 
 Size ArenaAvail(Arena arena)
@@ -1284,6 +1863,27 @@ Size ArenaAvail(Arena arena)
 }
 
 
+/* ArenaSoftAvail -- return memory available below the soft limit
+ *
+ * This is the same as ArenaAvail, except that it is no more than the
+ * soft limit less the memory in use (which may be zero).
+ */
+
+Size ArenaSoftAvail(Arena arena)
+{
+  Size avail, limit, inUse;
+
+  avail = ArenaAvail(arena);
+  limit = ArenaSoftLimit(arena);
+  inUse = arena->committed - arena->spareCommitted;
+  if (limit <= inUse)
+    return 0;
+  if (limit - inUse < avail)
+    return limit - inUse;
+  return avail;
+}
+
+
 /* ArenaCollectable -- return estimate of collectable memory in arena */
 
 Size ArenaCollectable(Arena arena)
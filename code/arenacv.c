@@ -20,6 +20,7 @@
 #include "mpslib.h"
 #include "mpsavm.h"
 #include "mpsacl.h"
+#include "vm.h"
 
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* malloc */
@@ -402,7 +403,8 @@ static void testAllocAndIterate(Arena arena, Pool pool,
 }
 
 
-static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
+static void testPageTable(ArenaClass klass, Size size, Addr addr,
+                          Bool zoned, Bool freeBTree)
 {
   Arena arena; Pool pool;
   Size pageSize;
@@ -412,6 +414,7 @@ static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_CL_BASE, addr);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_FREE_BTREE, freeBTree);
     die(ArenaCreate(&arena, klass, args), "ArenaCreate");
   } MPS_ARGS_END(args);
 
@@ -438,6 +441,144 @@ static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
 }
 
 
+/* testHugePages -- test a VM arena with huge pages requested
+ *
+ * Check that the arena grain consists of whole huge pages, so that
+ * the arena never splits them, and that segments are aligned to them.
+ */
+
+static void testHugePages(Size size)
+{
+  ArenaClass klass = (ArenaClass)mps_arena_class_vm();
+  Arena arena;
+  Pool pool;
+  Size hugePageSize = HugePageSize();
+  Seg seg;
+  LocusPrefStruct pref;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_HUGE_PAGES, TRUE);
+    die(ArenaCreate(&arena, klass, args), "ArenaCreate");
+  } MPS_ARGS_END(args);
+  printf("Huge page size %lu, grain size %lu.\n",
+         (unsigned long)hugePageSize, (unsigned long)ArenaGrainSize(arena));
+  Insist(ArenaGrainSize(arena) % hugePageSize == 0);
+
+  die(PoolCreate(&pool, arena, PoolClassMVFF(), argsNone), "PoolCreate");
+  LocusPrefInit(&pref);
+  die(SegAlloc(&seg, CLASS(Seg), &pref, ArenaGrainSize(arena), pool,
+               argsNone), "SegAlloc");
+  Insist(AddrIsAligned(SegBase(seg), hugePageSize));
+  die(ArenaDescribe(arena, mps_lib_get_stdout(), 0), "ArenaDescribe");
+  SegFree(seg);
+
+  PoolDestroy(pool);
+  ArenaDestroy(arena);
+}
+
+
+/* testSingleChunk -- test a VM arena that never creates another chunk
+ *
+ * Allocate segments until the arena runs out of address space, and
+ * check that it didn't reserve any more.
+ */
+
+#define singleSegSIZE ((Size)1 << 20)
+
+static void testSingleChunk(Size size)
+{
+  ArenaClass klass = (ArenaClass)mps_arena_class_vm();
+  Arena arena;
+  Pool pool;
+  Size reserved;
+  Seg segs[64];
+  Index i, n;
+  Chunk chunk;
+  LocusPrefStruct pref;
+  Res res = ResOK;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SINGLE_CHUNK, TRUE);
+    die(ArenaCreate(&arena, klass, args), "ArenaCreate");
+  } MPS_ARGS_END(args);
+  reserved = ArenaReserved(arena);
+  Insist(size / singleSegSIZE <= NELEMS(segs));
+
+  die(PoolCreate(&pool, arena, PoolClassMVFF(), argsNone), "PoolCreate");
+  LocusPrefInit(&pref);
+  for (n = 0; n < NELEMS(segs); ++n) {
+    res = SegAlloc(&segs[n], CLASS(Seg), &pref, singleSegSIZE, pool,
+                   argsNone);
+    if (res != ResOK)
+      break;
+    Insist(ChunkOfAddr(&chunk, arena, SegBase(segs[n])));
+    Insist(chunk == arena->primary);
+  }
+  die(res == ResRESOURCE ? ResOK : res, "SegAlloc failed with RESOURCE");
+  Insist(n > 0);
+  Insist(ArenaReserved(arena) == reserved);
+  printf("Allocated %lu segments in a single chunk of %lu bytes.\n",
+         (unsigned long)n, (unsigned long)reserved);
+
+  for (i = 0; i < n; ++i)
+    SegFree(segs[i]);
+  PoolDestroy(pool);
+  ArenaDestroy(arena);
+}
+
+
+/* testFreeBTree -- test a VM arena whose free land is a B-tree
+ *
+ * Allocate single-grain segments and free every other one, so that
+ * the free land holds many separate ranges and its node pool must be
+ * extended several times, then allocate into the holes again.
+ */
+
+#define freeSegCOUNT 2048
+
+static void testFreeBTree(Size size)
+{
+  ArenaClass klass = (ArenaClass)mps_arena_class_vm();
+  Arena arena;
+  Pool pool;
+  static Seg segs[freeSegCOUNT];
+  Size grainSize;
+  Index i;
+  LocusPrefStruct pref;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_FREE_BTREE, TRUE);
+    die(ArenaCreate(&arena, klass, args), "ArenaCreate");
+  } MPS_ARGS_END(args);
+  Insist(arena->freeBTree);
+  grainSize = ArenaGrainSize(arena);
+
+  die(PoolCreate(&pool, arena, PoolClassMVFF(), argsNone), "PoolCreate");
+  LocusPrefInit(&pref);
+  for (i = 0; i < NELEMS(segs); ++i)
+    die(SegAlloc(&segs[i], CLASS(Seg), &pref, grainSize, pool, argsNone),
+        "SegAlloc");
+  for (i = 0; i < NELEMS(segs); i += 2)
+    SegFree(segs[i]);
+  Insist(arena->freeCBSBlockPoolStruct.total
+         > arena->freeCBSBlockPoolStruct.extendBy);
+  printf("Free land B-tree nodes use %lu bytes.\n",
+         (unsigned long)arena->freeCBSBlockPoolStruct.total);
+  for (i = 0; i < NELEMS(segs); i += 2)
+    die(SegAlloc(&segs[i], CLASS(Seg), &pref, grainSize, pool, argsNone),
+        "SegAlloc");
+  AVERT(Arena, arena);
+
+  for (i = 0; i < NELEMS(segs); ++i)
+    SegFree(segs[i]);
+  PoolDestroy(pool);
+  ArenaDestroy(arena);
+}
+
+
 /* testSize -- test arena size overflow
  *
  * Just try allocating larger arenas, doubling the size each time, until
@@ -473,12 +614,21 @@ int main(int argc, char *argv[])
 
   testlib_init(argc, argv);
 
-  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0, TRUE);
-  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0,
+                TRUE, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0,
+                FALSE, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0,
+                TRUE, TRUE);
 
   block = malloc(TEST_ARENA_SIZE);
   cdie(block != NULL, "malloc");
-  testPageTable((ArenaClass)mps_arena_class_cl(), TEST_ARENA_SIZE, block, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_cl(), TEST_ARENA_SIZE, block,
+                FALSE, FALSE);
+
+  testHugePages(TEST_ARENA_SIZE);
+  testSingleChunk(TEST_ARENA_SIZE);
+  testFreeBTree(TEST_ARENA_SIZE);
 
   testSize(TEST_ARENA_SIZE);
 
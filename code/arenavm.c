@@ -45,6 +45,7 @@ typedef struct VMChunkStruct {
   VMStruct vmStruct;            /* virtual memory descriptor */
   Addr overheadMappedLimit;     /* limit of pages mapped for overhead */
   SparseArrayStruct pages;      /* to manage backing store of page table */
+  BT zeroTable;                 /* pages known to contain zeros */
   Sig sig;                      /* design.mps.sig.field.end.outer */
 } VMChunkStruct;
 
@@ -74,6 +75,7 @@ typedef struct VMArenaStruct {  /* VM arena structure */
   char vmParams[VMParamSize];   /* VM parameter block */
   Size extendBy;                /* desired arena increment */
   Size extendMin;               /* minimum arena increment */
+  Bool singleChunk;             /* never create another chunk? */
   ArenaVMExtendedCallback extended;
   ArenaVMContractedCallback contracted;
   MFSStruct cbsBlockPoolStruct; /* stores blocks for CBSs */
@@ -118,6 +120,9 @@ static Bool VMChunkCheck(VMChunk vmchunk)
   CHECKL(chunk->base < (Addr)vmchunk->pages.pages);
   CHECKL(AddrAdd(vmchunk->pages.pages, BTSize(chunk->pageTablePages)) <=
          vmchunk->overheadMappedLimit);
+  CHECKL(chunk->base < (Addr)vmchunk->zeroTable);
+  CHECKL(AddrAdd(vmchunk->zeroTable, BTSize(chunk->pages)) <=
+         vmchunk->overheadMappedLimit);
   /* .improve.check-table: Could check the consistency of the tables. */
 
   return TRUE;
@@ -170,6 +175,7 @@ static Bool VMArenaCheck(VMArena vmArena)
 
   CHECKL(vmArena->extendBy > 0);
   CHECKL(vmArena->extendMin <= vmArena->extendBy);
+  CHECKL(BoolCheck(vmArena->singleChunk));
 
   if (arena->primary != NULL) {
     primary = Chunk2VMChunk(arena->primary);
@@ -189,6 +195,37 @@ static Bool VMArenaCheck(VMArena vmArena)
 }
 
 
+/* vmArenaDescribeHugePages -- describe huge page coverage
+ *
+ * Reports how much of the committed memory the operating system was
+ * asked to back with huge pages. Whether it actually did so is up to
+ * the operating system. See <design/vm#.impl.ix.huge>.
+ */
+
+static Res vmArenaDescribeHugePages(VMArena vmArena, mps_lib_FILE *stream,
+                                    Count depth)
+{
+  Arena arena = MustBeA(AbstractArena, vmArena);
+  Size huge = 0;
+  Ring node, next;
+
+  if (VMHugePages(VMArenaVM(vmArena)))
+    huge += VMMapped(VMArenaVM(vmArena));
+  RING_FOR(node, &arena->chunkRing, next) {
+    Chunk chunk = RING_ELT(Chunk, arenaRing, node);
+    VM vm = VMChunkVM(Chunk2VMChunk(chunk));
+    if (VMHugePages(vm))
+      huge += VMMapped(vm);
+  }
+
+  return WriteF(stream, depth,
+                "hugePageSize: $W\n", (WriteFW)HugePageSize(),
+                "hugePageCommitted: $U of $U\n",
+                (WriteFU)huge, (WriteFU)arena->committed,
+                NULL);
+}
+
+
 /* VMArenaDescribe -- describe the VMArena
  */
 static Res VMArenaDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
@@ -209,10 +246,15 @@ static Res VMArenaDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   res = WriteF(stream, depth + 2,
                "extendBy: $U\n", (WriteFU)vmArena->extendBy,
                "extendMin: $U\n", (WriteFU)vmArena->extendMin,
+               "singleChunk: $S\n", WriteFYesNo(vmArena->singleChunk),
                NULL);
   if(res != ResOK)
     return res;
 
+  res = vmArenaDescribeHugePages(vmArena, stream, depth + 2);
+  if (res != ResOK)
+    return res;
+
   res = LandDescribe(VMArenaSpareLand(vmArena), stream, depth + 2);
   if (res != ResOK)
     return res;
@@ -284,6 +326,7 @@ static void chunkUnmapRange(Chunk chunk, Addr base, Addr limit)
 
   for (i = basePI; i < limitPI; ++i)
     PageInit(chunk, i);
+  BTResRange(vmChunk->zeroTable, basePI, limitPI);
   vmArenaUnmap(vmArena, VMChunkVM(vmChunk), base, limit);
   pageDescUnmap(vmChunk, basePI, limitPI);
 }
@@ -368,7 +411,7 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
   Addr overheadLimit;
   void *p;
   Res res;
-  BT saMapped, saPages;
+  BT saMapped, saPages, zeroTable;
 
   /* chunk is supposed to be uninitialized, so don't check it. */
   vmChunk = Chunk2VMChunk(chunk);
@@ -386,6 +429,13 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
     goto failSaPages;
   saPages = p;
 
+  /* .overhead.zero-table: Chunk overhead for the table of pages known
+     to contain zeros. <design/arena#.spare-committed.zeroed> */
+  res = BootAlloc(&p, boot, BTSize(chunk->pages), MPS_PF_ALIGN);
+  if (res != ResOK)
+    goto failZeroTable;
+  zeroTable = p;
+
   overheadLimit = AddrAdd(chunk->base, (Size)BootAllocated(boot));
 
   /* .overhead.page-table: Put the page table as late as possible, as
@@ -410,11 +460,14 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
                   sizeof(PageUnion),
                   chunk->pages,
                   saMapped, saPages, VMChunkVM(vmChunk));
+  vmChunk->zeroTable = zeroTable;
+  BTResRange(zeroTable, 0, chunk->pages);
 
   return ResOK;
 
   /* .no-clean: No clean-ups needed for boot, as we will discard the chunk. */
 failTableMap:
+failZeroTable:
 failSaPages:
 failAllocPageTable:
 failSaMapped:
@@ -562,6 +615,9 @@ static Res vmArenaChunkSize(Size *chunkSizeReturn, VMArena vmArena, Size size)
     pageTablePages = pageTableSize >> grainShift;
     overhead += SizeAlignUp(BTSize(pageTablePages), MPS_PF_ALIGN);
 
+    /* See .overhead.zero-table. */
+    overhead += SizeAlignUp(BTSize(pages), MPS_PF_ALIGN);
+
     /* See .overhead.page-table. */
     overhead = SizeAlignUp(overhead, grainSize);
     overhead += SizeAlignUp(pageTableSize, grainSize);
@@ -589,6 +645,7 @@ ARG_DEFINE_KEY(arena_contracted, Fun);
 static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
 {
   Size size = VM_ARENA_SIZE_DEFAULT; /* initial arena size */
+  Bool singleChunk = FALSE; /* reserve all address space up front? */
   Align grainSize = MPS_PF_ALIGN; /* arena grain size */
   Size pageSize = PageSize(); /* operating system page size */
   Size chunkSize; /* size actually created */
@@ -610,14 +667,13 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   if (grainSize < pageSize)
     /* Make it easier to write portable programs by rounding up. */
     grainSize = pageSize;
-  AVERT(ArenaGrainSize, grainSize);
 
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_SINGLE_CHUNK))
+    singleChunk = arg.val.b;
+  if (singleChunk)
+    size = VM_ARENA_SINGLE_CHUNK_SIZE_DEFAULT;
   if (ArgPick(&arg, args, MPS_KEY_ARENA_SIZE))
     size = arg.val.size;
-  if (size < grainSize * MPS_WORD_WIDTH)
-    /* There has to be enough room in the chunk for a full complement of
-       zones. Make it easier to write portable programs by rounding up. */
-    size = grainSize * MPS_WORD_WIDTH;
 
   /* Parse remaining arguments, if any, into VM parameters. We must do
      this into some stack-allocated memory for the moment, since we
@@ -626,6 +682,17 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   if (res != ResOK)
     goto failVMInit;
 
+  if (grainSize < VMParamHugePageSize(vmParams))
+    /* Grains must consist of whole huge pages so that the arena never
+       splits them. See <design/vm#.impl.ix.huge.grain>. */
+    grainSize = VMParamHugePageSize(vmParams);
+  AVERT(ArenaGrainSize, grainSize);
+
+  if (size < grainSize * MPS_WORD_WIDTH)
+    /* There has to be enough room in the chunk for a full complement of
+       zones. Make it easier to write portable programs by rounding up. */
+    size = grainSize * MPS_WORD_WIDTH;
+
   /* Create a VM to hold the arena and map it. Store descriptor on the
      stack until we have the arena to put it in. */
   vmArenaSize = SizeAlignUp(sizeof(VMArenaStruct), MPS_PF_ALIGN);
@@ -685,6 +752,7 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   /* <design/arena#.coop-vm.struct.vmarena.extendby.init> */
   vmArena->extendBy = size;
   vmArena->extendMin = 0;
+  vmArena->singleChunk = singleChunk;
 
   vmArena->extended = vmArenaTrivExtended;
   if (ArgPick(&arg, args, vmKeyArenaExtended))
@@ -834,6 +902,12 @@ static Res VMArenaGrow(Arena arena, LocusPref pref, Size size)
     return res;
   chunkSize = vmArena->extendBy;
 
+  /* <design/arena#.chunk.single> */
+  if (vmArena->singleChunk) {
+    EVENT2(VMArenaExtendFail, chunkMin, ArenaReserved(arena));
+    return ResRESOURCE;
+  }
+
   EVENT3(VMArenaExtendStart, size, chunkSize, ArenaReserved(arena));
 
   /* .chunk-create.fail: If we fail, try again with a smaller size */
@@ -884,6 +958,28 @@ vmArenaGrow_Done:
  * either allocate the memory or unmap it.
  */
 
+/* spareZeroedRelease -- account for zeroed pages leaving the spare land
+ *
+ * Leaves the pages' bits in the zero table set, so that VMZero can
+ * find out which of them it need not zero.
+ * <design/arena#.spare-committed.zeroed>
+ */
+
+static void spareZeroedRelease(VMChunk vmChunk, Index piBase, Index piLimit)
+{
+  Chunk chunk = VMChunk2Chunk(vmChunk);
+  Arena arena = ChunkArena(chunk);
+  Count zeroed;
+  Size size;
+
+  AVER(piBase < piLimit);
+  zeroed = (piLimit - piBase)
+    - BTCountResRange(vmChunk->zeroTable, piBase, piLimit);
+  size = ChunkPagesToSize(chunk, zeroed);
+  AVER(arena->spareZeroed >= size);
+  arena->spareZeroed -= size;
+}
+
 static void spareRangeRelease(VMChunk vmChunk, Index piBase, Index piLimit)
 {
   Chunk chunk = VMChunk2Chunk(vmChunk);
@@ -914,6 +1010,7 @@ static void spareRangeRelease(VMChunk vmChunk, Index piBase, Index piLimit)
     AVER(res == ResOK);
     AVER(arena->spareCommitted >= RangeSize(&extendRange));
     arena->spareCommitted -= RangeSize(&extendRange);
+    spareZeroedRelease(vmChunk, extendBasePI, extendBasePI + 1);
     PageAlloc(chunk, extendBasePI, VMArenaCBSBlockPool(vmArena));
     MFSExtend(VMArenaCBSBlockPool(vmArena), extendBase, extendLimit);
     res = LandDelete(&containingRange, spareLand, &range);
@@ -921,6 +1018,7 @@ static void spareRangeRelease(VMChunk vmChunk, Index piBase, Index piLimit)
   }
   AVER(arena->spareCommitted >= RangeSize(&range));
   arena->spareCommitted -= RangeSize(&range);
+  spareZeroedRelease(vmChunk, piBase, piLimit);
 }
 
 
@@ -983,6 +1081,8 @@ static Res pagesMarkAllocated(VMArena vmArena, VMChunk vmChunk,
       PageInit(chunk, i);
       PageAlloc(chunk, i, pool);
     }
+    if (VMMapZeroes(VMChunkVM(vmChunk)))
+      BTSetRange(vmChunk->zeroTable, j, k);
     cursor = k;
     if (cursor == limitPI)
       return ResOK;
@@ -1052,11 +1152,123 @@ static Bool VMChunkPageMapped(Chunk chunk, Index index)
 }
 
 
+/* VMZero -- make newly allocated memory contain zeros
+ *
+ * Only the pages that aren't known to contain zeros need to be
+ * zeroed. <design/arena#.spare-committed.zeroed>
+ */
+
+static void VMZero(Arena arena, Addr base, Size size)
+{
+  Chunk chunk = NULL;           /* suppress "may be used uninitialized" */
+  VMChunk vmChunk;
+  Index pi, piBase, piLimit, zeroBase, zeroLimit;
+  Bool foundChunk;
+
+  AVERT(Arena, arena);
+  AVER(base != NULL);
+  AVER(size > 0);
+
+  foundChunk = ChunkOfAddr(&chunk, arena, base);
+  AVER(foundChunk);
+  vmChunk = Chunk2VMChunk(chunk);
+  piBase = INDEX_OF_ADDR(chunk, base);
+  piLimit = piBase + ChunkSizeToPages(chunk, size);
+  AVER(piLimit <= chunk->pages);
+
+  pi = piBase;
+  while (BTFindLongResRange(&zeroBase, &zeroLimit, vmChunk->zeroTable,
+                            pi, piLimit, 1)) {
+    (void)mps_lib_memset(PageIndexBase(chunk, zeroBase), 0,
+                         ChunkPagesToSize(chunk, zeroLimit - zeroBase));
+    pi = zeroLimit;
+    if (pi == piLimit)
+      break;
+  }
+}
+
+
+/* VMZeroSpare -- zero spare memory in advance
+ *
+ * Visit the spare memory land, zeroing pages that aren't known to
+ * contain zeros until size bytes have been zeroed. Returns the amount
+ * zeroed. <design/arena#.spare-committed.zeroed>
+ */
+
+typedef struct VMZeroSpareClosureStruct {
+  Arena arena;           /* arena owning the spare memory */
+  Size size;             /* desired amount of spare memory to zero */
+  Size zeroed;           /* actual amount zeroed */
+} VMZeroSpareClosureStruct, *VMZeroSpareClosure;
+
+static Bool vmZeroSpareRange(Land land, Range range, void *p)
+{
+  VMZeroSpareClosure closure = p;
+  Arena arena;
+  Chunk chunk = NULL;       /* suppress "may be used uninitialized" */
+  VMChunk vmChunk;
+  Index pi, piLimit, zeroBase, zeroLimit;
+  Bool foundChunk;
+
+  AVERT(Land, land);
+  AVERT(Range, range);
+  AVER(p != NULL);
+
+  arena = closure->arena;
+  foundChunk = ChunkOfAddr(&chunk, arena, RangeBase(range));
+  AVER(foundChunk);
+  vmChunk = Chunk2VMChunk(chunk);
+  pi = INDEX_OF_ADDR(chunk, RangeBase(range));
+  piLimit = INDEX_OF_ADDR(chunk, RangeLimit(range));
+
+  while (closure->zeroed < closure->size
+         && BTFindLongResRange(&zeroBase, &zeroLimit, vmChunk->zeroTable,
+                               pi, piLimit, 1))
+  {
+    Size size;
+    Count want = ChunkSizeToPages(chunk, SizeAlignUp(closure->size
+                                                     - closure->zeroed,
+                                                     ChunkPageSize(chunk)));
+    if (zeroLimit - zeroBase > want)
+      zeroLimit = zeroBase + want;
+    size = ChunkPagesToSize(chunk, zeroLimit - zeroBase);
+    (void)mps_lib_memset(PageIndexBase(chunk, zeroBase), 0, size);
+    BTSetRange(vmChunk->zeroTable, zeroBase, zeroLimit);
+    arena->spareZeroed += size;
+    closure->zeroed += size;
+    pi = zeroLimit;
+    if (pi == piLimit)
+      break;
+  }
+
+  return closure->zeroed < closure->size;
+}
+
+static Size VMZeroSpare(Arena arena, Size size)
+{
+  VMArena vmArena = MustBeA(VMArena, arena);
+  Land spareLand = VMArenaSpareLand(vmArena);
+  VMZeroSpareClosureStruct closure;
+
+  closure.arena = arena;
+  closure.size = size;
+  closure.zeroed = 0;
+  (void)LandIterate(spareLand, vmZeroSpareRange, &closure);
+  AVER(arena->spareZeroed <= arena->spareCommitted);
+
+  return closure.zeroed;
+}
+
+
 /* vmArenaUnmapSpare -- unmap spare memory
  *
  * The size is the desired amount to unmap, and the amount that was
  * unmapped is returned. If filter is not NULL, then only memory
  * within that chunk is unmapped.
+ *
+ * If the last range visited is bigger than needed, only the top of
+ * it is unmapped, so that spare memory can be returned a little at a
+ * time. <design/arena#.spare-committed.decay>.
  */
 
 typedef struct VMArenaUnmapSpareClosureStruct {
@@ -1064,6 +1276,7 @@ typedef struct VMArenaUnmapSpareClosureStruct {
   Size size;             /* desired amount of spare memory to unmap */
   Chunk filter;          /* NULL or chunk to unmap from */
   Size unmapped;         /* actual amount unmapped */
+  RangeStruct part;      /* part of a range still to unmap */
 } VMArenaUnmapSpareClosureStruct, *VMArenaUnmapSpareClosure;
 
 static Bool vmArenaUnmapSpareRange(Bool *deleteReturn, Land land, Range range,
@@ -1085,6 +1298,19 @@ static Bool vmArenaUnmapSpareRange(Bool *deleteReturn, Land land, Range range,
 
   if (closure->filter == NULL || closure->filter == chunk) {
     Size size = RangeSize(range);
+    Size remaining = closure->size - closure->unmapped;
+    if (remaining < size) {
+      Size want = SizeArenaGrains(remaining, arena);
+      if (want < size) {
+        /* Can't delete part of the range while iterating. */
+        RangeInit(&closure->part, AddrSub(RangeLimit(range), want),
+                  RangeLimit(range));
+        return FALSE;
+      }
+    }
+    spareZeroedRelease(Chunk2VMChunk(chunk),
+                       INDEX_OF_ADDR(chunk, RangeBase(range)),
+                       INDEX_OF_ADDR(chunk, RangeLimit(range)));
     chunkUnmapRange(chunk, RangeBase(range), RangeLimit(range));
     AVER(arena->spareCommitted >= size);
     arena->spareCommitted -= size;
@@ -1108,8 +1334,29 @@ static Size vmArenaUnmapSpare(Arena arena, Size size, Chunk filter)
   closure.size = size;
   closure.filter = filter;
   closure.unmapped = 0;
+  RangeInit(&closure.part, (Addr)0, (Addr)0);
   (void)LandIterateAndDelete(spareLand, vmArenaUnmapSpareRange, &closure);
 
+  if (!RangeIsEmpty(&closure.part)) {
+    RangeStruct oldRange;
+    Chunk chunk = NULL;     /* suppress "may be used uninitialized" */
+    Bool foundChunk;
+    Res res;
+    /* Deleting the top of a range never needs a new block. */
+    res = LandDelete(&oldRange, spareLand, &closure.part);
+    AVER(res == ResOK);
+    foundChunk = ChunkOfAddr(&chunk, arena, RangeBase(&closure.part));
+    AVER(foundChunk);
+    spareZeroedRelease(Chunk2VMChunk(chunk),
+                       INDEX_OF_ADDR(chunk, RangeBase(&closure.part)),
+                       INDEX_OF_ADDR(chunk, RangeLimit(&closure.part)));
+    chunkUnmapRange(chunk, RangeBase(&closure.part),
+                    RangeLimit(&closure.part));
+    AVER(arena->spareCommitted >= RangeSize(&closure.part));
+    arena->spareCommitted -= RangeSize(&closure.part);
+    closure.unmapped += RangeSize(&closure.part);
+  }
+
   AVER(LandSize(spareLand) == arena->spareCommitted);
 
   return closure.unmapped;
@@ -1166,6 +1413,8 @@ static void VMFree(Addr base, Size size, Pool pool)
     TractFinish(tract);
   }
   BTResRange(chunk->allocTable, piBase, piLimit);
+  /* The pool may have written anything there. */
+  BTResRange(Chunk2VMChunk(chunk)->zeroTable, piBase, piLimit);
 
   /* Freed range is now spare memory, so add it to spare memory land. */
   RangeInitSize(&range, base, size);
@@ -1208,12 +1457,13 @@ static void VMFree(Addr base, Size size, Pool pool)
     /* Purge at least half of the spare memory, not just the extra
        sliver, so that we return a reasonable amount of memory in one
        go, and avoid lots of small unmappings, each of which has an
-       overhead. */
-    /* TODO: Consider making this time-based. */
+       overhead. But if the spare memory decays over time, leave the
+       rest to ArenaSpareDecay. See
+       <design/arena#.spare-committed.decay>. */
     /* TODO: Consider making this smarter about the overheads tradeoff. */
     Size minPurge = ArenaSpareCommitted(arena) / 2;
     Size newSpareCommitted;
-    if (toPurge < minPurge)
+    if (toPurge < minPurge && arena->spareHalfLife == 0.0)
       toPurge = minPurge;
     VMPurgeSpare(arena, toPurge);
     newSpareCommitted = ArenaSpareCommitted(arena);
@@ -1318,6 +1568,8 @@ DEFINE_CLASS(Arena, VMArena, klass)
   klass->compact = VMCompact;
   klass->pagesMarkAllocated = VMPagesMarkAllocated;
   klass->chunkPageMapped = VMChunkPageMapped;
+  klass->zero = VMZero;
+  klass->zeroSpare = VMZeroSpare;
   AVERT(ArenaClass, klass);
 }
 
@@ -180,6 +180,9 @@ typedef struct tables_s {
   mps_word_t *preserve[TABLE_SLOTS];    /* preserves objects in the weak */
                                         /* table by referring to them */
   mps_ap_t weakap, exactap, bogusap, leafap;
+  mps_pool_t tablepool;
+  size_t splats;                        /* splatted slots visited */
+  size_t touched;                       /* weak slots read by touch */
 } tables_s, *tables_t;
 
 
@@ -224,10 +227,65 @@ static void *populate(void *state)
   return NULL;
 }
 
-static void test(mps_arena_t arena,
+/* touch -- read the weak table during a collection, in a thread
+ *
+ * Reading the table while it is being traced hits the read barrier,
+ * so some of its references are fixed by the barrier handler rather
+ * than by a scan started by the collector, and their splats must be
+ * recorded all the same. <design/poolawl#.awlseg.splatted.single>.
+ * The thread has no root, so the references it reads don't keep
+ * their objects alive.
+ */
+
+static void *touch(void *state)
+{
+  tables_t tables = state;
+  mps_message_t message;
+  mps_thr_t me;
+  size_t i;
+
+  die(mps_thread_reg(&me, tables->arena), "mps_thread_reg(touch)");
+
+  mps_message_type_enable(tables->arena, mps_message_type_gc());
+  die(mps_arena_start_collect(tables->arena), "mps_arena_start_collect");
+  do {
+    for(i = 0; i < TABLE_SLOTS; ++i)
+      if (table_slot(tables->weaktable, i) != NULL)
+        ++ tables->touched;
+    (void)mps_arena_step(tables->arena, 0.0, 0.0);
+  } while (!mps_message_get(&message, tables->arena, mps_message_type_gc()));
+  mps_message_discard(tables->arena, message);
+  mps_message_type_disable(tables->arena, mps_message_type_gc());
+
+  mps_thread_dereg(me);
+
+  return NULL;
+}
+
+
+/* splat_visit -- check a splatted slot reported by mps_awl_splats_walk */
+
+static void splat_visit(mps_addr_t obj, mps_addr_t *slot, void *closure)
+{
+  tables_t tables = closure;
+  size_t i;
+
+  cdie(obj == tables->weaktable, "splat in weak table");
+  cdie((mps_word_t *)slot >= tables->weaktable + 3
+       && (mps_word_t *)slot < tables->weaktable + 3 + TABLE_SLOTS,
+       "splat in variable part");
+  i = (size_t)((mps_word_t *)slot - (tables->weaktable + 3));
+  cdie(*slot == NULL, "splatted slot is NULL");
+  cdie(tables->preserve[i] == 0, "splatted slot was dead");
+  ++ tables->splats;
+}
+
+
+static void test(mps_arena_t arena, mps_pool_t tablepool,
                  mps_ap_t leafap, mps_ap_t exactap, mps_ap_t weakap,
                  mps_ap_t bogusap)
 {
+  size_t dead;
   tables_s tables;
   size_t i, j;
   testthr_t thr;
@@ -241,6 +299,9 @@ static void test(mps_arena_t arena,
   tables.weakap = weakap;
   tables.leafap = leafap;
   tables.bogusap = bogusap;
+  tables.tablepool = tablepool;
+  tables.splats = 0;
+  tables.touched = 0;
 
   /* We using a thread for its pararallel execution, so just create
      and wait for it to finish. */
@@ -253,11 +314,18 @@ static void test(mps_arena_t arena,
     }
   }
 
+  testthr_create(&thr, touch, &tables);
+  testthr_join(&thr, NULL);
+  Insist(tables.touched > 0);
+
   die(mps_arena_collect(arena), "mps_arena_collect");
   mps_arena_release(arena);
 
+  mps_awl_splats_walk(tablepool, splat_visit, &tables);
+  dead = 0;
   for(i = 0; i < TABLE_SLOTS; ++i) {
     if (tables.preserve[i] == 0) {
+      ++ dead;
       if (table_slot(tables.weaktable, i)) {
         error("Strongly unreachable weak table entry found, "
               "slot %"PRIuLONGEST".\n", (ulongest_t)i);
@@ -271,6 +339,13 @@ static void test(mps_arena_t arena,
     }
   }
 
+  Insist(tables.splats == dead);
+
+  /* Splats are forgotten once visited. */
+  tables.splats = 0;
+  mps_awl_splats_walk(tablepool, splat_visit, &tables);
+  Insist(tables.splats == 0);
+
   (void)mps_commit(bogusap, p, 64);
 }
 
@@ -314,9 +389,13 @@ static void setup(struct guff_s *guff)
     die(mps_pool_create_k(&leafpool, arena, mps_class_lo(), args),
         "Leaf Pool Create\n");
   } MPS_ARGS_END(args);
-  die(mps_pool_create(&tablepool, arena, mps_class_awl(), dylanweakfmt,
-                      dylan_weak_dependent),
-      "Table Pool Create\n");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, dylanweakfmt);
+    MPS_ARGS_ADD(args, MPS_KEY_AWL_FIND_DEPENDENT, dylan_weak_dependent);
+    MPS_ARGS_ADD(args, MPS_KEY_AWL_RECORD_SPLATS, TRUE);
+    die(mps_pool_create_k(&tablepool, arena, mps_class_awl(), args),
+        "Table Pool Create\n");
+  } MPS_ARGS_END(args);
   die(mps_ap_create(&leafap, leafpool, mps_rank_exact()),
       "Leaf AP Create\n");
   die(mps_ap_create(&exactap, tablepool, mps_rank_exact()),
@@ -326,7 +405,7 @@ static void setup(struct guff_s *guff)
   die(mps_ap_create(&bogusap, tablepool, mps_rank_exact()),
       "Bogus AP Create\n");
 
-  test(arena, leafap, exactap, weakap, bogusap);
+  test(arena, tablepool, leafap, exactap, weakap, bogusap);
 
   mps_ap_destroy(bogusap);
   mps_ap_destroy(weakap);
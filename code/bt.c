@@ -839,6 +839,42 @@ Bool BTFindLongResRangeHigh(Index *baseReturn, Index *limitReturn,
 }
 
 
+/* BTFindFirstSet -- find the lowest set bit in a range
+ *
+ * <design/bt#.if.find-first-set>.
+ */
+
+Bool BTFindFirstSet(Index *indexReturn, BT bt, Index base, Index limit)
+{
+  Bool found;
+
+  AVER(indexReturn != NULL);
+  AVERT(BT, bt);
+  AVER(base < limit);
+
+  BTFindSet(&found, indexReturn, bt, base, limit);
+  return found;
+}
+
+
+/* BTFindLastSet -- find the highest set bit in a range
+ *
+ * <design/bt#.if.find-last-set>.
+ */
+
+Bool BTFindLastSet(Index *indexReturn, BT bt, Index base, Index limit)
+{
+  Bool found;
+
+  AVER(indexReturn != NULL);
+  AVERT(BT, bt);
+  AVER(base < limit);
+
+  BTFindSetHigh(&found, indexReturn, bt, base, limit);
+  return found;
+}
+
+
 /* BTFindShortResRange -- find short range of reset bits in a bit table
  *
  * <design/bt#.fun.find-short-res-range>.
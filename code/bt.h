@@ -61,6 +61,11 @@ extern Bool BTFindLongResRangeHigh(Index *baseReturn, Index *limitReturn,
                                    BT bt, Index searchBase, Index searchLimit,
                                    Count length);
 
+extern Bool BTFindFirstSet(Index *indexReturn, BT bt,
+                           Index base, Index limit);
+extern Bool BTFindLastSet(Index *indexReturn, BT bt,
+                          Index base, Index limit);
+
 extern Bool BTRangesSame(BT BTx, BT BTy, Index base, Index limit);
 
 extern void BTCopyInvertRange(BT fromBT, BT toBT, Index base, Index limit);
@@ -5,8 +5,9 @@
  *
  * .readership: MPS developers
  *
- * .coverage: Direct coverage of BTFind*ResRange*, BTRangesSame,
- * BTISResRange, BTIsSetRange, BTCopyRange, BTCopyOffsetRange.
+ * .coverage: Direct coverage of BTFind*ResRange*, BTFindFirstSet,
+ * BTFindLastSet, BTRangesSame, BTISResRange, BTIsSetRange,
+ * BTCopyRange, BTCopyOffsetRange.
  * Reasonable coverage of BTCopyInvertRange, BTResRange,
  * BTSetRange, BTRes, BTSet, BTCreate, BTDestroy.
  */
@@ -443,6 +444,53 @@ static void btIsRangeTests(BT bt1, BT bt2, Count btSize,
 }
 
 
+/* btFindSetTests -- Test BTFindFirstSet & BTFindLastSet
+ *
+ * Test finding set bits in ranges which are all reset apart from
+ * single bits near to the base and limit (both inside and outside
+ * the range).
+ */
+
+static void btFindSetTests(BT bt, Count btSize, Index base, Index limit)
+{
+  Index minBase, maxLimit, b, l, i;
+
+  minBase = base > 0 ? base - 1 : 0;
+  maxLimit = limit < btSize ? limit + 1 : btSize;
+
+  BTResRange(bt, 0, btSize);
+  cdie(!BTFindFirstSet(&i, bt, base, limit), "BTFindFirstSet empty");
+  cdie(!BTFindLastSet(&i, bt, base, limit), "BTFindLastSet empty");
+
+  for (b = minBase; b <= base+1; b++) {
+    for (l = maxLimit; l >= limit-1; l--) {
+      Bool found;
+      BTResRange(bt, 0, btSize);
+      BTSet(bt, b);
+      BTSet(bt, l - 1);
+
+      found = BTFindFirstSet(&i, bt, base, limit);
+      if (b >= base) {
+        cdie(found && i == b, "BTFindFirstSet low");
+      } else if (l - 1 < limit) {
+        cdie(found && i == l - 1, "BTFindFirstSet high");
+      } else {
+        cdie(!found, "BTFindFirstSet outside");
+      }
+
+      found = BTFindLastSet(&i, bt, base, limit);
+      if (l - 1 < limit) {
+        cdie(found && i == l - 1, "BTFindLastSet high");
+      } else if (b >= base) {
+        cdie(found && i == b, "BTFindLastSet low");
+      } else {
+        cdie(!found, "BTFindLastSet outside");
+      }
+    }
+  }
+}
+
+
 /* btCopyTests -- Test BTCopyRange & BTCopyOffsetRange
  *
  * Test copying ranges which are all reset or set apart from
@@ -523,6 +571,9 @@ static void btTests(BT btlo, BT bthi, Count btSize)
       /* Perform Copy*Range tests over those subranges */
       btCopyTests(btlo, bthi, btSize, base, limit);
 
+      /* Perform FindFirstSet and FindLastSet tests */
+      btFindSetTests(btlo, btSize, base, limit);
+
       /* Perform FindResRange tests with different lengths */
       btFindRangeTests(btlo, bthi, btSize, base, limit, 1);
       btFindRangeTests(btlo, bthi, btSize, base, limit, 2);
@@ -0,0 +1,1382 @@
+/* btree.c: B-TREE LAND IMPLEMENTATION
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .intro: This is a portable implementation of a Land that keeps its
+ * ranges in a B-tree with small fixed-size nodes.
+ *
+ * .purpose: Like CBS <code/cbs.c>, the B-tree manages potentially
+ * unbounded collections of memory blocks, but searches do not
+ * restructure the tree, and each node holds several ranges, so a
+ * search touches fewer cache lines.
+ *
+ * .sources: <design/btree>.
+ */
+
+#include "btree.h"
+#include "range.h"
+#include "poolmfs.h"
+#include "mpm.h"
+
+SRCID(btree, "$Id$");
+
+
+#define btreeNodePool(btree) RVALUE((btree)->nodePool)
+
+/* btreeMIN -- minimum number of entries in a node other than the root */
+#define btreeMIN (BTREE_FANOUT / 2)
+
+/* btreeHEIGHT_MAX -- bound on the height of the tree
+ *
+ * Every node other than the root has at least two children, and the
+ * ranges are disjoint, so the height is less than the number of bits
+ * in an address.
+ */
+#define btreeHEIGHT_MAX ((Count)MPS_WORD_WIDTH)
+
+
+/* BTreeEntryStruct -- one entry of a node, for moving entries around */
+
+typedef struct BTreeEntryStruct {
+  Addr base;
+  Addr limit;
+  Size maxSize;
+  ZoneSet zones;
+  BTreeNode child;
+} BTreeEntryStruct, *BTreeEntry;
+
+
+/* BTreeReserveStruct -- nodes allocated in advance of an insertion
+ *
+ * <design/btree#.insert.reserve>.
+ */
+
+typedef struct BTreeReserveStruct {
+  Count count;
+  BTreeNode node[btreeHEIGHT_MAX + 1];
+} BTreeReserveStruct, *BTreeReserve;
+
+
+/* BTreeCheck -- check B-tree */
+
+Bool BTreeCheck(BTree btree)
+{
+  Land land;
+  CHECKS(BTree, btree);
+  land = BTreeLand(btree);
+  CHECKD(Land, land);
+  CHECKD(Pool, btree->nodePool);
+  CHECKL(BoolCheck(btree->ownPool));
+  CHECKL(BoolCheck(btree->zoned));
+  CHECKL(SizeIsAligned(btree->size, LandAlignment(land)));
+  CHECKL((btree->root == NULL) == (btree->ranges == 0));
+  CHECKL((btree->size == 0) == (btree->ranges == 0));
+  CHECKL(btree->root == NULL || btree->root->height == btree->height);
+  CHECKL(btree->height < btreeHEIGHT_MAX);
+  CHECKL(btree->nodes >= btree->height + (btree->root != NULL));
+  /* Nodes are not checked: that would make every check linear in the
+     size of the tree. */
+  return TRUE;
+}
+
+
+/* Entry operators
+ *
+ * Entries are stored in parallel arrays, so these copy each field
+ * separately.
+ */
+
+static void btreeEntryGet(BTreeEntry entryReturn, BTreeNode node, Index i)
+{
+  entryReturn->base = node->base[i];
+  entryReturn->limit = node->limit[i];
+  entryReturn->maxSize = node->maxSize[i];
+  entryReturn->zones = node->zones[i];
+  entryReturn->child = node->child[i];
+}
+
+static void btreeEntrySet(BTreeNode node, Index i, BTreeEntry entry)
+{
+  node->base[i] = entry->base;
+  node->limit[i] = entry->limit;
+  node->maxSize[i] = entry->maxSize;
+  node->zones[i] = entry->zones;
+  node->child[i] = entry->child;
+}
+
+static void btreeEntryMove(BTreeNode to, Index j, BTreeNode from, Index i)
+{
+  BTreeEntryStruct entry;
+  btreeEntryGet(&entry, from, i);
+  btreeEntrySet(to, j, &entry);
+}
+
+
+/* btreeLeafEntry -- make a leaf entry for a range */
+
+static void btreeLeafEntry(BTreeEntry entryReturn, BTree btree,
+                           Addr base, Addr limit)
+{
+  AVER_CRITICAL(base < limit);
+  entryReturn->base = base;
+  entryReturn->limit = limit;
+  entryReturn->maxSize = AddrOffset(base, limit);
+  if (btree->zoned)
+    entryReturn->zones = ZoneSetOfRange(LandArena(BTreeLand(btree)),
+                                        base, limit);
+  else
+    entryReturn->zones = ZoneSetEMPTY;
+  entryReturn->child = NULL;
+}
+
+
+/* btreeSummary -- make an internal entry summarising a node */
+
+static void btreeSummary(BTreeEntry entryReturn, BTreeNode child)
+{
+  Size maxSize = 0;
+  ZoneSet zones = ZoneSetEMPTY;
+  Index i;
+
+  AVER_CRITICAL(child->count > 0);
+
+  for (i = 0; i < child->count; ++i) {
+    if (child->maxSize[i] > maxSize)
+      maxSize = child->maxSize[i];
+    zones = ZoneSetUnion(zones, child->zones[i]);
+  }
+  entryReturn->base = child->base[0];
+  entryReturn->limit = child->limit[child->count - 1];
+  entryReturn->maxSize = maxSize;
+  entryReturn->zones = zones;
+  entryReturn->child = child;
+}
+
+
+/* btreeSummarise -- bring the summary of a child up to date */
+
+static void btreeSummarise(BTreeNode node, Index i)
+{
+  BTreeEntryStruct entry;
+  AVER_CRITICAL(node->height > 0);
+  AVER_CRITICAL(i < node->count);
+  btreeSummary(&entry, node->child[i]);
+  btreeEntrySet(node, i, &entry);
+}
+
+
+/* btreeNodeOpen, btreeNodeClose -- make room for or remove an entry */
+
+static void btreeNodeOpen(BTreeNode node, Index i)
+{
+  Index j;
+  AVER_CRITICAL(node->count < BTREE_FANOUT);
+  AVER_CRITICAL(i <= node->count);
+  for (j = node->count; j > i; --j)
+    btreeEntryMove(node, j, node, j - 1);
+  ++node->count;
+}
+
+static void btreeNodeClose(BTreeNode node, Index i)
+{
+  Index j;
+  AVER_CRITICAL(i < node->count);
+  for (j = i + 1; j < node->count; ++j)
+    btreeEntryMove(node, j - 1, node, j);
+  --node->count;
+}
+
+
+/* btreeNodeFind -- index of last entry with base at most addr
+ *
+ * Returns zero if there is no such entry. A linear scan is as fast as
+ * a binary search over one or two cache lines, and simpler.
+ */
+
+static Index btreeNodeFind(BTreeNode node, Addr addr)
+{
+  Index i;
+  AVER_CRITICAL(node->count > 0);
+  for (i = 1; i < node->count && node->base[i] <= addr; ++i)
+    NOOP;
+  return i - 1;
+}
+
+
+/* btreeNodeAlloc, btreeNodeFree -- allocate and free nodes */
+
+static Res btreeNodeAlloc(BTreeNode *nodeReturn, BTree btree)
+{
+  BTreeNode node;
+  Addr p;
+  Res res;
+
+  res = PoolAlloc(&p, btreeNodePool(btree), sizeof(BTreeNodeStruct));
+  if (res != ResOK)
+    return res;
+  node = (BTreeNode)p;
+  node->count = 0;
+  node->height = 0;
+  ++btree->nodes;
+  *nodeReturn = node;
+  return ResOK;
+}
+
+static void btreeNodeFree(BTree btree, BTreeNode node)
+{
+  AVER(btree->nodes > 0);
+  --btree->nodes;
+  PoolFree(btreeNodePool(btree), (Addr)node, sizeof(BTreeNodeStruct));
+}
+
+
+/* btreeReserve -- allocate the nodes needed to insert at addr
+ *
+ * <design/btree#.insert.reserve>. Insertion splits the full nodes at
+ * the bottom of the path to the leaf, and needs a new root if every
+ * node on the path is full. Allocating all of these in advance means
+ * that insertion either succeeds or leaves the tree unchanged.
+ */
+
+static void btreeReserveRelease(BTree btree, BTreeReserve reserve)
+{
+  while (reserve->count > 0) {
+    --reserve->count;
+    btreeNodeFree(btree, reserve->node[reserve->count]);
+  }
+}
+
+static Res btreeReserve(BTreeReserve reserve, BTree btree, Addr addr)
+{
+  BTreeNode node = btree->root;
+  Count need = 0;
+  Res res;
+
+  if (node == NULL) {
+    need = 1;
+  } else {
+    for (;;) {
+      need = (node->count == BTREE_FANOUT) ? need + 1 : 0;
+      if (node->height == 0)
+        break;
+      node = node->child[btreeNodeFind(node, addr)];
+    }
+    if (need == btree->height + 1)
+      ++need;
+  }
+  AVER(need <= NELEMS(reserve->node));
+
+  reserve->count = 0;
+  while (reserve->count < need) {
+    res = btreeNodeAlloc(&reserve->node[reserve->count], btree);
+    if (res != ResOK) {
+      btreeReserveRelease(btree, reserve);
+      return res;
+    }
+    ++reserve->count;
+  }
+  return ResOK;
+}
+
+static BTreeNode btreeReserveTake(BTreeReserve reserve, Count height)
+{
+  BTreeNode node;
+  AVER(reserve->count > 0);
+  --reserve->count;
+  node = reserve->node[reserve->count];
+  node->count = 0;
+  node->height = height;
+  return node;
+}
+
+
+/* btreeNodeInsertEntry -- insert entry at index, splitting if full
+ *
+ * Returns the new right sibling if the node was split, otherwise
+ * NULL.
+ */
+
+static BTreeNode btreeNodeInsertEntry(BTreeNode node, Index i,
+                                      BTreeEntry entry,
+                                      BTreeReserve reserve)
+{
+  BTreeNode right;
+  Index j;
+
+  AVER_CRITICAL(i <= node->count);
+
+  if (node->count < BTREE_FANOUT) {
+    btreeNodeOpen(node, i);
+    btreeEntrySet(node, i, entry);
+    return NULL;
+  }
+
+  right = btreeReserveTake(reserve, node->height);
+  for (j = btreeMIN; j < BTREE_FANOUT; ++j)
+    btreeEntryMove(right, j - btreeMIN, node, j);
+  right->count = BTREE_FANOUT - btreeMIN;
+  node->count = btreeMIN;
+
+  if (i <= btreeMIN) {
+    btreeNodeOpen(node, i);
+    btreeEntrySet(node, i, entry);
+  } else {
+    btreeNodeOpen(right, i - btreeMIN);
+    btreeEntrySet(right, i - btreeMIN, entry);
+  }
+  return right;
+}
+
+
+/* btreeNodeInsert -- insert leaf entry into sub-tree */
+
+static BTreeNode btreeNodeInsert(BTreeNode node, BTreeEntry entry,
+                                 BTreeReserve reserve)
+{
+  BTreeEntryStruct splitEntry;
+  BTreeNode split;
+  Index i;
+
+  if (node->height == 0) {
+    i = 0;
+    if (node->count > 0) {
+      i = btreeNodeFind(node, entry->base);
+      if (node->base[i] < entry->base)
+        ++i;
+    }
+    return btreeNodeInsertEntry(node, i, entry, reserve);
+  }
+
+  i = btreeNodeFind(node, entry->base);
+  split = btreeNodeInsert(node->child[i], entry, reserve);
+  btreeSummarise(node, i);
+  if (split == NULL)
+    return NULL;
+  btreeSummary(&splitEntry, split);
+  return btreeNodeInsertEntry(node, i + 1, &splitEntry, reserve);
+}
+
+
+/* btreeInsertEntry -- insert a range that abuts no other range */
+
+static Res btreeInsertEntry(BTree btree, Addr base, Addr limit)
+{
+  BTreeReserveStruct reserve;
+  BTreeEntryStruct entry;
+  BTreeNode split;
+  Res res;
+
+  res = btreeReserve(&reserve, btree, base);
+  if (res != ResOK)
+    return res;
+
+  if (btree->root == NULL) {
+    btree->root = btreeReserveTake(&reserve, 0);
+    btree->height = 0;
+  }
+
+  btreeLeafEntry(&entry, btree, base, limit);
+  split = btreeNodeInsert(btree->root, &entry, &reserve);
+  if (split != NULL) {
+    BTreeNode root = btreeReserveTake(&reserve, btree->height + 1);
+    root->child[0] = btree->root;
+    root->child[1] = split;
+    root->count = 2;
+    btreeSummarise(root, 0);
+    btreeSummarise(root, 1);
+    btree->root = root;
+    ++btree->height;
+  }
+  AVER(reserve.count == 0);
+
+  ++btree->ranges;
+  btree->size += AddrOffset(base, limit);
+  return ResOK;
+}
+
+
+/* btreeNodeRebalance -- fix up child that has too few entries
+ *
+ * Merges the child with a sibling if they fit in one node, otherwise
+ * shares the entries evenly between them.
+ */
+
+static void btreeNodeRebalance(BTree btree, BTreeNode node, Index i)
+{
+  BTreeNode left, right;
+  Count total, n;
+  Index l, j;
+
+  AVER(node->count >= 2);
+
+  l = (i + 1 < node->count) ? i : i - 1;
+  left = node->child[l];
+  right = node->child[l + 1];
+  total = left->count + right->count;
+
+  if (total <= BTREE_FANOUT) {
+    for (j = 0; j < right->count; ++j)
+      btreeEntryMove(left, left->count + j, right, j);
+    left->count = total;
+    btreeNodeClose(node, l + 1);
+    btreeNodeFree(btree, right);
+    btreeSummarise(node, l);
+    return;
+  }
+
+  if (left->count < total / 2) {
+    n = total / 2 - left->count;
+    for (j = 0; j < n; ++j)
+      btreeEntryMove(left, left->count + j, right, j);
+    for (j = n; j < right->count; ++j)
+      btreeEntryMove(right, j - n, right, j);
+    left->count += n;
+    right->count -= n;
+  } else {
+    n = left->count - total / 2;
+    for (j = right->count; j > 0; --j)
+      btreeEntryMove(right, j - 1 + n, right, j - 1);
+    for (j = 0; j < n; ++j)
+      btreeEntryMove(right, j, left, total / 2 + j);
+    left->count -= n;
+    right->count += n;
+  }
+  btreeSummarise(node, l);
+  btreeSummarise(node, l + 1);
+}
+
+
+/* btreeNodeRemove -- remove leaf entry with given base from sub-tree */
+
+static void btreeNodeRemove(BTree btree, BTreeNode node, Addr base)
+{
+  Index i = btreeNodeFind(node, base);
+
+  if (node->height == 0) {
+    AVER(node->base[i] == base);
+    btreeNodeClose(node, i);
+    return;
+  }
+
+  btreeNodeRemove(btree, node->child[i], base);
+  if (node->child[i]->count < btreeMIN)
+    btreeNodeRebalance(btree, node, i);
+  else
+    btreeSummarise(node, i);
+}
+
+
+/* btreeRemoveEntry -- remove a range from the tree
+ *
+ * This never allocates, but may free nodes.
+ */
+
+static void btreeRemoveEntry(BTree btree, Range range)
+{
+  BTreeNode root;
+
+  AVER(btree->root != NULL);
+  btreeNodeRemove(btree, btree->root, RangeBase(range));
+
+  root = btree->root;
+  if (root->count == 0) {
+    AVER(btree->height == 0);
+    btree->root = NULL;
+    btreeNodeFree(btree, root);
+  } else if (root->height > 0 && root->count == 1) {
+    btree->root = root->child[0];
+    --btree->height;
+    btreeNodeFree(btree, root);
+  }
+
+  AVER(btree->ranges > 0);
+  --btree->ranges;
+  AVER(btree->size >= RangeSize(range));
+  btree->size -= RangeSize(range);
+}
+
+
+/* btreeSetEntry -- change the base and limit of a range in the tree
+ *
+ * The new range must lie between the neighbours of the old.
+ */
+
+static void btreeNodeSet(BTree btree, BTreeNode node, Addr key,
+                         Addr base, Addr limit)
+{
+  Index i = btreeNodeFind(node, key);
+
+  if (node->height == 0) {
+    BTreeEntryStruct entry;
+    AVER_CRITICAL(node->base[i] == key);
+    btreeLeafEntry(&entry, btree, base, limit);
+    btreeEntrySet(node, i, &entry);
+    return;
+  }
+
+  btreeNodeSet(btree, node->child[i], key, base, limit);
+  btreeSummarise(node, i);
+}
+
+static void btreeSetEntry(BTree btree, Range range, Addr base, Addr limit)
+{
+  AVER_CRITICAL(btree->root != NULL);
+  btreeNodeSet(btree, btree->root, RangeBase(range), base, limit);
+  AVER_CRITICAL(btree->size >= RangeSize(range));
+  btree->size -= RangeSize(range);
+  btree->size += AddrOffset(base, limit);
+}
+
+
+/* btreeLookup -- find the range with the highest base at most addr */
+
+static Bool btreeLookup(Range rangeReturn, BTree btree, Addr addr)
+{
+  BTreeNode node = btree->root;
+  Index i;
+
+  if (node == NULL)
+    return FALSE;
+  for (;;) {
+    i = btreeNodeFind(node, addr);
+    if (node->height == 0)
+      break;
+    node = node->child[i];
+  }
+  if (node->base[i] > addr)
+    return FALSE;
+  RangeInit(rangeReturn, node->base[i], node->limit[i]);
+  return TRUE;
+}
+
+
+/* btreeNext -- find the range with the lowest base at least addr */
+
+static Bool btreeNodeNext(Range rangeReturn, BTreeNode node, Addr addr)
+{
+  Index i;
+
+  for (i = btreeNodeFind(node, addr); i < node->count; ++i) {
+    if (node->height == 0) {
+      if (node->base[i] >= addr) {
+        RangeInit(rangeReturn, node->base[i], node->limit[i]);
+        return TRUE;
+      }
+    } else if (node->limit[i] > addr
+               && btreeNodeNext(rangeReturn, node->child[i], addr)) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static Bool btreeNext(Range rangeReturn, BTree btree, Addr addr)
+{
+  if (btree->root == NULL)
+    return FALSE;
+  return btreeNodeNext(rangeReturn, btree->root, addr);
+}
+
+
+/* btreeInit -- initialise a B-tree
+ *
+ * <design/land#.function.init>.
+ */
+
+ARG_DEFINE_KEY(btree_node_pool, Pool);
+
+static Res btreeInitComm(Land land, LandClass klass,
+                         Arena arena, Align alignment,
+                         ArgList args, Bool zoned)
+{
+  BTree btree;
+  ArgStruct arg;
+  Res res;
+  Pool nodePool = NULL;
+
+  AVER(land != NULL);
+  res = NextMethod(Land, BTree, init)(land, arena, alignment, args);
+  if (res != ResOK)
+    goto failNextInit;
+  btree = CouldBeA(BTree, land);
+
+  if (ArgPick(&arg, args, BTreeNodePool))
+    nodePool = arg.val.pool;
+
+  if (nodePool != NULL) {
+    btree->nodePool = nodePool;
+    btree->ownPool = FALSE;
+  } else {
+    MPS_ARGS_BEGIN(pcArgs) {
+      MPS_ARGS_ADD(pcArgs, MPS_KEY_MFS_UNIT_SIZE, sizeof(BTreeNodeStruct));
+      res = PoolCreate(&btree->nodePool, arena, PoolClassMFS(), pcArgs);
+    } MPS_ARGS_END(pcArgs);
+    if (res != ResOK)
+      goto failPoolCreate;
+    btree->ownPool = TRUE;
+  }
+
+  btree->root = NULL;
+  btree->height = 0;
+  btree->nodes = 0;
+  btree->ranges = 0;
+  btree->zoned = zoned;
+  btree->size = 0;
+
+  SetClassOfPoly(land, klass);
+  btree->sig = BTreeSig;
+  AVERC(BTree, btree);
+
+  return ResOK;
+
+failPoolCreate:
+  NextMethod(Inst, BTree, finish)(MustBeA(Inst, land));
+failNextInit:
+  AVER(res != ResOK);
+  return res;
+}
+
+static Res btreeInit(Land land, Arena arena, Align alignment, ArgList args)
+{
+  return btreeInitComm(land, CLASS(BTree), arena, alignment, args, FALSE);
+}
+
+static Res btreeInitZoned(Land land, Arena arena, Align alignment,
+                          ArgList args)
+{
+  return btreeInitComm(land, CLASS(BTreeZoned), arena, alignment, args,
+                       TRUE);
+}
+
+
+/* btreeFinish -- finish a B-tree
+ *
+ * <design/land#.function.finish>.
+ */
+
+static void btreeNodeFinish(BTree btree, BTreeNode node)
+{
+  Index i;
+  if (node->height > 0)
+    for (i = 0; i < node->count; ++i)
+      btreeNodeFinish(btree, node->child[i]);
+  btreeNodeFree(btree, node);
+}
+
+static void btreeFinish(Inst inst)
+{
+  Land land = MustBeA(Land, inst);
+  BTree btree = MustBeA(BTree, land);
+
+  btree->sig = SigInvalid;
+
+  if (btree->ownPool) {
+    PoolDestroy(btreeNodePool(btree));
+  } else if (btree->root != NULL) {
+    btreeNodeFinish(btree, btree->root);
+    AVER(btree->nodes == 0);
+  }
+  btree->root = NULL;
+
+  NextMethod(Inst, BTree, finish)(inst);
+}
+
+
+/* btreeSize -- total size of ranges in B-tree
+ *
+ * <design/land#.function.size>.
+ */
+
+static Size btreeSize(Land land)
+{
+  BTree btree = MustBeA_CRITICAL(BTree, land);
+  return btree->size;
+}
+
+
+/* btreeInsert -- insert a range into the B-tree
+ *
+ * <design/land#.function.insert>.
+ *
+ * .insert.alloc: Will only allocate if the range does not abut an
+ * existing range.
+ */
+
+static Res btreeInsert(Range rangeReturn, Land land, Range range)
+{
+  BTree btree = MustBeA_CRITICAL(BTree, land);
+  RangeStruct left, right;
+  Bool leftMerge = FALSE, rightMerge = FALSE;
+  Addr base, limit, newBase, newLimit;
+  Res res;
+
+  AVER_CRITICAL(rangeReturn != NULL);
+  AVERT_CRITICAL(Range, range);
+  AVER_CRITICAL(!RangeIsEmpty(range));
+  AVER_CRITICAL(RangeIsAligned(range, LandAlignment(land)));
+
+  base = RangeBase(range);
+  limit = RangeLimit(range);
+
+  if (btreeLookup(&left, btree, base)) {
+    if (RangeLimit(&left) > base)
+      return ResFAIL;
+    leftMerge = RangeLimit(&left) == base;
+  }
+  if (btreeNext(&right, btree, base)) {
+    AVER_CRITICAL(RangeBase(&right) > base);
+    if (limit > RangeBase(&right))
+      return ResFAIL;
+    rightMerge = RangeBase(&right) == limit;
+  }
+
+  newBase = leftMerge ? RangeBase(&left) : base;
+  newLimit = rightMerge ? RangeLimit(&right) : limit;
+
+  if (leftMerge && rightMerge) {
+    btreeRemoveEntry(btree, &right);
+    btreeSetEntry(btree, &left, newBase, newLimit);
+  } else if (leftMerge) {
+    btreeSetEntry(btree, &left, newBase, newLimit);
+  } else if (rightMerge) {
+    btreeSetEntry(btree, &right, newBase, newLimit);
+  } else {
+    res = btreeInsertEntry(btree, base, limit);
+    if (res != ResOK)
+      return res;
+  }
+
+  RangeInit(rangeReturn, newBase, newLimit);
+  return ResOK;
+}
+
+
+/* btreeExtendNodePool -- extend node pool with memory */
+
+static void btreeExtendNodePool(BTree btree, Addr base, Addr limit)
+{
+  Tract tract;
+  Addr addr;
+
+  AVERC(BTree, btree);
+  AVER(base < limit);
+
+  /* Steal tracts from their owning pool */
+  TRACT_FOR(tract, addr, BTreeLand(btree)->arena, base, limit) {
+    TractFinish(tract);
+    TractInit(tract, btree->nodePool);
+  }
+
+  /* Extend the node pool with the stolen memory. */
+  MFSExtend(btree->nodePool, base, limit);
+}
+
+
+/* btreeInsertSteal -- insert a range into the B-tree, possibly
+ * stealing memory for the node pool
+ *
+ * Unlike cbsInsertSteal, an insertion may need several nodes, so this
+ * may steal more than one grain.
+ */
+
+static Res btreeInsertSteal(Range rangeReturn, Land land, Range rangeIO)
+{
+  BTree btree = MustBeA(BTree, land);
+  Arena arena = land->arena;
+  Size grainSize = ArenaGrainSize(arena);
+  Res res;
+
+  AVER(rangeReturn != NULL);
+  AVER(rangeReturn != rangeIO);
+  AVERT(Range, rangeIO);
+  AVER(!RangeIsEmpty(rangeIO));
+  AVER(RangeIsAligned(rangeIO, LandAlignment(land)));
+  AVER(AlignIsAligned(LandAlignment(land), grainSize));
+
+  res = btreeInsert(rangeReturn, land, rangeIO);
+  while (res != ResOK && res != ResFAIL) {
+    /* Steal an arena grain and use it to extend the node pool. */
+    Addr stolenBase = RangeBase(rangeIO);
+    Addr stolenLimit = AddrAdd(stolenBase, grainSize);
+    btreeExtendNodePool(btree, stolenBase, stolenLimit);
+
+    /* Update the inserted range and try again. */
+    RangeSetBase(rangeIO, stolenLimit);
+    AVERT(Range, rangeIO);
+    if (RangeIsEmpty(rangeIO)) {
+      RangeCopy(rangeReturn, rangeIO);
+      res = ResOK;
+    } else {
+      res = btreeInsert(rangeReturn, land, rangeIO);
+      AVER(res != ResFAIL);
+    }
+  }
+  return res;
+}
+
+
+/* btreeDelete -- remove a range from the B-tree
+ *
+ * <design/land#.function.delete>.
+ *
+ * .delete.alloc: Will only allocate if the range splits an existing
+ * range. In that case rangeReturn is set even on failure, as
+ * btreeDeleteSteal relies on it.
+ */
+
+static Res btreeDelete(Range rangeReturn, Land land, Range range)
+{
+  BTree btree = MustBeA(BTree, land);
+  RangeStruct old;
+  Addr base, limit, oldBase, oldLimit;
+  Res res;
+
+  AVER(rangeReturn != NULL);
+  AVERT(Range, range);
+  AVER(!RangeIsEmpty(range));
+  AVER(RangeIsAligned(range, LandAlignment(land)));
+
+  base = RangeBase(range);
+  limit = RangeLimit(range);
+
+  if (!btreeLookup(&old, btree, base) || limit > RangeLimit(&old))
+    return ResFAIL;
+
+  oldBase = RangeBase(&old);
+  oldLimit = RangeLimit(&old);
+  RangeCopy(rangeReturn, &old);
+
+  if (base == oldBase && limit == oldLimit) {
+    /* entire range */
+    btreeRemoveEntry(btree, &old);
+
+  } else if (base == oldBase) {
+    /* remaining fragment at right */
+    btreeSetEntry(btree, &old, limit, oldLimit);
+
+  } else if (limit == oldLimit) {
+    /* remaining fragment at left */
+    btreeSetEntry(btree, &old, oldBase, base);
+
+  } else {
+    /* two remaining fragments: insert the one at right (which sorts
+       after the old range), then shrink the old range to the one at
+       left. */
+    res = btreeInsertEntry(btree, limit, oldLimit);
+    if (res != ResOK)
+      return res;
+    btreeSetEntry(btree, &old, oldBase, base);
+  }
+
+  return ResOK;
+}
+
+
+/* btreeDeleteSteal -- remove a range from the B-tree, possibly
+ * stealing memory for the node pool
+ */
+
+static Res btreeDeleteSteal(Range rangeReturn, Land land, Range range)
+{
+  BTree btree = MustBeA(BTree, land);
+  Arena arena = land->arena;
+  Size grainSize = ArenaGrainSize(arena);
+  RangeStruct containingRange;
+  Res res;
+
+  AVER(rangeReturn != NULL);
+  AVERT(Range, range);
+  AVER(!RangeIsEmpty(range));
+  AVER(RangeIsAligned(range, LandAlignment(land)));
+  AVER(AlignIsAligned(LandAlignment(land), grainSize));
+
+  res = btreeDelete(&containingRange, land, range);
+  while (res != ResOK && res != ResFAIL) {
+    /* Steal an arena grain from the base of the containing range and
+       use it to extend the node pool. */
+    Addr stolenBase = RangeBase(&containingRange);
+    Addr stolenLimit = AddrAdd(stolenBase, grainSize);
+    RangeStruct stolenRange, oldRange;
+    AVER(stolenLimit <= RangeBase(range));
+    RangeInit(&stolenRange, stolenBase, stolenLimit);
+    res = btreeDelete(&oldRange, land, &stolenRange);
+    AVER(res == ResOK);  /* since this does not split any range */
+    btreeExtendNodePool(btree, stolenBase, stolenLimit);
+
+    /* Try again with original range. */
+    res = btreeDelete(&containingRange, land, range);
+    AVER(res != ResFAIL);
+  }
+  if (res == ResOK)
+    RangeCopy(rangeReturn, &containingRange);
+  return res;
+}
+
+
+/* btreeIterate -- iterate over all ranges in B-tree
+ *
+ * <design/land#.function.iterate>.
+ */
+
+static Bool btreeNodeIterate(Land land, BTreeNode node,
+                             LandVisitor visitor, void *visitorClosure)
+{
+  Index i;
+
+  for (i = 0; i < node->count; ++i) {
+    if (node->height == 0) {
+      RangeStruct range;
+      RangeInit(&range, node->base[i], node->limit[i]);
+      if (!(*visitor)(land, &range, visitorClosure))
+        return FALSE;
+    } else if (!btreeNodeIterate(land, node->child[i], visitor,
+                                 visitorClosure)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static Bool btreeIterate(Land land, LandVisitor visitor, void *visitorClosure)
+{
+  BTree btree = MustBeA(BTree, land);
+
+  AVER(FUNCHECK(visitor));
+
+  if (btree->root == NULL)
+    return TRUE;
+  return btreeNodeIterate(land, btree->root, visitor, visitorClosure);
+}
+
+
+/* btreeIterateAndDelete -- iterate over all ranges in B-tree
+ *
+ * <design/land#.function.iterate.and.delete>.
+ *
+ * Deleting a range may restructure the tree, so rather than walking
+ * the nodes, this looks up each range by address in turn.
+ */
+
+static Bool btreeIterateAndDelete(Land land, LandDeleteVisitor visitor,
+                                  void *visitorClosure)
+{
+  BTree btree = MustBeA(BTree, land);
+  RangeStruct range;
+  Addr cursor = (Addr)0;
+  Bool cont = TRUE;
+
+  AVER(FUNCHECK(visitor));
+
+  while (cont && btreeNext(&range, btree, cursor)) {
+    Bool deleteRange = FALSE;
+    cont = (*visitor)(&deleteRange, land, &range, visitorClosure);
+    if (deleteRange)
+      btreeRemoveEntry(btree, &range);
+    cursor = RangeLimit(&range);
+  }
+  return cont;
+}
+
+
+/* btreeFindDeleteRange -- delete appropriate range of block found */
+
+static void btreeFindDeleteRange(Range rangeReturn, Range oldRangeReturn,
+                                 Land land, Range range, Size size,
+                                 FindDelete findDelete)
+{
+  Bool callDelete = TRUE;
+  Addr base, limit;
+
+  AVER(rangeReturn != NULL);
+  AVER(oldRangeReturn != NULL);
+  AVERT(Land, land);
+  AVERT(Range, range);
+  AVER(RangeIsAligned(range, LandAlignment(land)));
+  AVER(size > 0);
+  AVER(SizeIsAligned(size, LandAlignment(land)));
+  AVER(RangeSize(range) >= size);
+  AVERT(FindDelete, findDelete);
+
+  base = RangeBase(range);
+  limit = RangeLimit(range);
+
+  switch(findDelete) {
+
+  case FindDeleteNONE:
+    callDelete = FALSE;
+    break;
+
+  case FindDeleteLOW:
+    limit = AddrAdd(base, size);
+    break;
+
+  case FindDeleteHIGH:
+    base = AddrSub(limit, size);
+    break;
+
+  case FindDeleteENTIRE:
+    /* do nothing */
+    break;
+
+  default:
+    NOTREACHED;
+    break;
+  }
+
+  RangeInit(rangeReturn, base, limit);
+
+  if (callDelete) {
+    Res res;
+    res = btreeDelete(oldRangeReturn, land, rangeReturn);
+    /* Can't have run out of memory, because we only deleted from one
+       end of a range that is in the tree. */
+    AVER(res == ResOK);
+  } else {
+    RangeCopy(oldRangeReturn, rangeReturn);
+  }
+}
+
+
+/* btreeFindFirst -- find the first range of at least the given size
+ *
+ * <design/btree#.find>. Descends to the first entry at each level
+ * whose sub-tree contains a large enough range. The summaries are
+ * exact, so this never backtracks.
+ */
+
+static Bool btreeFindFirst(Range rangeReturn, Range oldRangeReturn,
+                           Land land, Size size, FindDelete findDelete)
+{
+  BTree btree = MustBeA_CRITICAL(BTree, land);
+  BTreeNode node = btree->root;
+  RangeStruct range;
+  Index i;
+
+  AVER_CRITICAL(rangeReturn != NULL);
+  AVER_CRITICAL(oldRangeReturn != NULL);
+  AVER_CRITICAL(size > 0);
+  AVER_CRITICAL(SizeIsAligned(size, LandAlignment(land)));
+  AVERT_CRITICAL(FindDelete, findDelete);
+
+  if (node == NULL)
+    return FALSE;
+  for (;;) {
+    for (i = 0; i < node->count && node->maxSize[i] < size; ++i)
+      NOOP;
+    if (i == node->count) {
+      AVER_CRITICAL(node == btree->root);
+      return FALSE;
+    }
+    if (node->height == 0)
+      break;
+    node = node->child[i];
+  }
+
+  RangeInit(&range, node->base[i], node->limit[i]);
+  btreeFindDeleteRange(rangeReturn, oldRangeReturn, land, &range,
+                       size, findDelete);
+  return TRUE;
+}
+
+
+/* btreeFindLast -- find the last range of at least the given size */
+
+static Bool btreeFindLast(Range rangeReturn, Range oldRangeReturn,
+                          Land land, Size size, FindDelete findDelete)
+{
+  BTree btree = MustBeA_CRITICAL(BTree, land);
+  BTreeNode node = btree->root;
+  RangeStruct range;
+  Index i;
+
+  AVER_CRITICAL(rangeReturn != NULL);
+  AVER_CRITICAL(oldRangeReturn != NULL);
+  AVER_CRITICAL(size > 0);
+  AVER_CRITICAL(SizeIsAligned(size, LandAlignment(land)));
+  AVERT_CRITICAL(FindDelete, findDelete);
+
+  if (node == NULL)
+    return FALSE;
+  for (;;) {
+    for (i = node->count; i > 0 && node->maxSize[i - 1] < size; --i)
+      NOOP;
+    if (i == 0) {
+      AVER_CRITICAL(node == btree->root);
+      return FALSE;
+    }
+    --i;
+    if (node->height == 0)
+      break;
+    node = node->child[i];
+  }
+
+  RangeInit(&range, node->base[i], node->limit[i]);
+  btreeFindDeleteRange(rangeReturn, oldRangeReturn, land, &range,
+                       size, findDelete);
+  return TRUE;
+}
+
+
+/* btreeFindLargest -- find the largest range in the B-tree */
+
+static Bool btreeFindLargest(Range rangeReturn, Range oldRangeReturn,
+                             Land land, Size size, FindDelete findDelete)
+{
+  BTree btree = MustBeA_CRITICAL(BTree, land);
+  BTreeNode node = btree->root;
+  RangeStruct range;
+  Size maxSize = 0;
+  Index i;
+
+  AVER_CRITICAL(rangeReturn != NULL);
+  AVER_CRITICAL(oldRangeReturn != NULL);
+  AVER_CRITICAL(size > 0);
+  AVERT_CRITICAL(FindDelete, findDelete);
+
+  if (node == NULL)
+    return FALSE;
+  for (i = 0; i < node->count; ++i)
+    if (node->maxSize[i] > maxSize)
+      maxSize = node->maxSize[i];
+  if (maxSize < size)
+    return FALSE;
+
+  /* Descend towards the first range of exactly maxSize. */
+  for (;;) {
+    for (i = 0; i < node->count && node->maxSize[i] < maxSize; ++i)
+      NOOP;
+    AVER_CRITICAL(i < node->count); /* maxSize is exact */
+    if (node->height == 0)
+      break;
+    node = node->child[i];
+  }
+
+  RangeInit(&range, node->base[i], node->limit[i]);
+  btreeFindDeleteRange(rangeReturn, oldRangeReturn, land, &range,
+                       size, findDelete);
+  return TRUE;
+}
+
+
+/* btreeFindInZones -- find a range within a zone set
+ *
+ * Finds a range of at least the given size that lies entirely within
+ * a zone set. (The first such range, if high is FALSE, or the last,
+ * if high is TRUE.) Sub-trees whose summaries show that they have no
+ * range large enough, or none in the zone set, are skipped.
+ */
+
+typedef struct BTreeFindInZonesClosureStruct {
+  Size size;
+  Arena arena;
+  ZoneSet zoneSet;
+  Addr base;
+  Addr limit;
+  Bool high;
+} BTreeFindInZonesClosureStruct, *BTreeFindInZonesClosure;
+
+static Bool btreeNodeFindInZones(BTreeNode node,
+                                 BTreeFindInZonesClosure my)
+{
+  RangeInZoneSet search = my->high ? RangeInZoneSetLast : RangeInZoneSetFirst;
+  Index k, i;
+
+  for (k = 0; k < node->count; ++k) {
+    i = my->high ? node->count - 1 - k : k;
+    if (node->maxSize[i] < my->size
+        || ZoneSetInter(node->zones[i], my->zoneSet) == ZoneSetEMPTY)
+      continue;
+    if (node->height == 0) {
+      if ((*search)(&my->base, &my->limit, node->base[i], node->limit[i],
+                    my->arena, my->zoneSet, my->size))
+        return TRUE;
+    } else if (btreeNodeFindInZones(node->child[i], my)) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static Res btreeFindInZones(Bool *foundReturn, Range rangeReturn,
+                            Range oldRangeReturn, Land land, Size size,
+                            ZoneSet zoneSet, Bool high)
+{
+  BTree btree = MustBeA_CRITICAL(BTreeZoned, land);
+  BTreeFindInZonesClosureStruct closure;
+  LandFindMethod landFind;
+  RangeStruct rangeStruct, oldRangeStruct;
+  Res res;
+
+  AVER_CRITICAL(foundReturn != NULL);
+  AVER_CRITICAL(rangeReturn != NULL);
+  AVER_CRITICAL(oldRangeReturn != NULL);
+  /* AVERT_CRITICAL(ZoneSet, zoneSet); */
+  AVERT_CRITICAL(Bool, high);
+
+  landFind = high ? btreeFindLast : btreeFindFirst;
+
+  if (zoneSet == ZoneSetEMPTY || btree->root == NULL)
+    goto fail;
+  if (zoneSet == ZoneSetUNIV) {
+    FindDelete fd = high ? FindDeleteHIGH : FindDeleteLOW;
+    *foundReturn = (*landFind)(rangeReturn, oldRangeReturn, land, size, fd);
+    return ResOK;
+  }
+  if (ZoneSetIsSingle(zoneSet) && size > ArenaStripeSize(LandArena(land)))
+    goto fail;
+
+  closure.arena = LandArena(land);
+  closure.zoneSet = zoneSet;
+  closure.size = size;
+  closure.high = high;
+  if (!btreeNodeFindInZones(btree->root, &closure))
+    goto fail;
+
+  AVER_CRITICAL(AddrOffset(closure.base, closure.limit) >= size);
+  AVER_CRITICAL(ZoneSetSub(ZoneSetOfRange(LandArena(land), closure.base, closure.limit), zoneSet));
+
+  if (!high)
+    RangeInit(&rangeStruct, closure.base, AddrAdd(closure.base, size));
+  else
+    RangeInit(&rangeStruct, AddrSub(closure.limit, size), closure.limit);
+  res = btreeDelete(&oldRangeStruct, land, &rangeStruct);
+  if (res != ResOK)
+    /* not enough memory to split range */
+    return res;
+  RangeCopy(rangeReturn, &rangeStruct);
+  RangeCopy(oldRangeReturn, &oldRangeStruct);
+  *foundReturn = TRUE;
+  return ResOK;
+
+fail:
+  *foundReturn = FALSE;
+  return ResOK;
+}
+
+
+/* btreeDescribe -- describe a B-tree
+ *
+ * <design/land#.function.describe>.
+ */
+
+static Res btreeNodeDescribe(BTreeNode node, mps_lib_FILE *stream,
+                             Count depth)
+{
+  Res res;
+  Index i;
+
+  for (i = 0; i < node->count; ++i) {
+    if (node->height == 0) {
+      res = WriteF(stream, depth, "[$P,$P)\n",
+                   (WriteFP)node->base[i], (WriteFP)node->limit[i],
+                   NULL);
+      if (res != ResOK)
+        return res;
+    } else {
+      res = WriteF(stream, depth, "[$P,$P) {$U, $B}\n",
+                   (WriteFP)node->base[i], (WriteFP)node->limit[i],
+                   (WriteFU)node->maxSize[i], (WriteFB)node->zones[i],
+                   NULL);
+      if (res != ResOK)
+        return res;
+      res = btreeNodeDescribe(node->child[i], stream, depth + 2);
+      if (res != ResOK)
+        return res;
+    }
+  }
+  return ResOK;
+}
+
+static Res btreeDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
+{
+  Land land = CouldBeA(Land, inst);
+  BTree btree = CouldBeA(BTree, land);
+  Res res;
+
+  if (!TESTC(BTree, btree))
+    return ResPARAM;
+  if (stream == NULL)
+    return ResPARAM;
+
+  res = NextMethod(Inst, BTree, describe)(inst, stream, depth);
+  if (res != ResOK)
+    return res;
+
+  res = WriteF(stream, depth + 2,
+               "nodePool $P\n", (WriteFP)btreeNodePool(btree),
+               "ownPool  $U\n", (WriteFU)btree->ownPool,
+               "zoned    $U\n", (WriteFU)btree->zoned,
+               "height   $U\n", (WriteFU)btree->height,
+               "nodes    $U\n", (WriteFU)btree->nodes,
+               "ranges   $U\n", (WriteFU)btree->ranges,
+               NULL);
+  if (res != ResOK)
+    return res;
+
+  if (btree->root != NULL) {
+    res = btreeNodeDescribe(btree->root, stream, depth + 2);
+    if (res != ResOK)
+      return res;
+  }
+
+  return ResOK;
+}
+
+DEFINE_CLASS(Land, BTree, klass)
+{
+  INHERIT_CLASS(klass, BTree, Land);
+  klass->instClassStruct.describe = btreeDescribe;
+  klass->instClassStruct.finish = btreeFinish;
+  klass->size = sizeof(BTreeStruct);
+  klass->init = btreeInit;
+  klass->sizeMethod = btreeSize;
+  klass->insert = btreeInsert;
+  klass->insertSteal = btreeInsertSteal;
+  klass->delete = btreeDelete;
+  klass->deleteSteal = btreeDeleteSteal;
+  klass->iterate = btreeIterate;
+  klass->iterateAndDelete = btreeIterateAndDelete;
+  klass->findFirst = btreeFindFirst;
+  klass->findLast = btreeFindLast;
+  klass->findLargest = btreeFindLargest;
+  klass->findInZones = btreeFindInZones;
+  AVERT(LandClass, klass);
+}
+
+DEFINE_CLASS(Land, BTreeZoned, klass)
+{
+  INHERIT_CLASS(klass, BTreeZoned, BTree);
+  klass->init = btreeInitZoned;
+  AVERT(LandClass, klass);
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,90 @@
+/* btree.h: B-TREE LAND INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .source: <design/btree>.
+ */
+
+#ifndef btree_h
+#define btree_h
+
+#include "arg.h"
+#include "mpmtypes.h"
+#include "mpm.h"
+#include "mpmst.h"
+#include "protocol.h"
+
+
+/* BTreeNodeStruct -- B-tree node
+ *
+ * The entries are stored as parallel arrays so that a search by
+ * address only touches the base array <design/btree#.node.layout>.
+ * In a leaf, entry i is the range [base[i], limit[i]). In an internal
+ * node, entry i summarises the sub-tree child[i]: base[i] is its
+ * lowest base, limit[i] its highest limit, and maxSize[i] and
+ * zones[i] the largest size and union of zones of its ranges.
+ */
+
+typedef struct BTreeNodeStruct *BTreeNode;
+typedef struct BTreeNodeStruct {
+  Count count;                  /* number of entries in use */
+  Count height;                 /* height above the leaves */
+  Addr base[BTREE_FANOUT];
+  Addr limit[BTREE_FANOUT];
+  Size maxSize[BTREE_FANOUT];
+  ZoneSet zones[BTREE_FANOUT];  /* ZoneSetEMPTY unless zoned */
+  BTreeNode child[BTREE_FANOUT]; /* NULL in leaves */
+} BTreeNodeStruct;
+
+typedef struct BTreeStruct *BTree, *BTreeZoned;
+
+extern Bool BTreeCheck(BTree btree);
+
+
+/* BTreeLand -- convert B-tree to Land
+ *
+ * See the comment on CBSLand in <code/cbs.h>.
+ */
+
+#define BTreeLand(btree) (&(btree)->landStruct)
+
+
+DECLARE_CLASS(Land, BTree, Land);
+DECLARE_CLASS(Land, BTreeZoned, BTree);
+
+extern const struct mps_key_s _mps_key_btree_node_pool;
+#define BTreeNodePool (&_mps_key_btree_node_pool)
+#define BTreeNodePool_FIELD pool
+
+#endif /* btree.h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
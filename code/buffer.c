@@ -42,6 +42,7 @@ Bool BufferCheck(Buffer buffer)
   CHECKL(buffer->arena == buffer->pool->arena);
   CHECKD_NOSIG(Ring, &buffer->poolRing);
   CHECKL(BoolCheck(buffer->isMutator));
+  CHECKL(BoolCheck(buffer->zeroed));
   CHECKL(buffer->fillSize >= 0.0);
   CHECKL(buffer->emptySize >= 0.0);
   CHECKL(buffer->emptySize <= buffer->fillSize);
@@ -138,6 +139,7 @@ static Res BufferAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                 "Arena $P\n",       (WriteFP)buffer->arena,
                 "Pool $P\n",        (WriteFP)buffer->pool,
                 buffer->isMutator ? "Mutator" : "Internal", " Buffer\n",
+                "zeroed $S\n",     WriteFYesNo(buffer->zeroed),
                 "mode $C$C$C$C (TRANSITION, LOGGED, FLIPPED, ATTACHED)\n",
                 (WriteFC)((buffer->mode & BufferModeTRANSITION) ? 't' : '_'),
                 (WriteFC)((buffer->mode & BufferModeLOGGED)     ? 'l' : '_'),
@@ -165,9 +167,13 @@ Res BufferDescribe(Buffer buffer, mps_lib_FILE *stream, Count depth)
 
 /* BufferInit -- initialize an allocation buffer */
 
+ARG_DEFINE_KEY(AP_ZEROED, Bool);
+
 static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
 {
   Arena arena;
+  ArgStruct arg;
+  Bool zeroed = FALSE;
 
   AVER(buffer != NULL);
   AVERT(Pool, pool);
@@ -179,12 +185,16 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
 
   arena = PoolArena(pool);
 
+  if (ArgPick(&arg, args, MPS_KEY_AP_ZEROED))
+    zeroed = arg.val.b;
+
   /* Initialize the buffer.  See <code/mpmst.h> for a definition of
      the structure.  sig and serial comes later .init.sig-serial */
   buffer->arena = arena;
   buffer->pool = pool;
   RingInit(&buffer->poolRing);
   buffer->isMutator = isMutator;
+  buffer->zeroed = zeroed;
   if (ArenaGlobals(arena)->bufferLogging) {
     buffer->mode = BufferModeLOGGED;
   } else {
@@ -614,6 +624,19 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
   if (res != ResOK)
     return res;
 
+  /* <design/buffer#.zeroed> */
+  if (buffer->zeroed && !PoolHasAttr(pool, AttrZEROFILL)) {
+    Arena arena = PoolArena(pool);
+    Seg seg;
+    if (SegOfAddr(&seg, arena, base)) {
+      ShieldExpose(arena, seg);
+      (void)mps_lib_memset(base, 0, AddrOffset(base, limit));
+      ShieldCover(arena, seg);
+    } else {
+      (void)mps_lib_memset(base, 0, AddrOffset(base, limit));
+    }
+  }
+
   /* Set up the buffer to point at the memory given by the pool */
   /* and do the allocation that was requested by the client. */
   BufferAttach(buffer, base, limit, base, size);
@@ -498,7 +498,7 @@ static void cbsExtendBlockPool(CBS cbs, Addr base, Addr limit)
   /* Steal tracts from their owning pool */
   TRACT_FOR(tract, addr, CBSLand(cbs)->arena, base, limit) {
     TractFinish(tract);
-    TractInit(tract, cbs->blockPool, addr);
+    TractInit(tract, cbs->blockPool);
   }
 
   /* Extend the block pool with the stolen memory. */
@@ -913,7 +913,13 @@ static void cbsFindDeleteRange(Range rangeReturn, Range oldRangeReturn,
 }
 
 
-/* CBSFindFirst -- find the first block of at least the given size */
+/* CBSFindFirst -- find the first block of at least the given size
+ *
+ * If the block is not going to be deleted, the search does not splay
+ * the tree: cbsTestTree is exact, so SplayLookupFirst always finds
+ * the block, and read-only queries leave the tree alone
+ * <design/splay#.function.splay.lookup.first>.
+ */
 
 static Bool cbsFindFirst(Range rangeReturn, Range oldRangeReturn,
                          Land land, Size size, FindDelete findDelete)
@@ -921,6 +927,7 @@ static Bool cbsFindFirst(Range rangeReturn, Range oldRangeReturn,
   CBS cbs = MustBeA_CRITICAL(CBS, land);
   Bool found;
   Tree tree;
+  SplayFindFunction splayFind;
 
   AVER_CRITICAL(rangeReturn != NULL);
   AVER_CRITICAL(oldRangeReturn != NULL);
@@ -929,8 +936,8 @@ static Bool cbsFindFirst(Range rangeReturn, Range oldRangeReturn,
   AVERT_CRITICAL(FindDelete, findDelete);
 
   METER_ACC(cbs->treeSearch, cbs->treeSize);
-  found = SplayFindFirst(&tree, cbsSplay(cbs), &cbsTestNode,
-                         &cbsTestTree, &size);
+  splayFind = findDelete == FindDeleteNONE ? SplayLookupFirst : SplayFindFirst;
+  found = splayFind(&tree, cbsSplay(cbs), &cbsTestNode, &cbsTestTree, &size);
   if (found) {
     RangeTree block;
     RangeStruct range;
@@ -994,7 +1001,10 @@ static Bool cbsTestTreeInZones(SplayTree splay, Tree tree,
 }
 
 
-/* cbsFindLast -- find the last block of at least the given size */
+/* cbsFindLast -- find the last block of at least the given size
+ *
+ * See cbsFindFirst for why read-only queries do not splay.
+ */
 
 static Bool cbsFindLast(Range rangeReturn, Range oldRangeReturn,
                         Land land, Size size, FindDelete findDelete)
@@ -1002,6 +1012,7 @@ static Bool cbsFindLast(Range rangeReturn, Range oldRangeReturn,
   CBS cbs = MustBeA_CRITICAL(CBSFast, land);
   Bool found;
   Tree tree;
+  SplayFindFunction splayFind;
 
   AVER_CRITICAL(rangeReturn != NULL);
   AVER_CRITICAL(oldRangeReturn != NULL);
@@ -1010,8 +1021,8 @@ static Bool cbsFindLast(Range rangeReturn, Range oldRangeReturn,
   AVERT_CRITICAL(FindDelete, findDelete);
 
   METER_ACC(cbs->treeSearch, cbs->treeSize);
-  found = SplayFindLast(&tree, cbsSplay(cbs), &cbsTestNode,
-                        &cbsTestTree, &size);
+  splayFind = findDelete == FindDeleteNONE ? SplayLookupLast : SplayFindLast;
+  found = splayFind(&tree, cbsSplay(cbs), &cbsTestNode, &cbsTestTree, &size);
   if (found) {
     RangeTree block;
     RangeStruct range;
@@ -1048,9 +1059,12 @@ static Bool cbsFindLargest(Range rangeReturn, Range oldRangeReturn,
     maxSize = cbsFastBlockOfTree(SplayTreeRoot(cbsSplay(cbs)))->maxSize;
     if (maxSize >= size) {
       RangeTree block;
+      SplayFindFunction splayFind;
       METER_ACC(cbs->treeSearch, cbs->treeSize);
-      found = SplayFindFirst(&tree, cbsSplay(cbs), &cbsTestNode,
-                             &cbsTestTree, &maxSize);
+      splayFind = findDelete == FindDeleteNONE
+        ? SplayLookupFirst : SplayFindFirst;
+      found = splayFind(&tree, cbsSplay(cbs), &cbsTestNode,
+                        &cbsTestTree, &maxSize);
       AVER_CRITICAL(found); /* maxSize is exact, so we will find it. */
       block = RangeTreeOfTree(tree);
       AVER_CRITICAL(RangeTreeSize(block) >= maxSize);
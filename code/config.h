@@ -209,6 +209,37 @@
 #endif
 
 
+/* CONFIG_VM_EAGER_DECOMMIT -- return unmapped memory at once
+ *
+ * On Linux and FreeBSD, vmix.c unmaps memory by advising the
+ * operating system that it may take the pages back when it needs
+ * them, and revoking access, so that mapping the memory again is
+ * cheap if it has not done so. This symbol makes vmix.c replace the
+ * mapping instead, which returns the memory immediately. See
+ * <design/vm#.impl.ix.lazy>.
+ */
+
+#if !defined(CONFIG_VM_EAGER_DECOMMIT) \
+  && (defined(MPS_OS_LI) || defined(MPS_OS_FR))
+#define VM_DECOMMIT_LAZY
+#endif
+
+
+/* CONFIG_VM_HUGETLB -- use explicit huge pages where requested
+ *
+ * When an arena is created with MPS_KEY_ARENA_HUGE_PAGES, vmix.c on
+ * Linux normally asks for transparent huge pages with madvise. This
+ * symbol makes it reserve address space with MAP_HUGETLB instead,
+ * drawing on the pool of huge pages the system administrator has
+ * configured, and falling back to transparent huge pages if the pool
+ * is too small. See <design/vm#.impl.ix.huge>.
+ */
+
+#if defined(CONFIG_VM_HUGETLB) && defined(MPS_OS_LI)
+#define VM_HUGETLB
+#endif
+
+
 #define MPS_VARIETY_STRING \
   MPS_ASSERT_STRING "." MPS_LOG_STRING "." MPS_STATS_STRING
 
@@ -345,6 +376,27 @@
 #define BUFFER_RANK_DEFAULT (mps_rank_exact())
 
 
+/* B-tree Land Configuration -- see <code/btree.c>
+ *
+ * BTREE_FANOUT is the maximum number of entries in a B-tree node.
+ * With eight entries, the array of base addresses that a search
+ * scans fits in a single 64-byte cache line on 64-bit platforms.  It
+ * must be even and at least 4 <design/btree#.node.fanout>.
+ */
+
+#define BTREE_FANOUT 8
+
+/* ARENA_BTREE_EXTEND_NODES is the number of nodes in each extension
+ * of the node pool of the arena's free land, when that is a B-tree.
+ * The arena extends the pool and then does an insertion and a
+ * deletion, each of which may need two nodes more than the height of
+ * the tree, and the height is at most 26 on 64-bit platforms, so 64
+ * nodes are always enough <design/arena#.free.btree.extend>.
+ */
+
+#define ARENA_BTREE_EXTEND_NODES 64
+
+
 /* Format defaults: see <code/format.c> */
 
 #define FMT_ALIGN_DEFAULT ((Align)MPS_PF_ALIGN)
@@ -363,17 +415,43 @@
 /* AMC treats objects larger than or equal to this as "Large" */
 #define AMC_LARGE_SIZE_DEFAULT ((Size)32768)
 #define AMC_EXTEND_BY_DEFAULT  ((Size)8192)
+/* Promote segments in place if survival estimate exceeds this; see
+ * <design/poolamc#.promote>. The default of 1.0 never promotes. */
+#define AMC_PROMOTE_SURVIVAL_DEFAULT 1.0
+/* Weight of each reclaimed segment in the survival estimate */
+#define AMC_SURVIVAL_ALPHA 0.2
+/* Condemn one in this many promotion candidates anyway */
+#define AMC_PROMOTE_SAMPLE 8
+/* Keep a table of object starts in each segment? */
+#define AMC_OBJECT_STARTS_DEFAULT FALSE
+/* Detect ramps automatically? See <design/poolamc#.ramp.auto>. */
+#define AMC_AUTO_RAMP_DEFAULT FALSE
+/* Enter an automatic ramp when the nursery survival estimate is at
+ * least this, and leave it when the estimate is at most this. */
+#define AMC_AUTO_RAMP_ENTER 0.5
+#define AMC_AUTO_RAMP_LEAVE 0.2
+/* Allocation is "busy" if its rate is at least this fraction of the
+ * moving average rate, which has this weight for each sample. */
+#define AMC_AUTO_RAMP_RATE 0.5
+#define AMC_AUTO_RAMP_ALPHA 0.25
+/* Number of consecutive samples needed to enter or leave a ramp */
+#define AMC_AUTO_RAMP_SAMPLES 3
 
 
 /* Pool AMS Configuration -- see <code/poolams.c> */
 
 #define AMS_SUPPORT_AMBIGUOUS_DEFAULT TRUE
+#define AMS_OBJECT_SIZE_DEFAULT ((Size)0)
 #define AMS_GEN_DEFAULT       0
+/* Free space (in bytes) up to which AMS keeps empty segments for reuse
+ * <design/poolams#.reclaim.cache> */
+#define AMS_SEG_CACHE_SIZE    ((Size)32 << 10)
 
 
 /* Pool AWL Configuration -- see <code/poolawl.c> */
 
 #define AWL_GEN_DEFAULT       0
+#define AWL_RECORD_SPLATS_DEFAULT FALSE
 #define AWL_HAVE_SEG_SA_LIMIT   TRUE
 #define AWL_SEG_SA_LIMIT        200     /* TODO: Improve guesswork with measurements */
 #define AWL_HAVE_TOTAL_SA_LIMIT FALSE
@@ -427,8 +505,32 @@
 
 #define ARENA_DEFAULT_COMMIT_LIMIT ((Size)-1)
 
+/* ARENA_DEFAULT_SOFT_LIMIT is the default soft limit, and
+ * ARENA_DEFAULT_SOFT_LIMIT_FRACTION the default fraction of the
+ * operating system's memory limit to use as a soft limit (zero means
+ * don't use the operating system's limit). See
+ * <design/arena#.soft-limit>. */
+
+#define ARENA_DEFAULT_SOFT_LIMIT ((Size)-1)
+#define ARENA_DEFAULT_SOFT_LIMIT_FRACTION 0.0
+
 #define ARENA_SPARE_DEFAULT     0.75
 
+/* ARENA_DEFAULT_SPARE_HALF_LIFE is the default time (in seconds) in
+ * which half of the spare committed memory is returned to the
+ * operating system, or 0 to keep it until the spare limit is
+ * exceeded. See <design/arena#.spare-committed.decay>. */
+
+#define ARENA_DEFAULT_SPARE_HALF_LIFE 0.0
+
+/* ARENA_ZEROED_RESERVE is the amount of spare committed memory that
+ * the arena tries to keep zeroed in advance, once a client has asked
+ * for zeroed memory; ARENA_ZEROED_STEP is the most it zeroes in one
+ * poll. See <design/arena#.spare-committed.zeroed>. */
+
+#define ARENA_ZEROED_RESERVE    ((Size)4 << 20)
+#define ARENA_ZEROED_STEP       ((Size)256 << 10)
+
 /* ARENA_DEFAULT_PAUSE_TIME is the maximum time (in seconds) that
  * operations within the arena may pause the mutator for.  The default
  * is set for typical human interaction.  See mps_arena_pause_time_set
@@ -437,6 +539,8 @@
 #define ARENA_DEFAULT_PAUSE_TIME (0.1)
 
 #define ARENA_DEFAULT_ZONED     TRUE
+#define ARENA_DEFAULT_FINE_ZONES FALSE
+#define ARENA_DEFAULT_FREE_BTREE FALSE
 
 /* ARENA_MINIMUM_COLLECTABLE_SIZE is the minimum size (in bytes) of
  * collectable memory that might be considered worthwhile to run a
@@ -462,6 +566,40 @@
 
 #define ARENA_MAX_COLLECT_FRACTION (0.1)
 
+/* ARENA_IDLE_PERIOD_MIN is the shortest period (in seconds) that the
+ * client may ask the idle collector to wake up with. Shorter periods
+ * would mean the idle collector competes with the mutator for the
+ * arena lock. See <design/arena#.idle>. */
+
+#define ARENA_IDLE_PERIOD_MIN (0.001)
+
+/* ArenaGCEventQueueLENGTH is the number of GC events that can be
+ * queued for the GC event hook between deliveries. Events beyond
+ * this are dropped. Each call to the hook happens when an MPS
+ * function leaves the arena, and a single call into the MPS rarely
+ * causes more than a start, flip and end per trace. See
+ * <design/message-gc#.hook.queue>. */
+
+#define ArenaGCEventQueueLENGTH 8
+
+/* Memory pressure thresholds, as fractions of the arena's limit
+ * (the lesser of the commit limit and the soft limit), used if the
+ * client installs a pressure handler without giving its own.
+ * ArenaPressureRELIEF is how far below the threshold that was crossed
+ * the client's pressure handler is asked to bring the memory in use.
+ * See <design/message-gc#.pressure.target>. */
+
+#define ARENA_DEFAULT_PRESSURE_MODERATE 0.8
+#define ARENA_DEFAULT_PRESSURE_CRITICAL 0.95
+#define ArenaPressureRELIEF 0.05
+
+/* ARENA_DEFAULT_NURSERY_CACHE_SIZE is the default size (in bytes) of
+ * the cache that the nursery generation of each chain is kept within,
+ * or zero if nursery memory is not recycled. See
+ * <design/strategy#.policy.nursery>. */
+
+#define ARENA_DEFAULT_NURSERY_CACHE_SIZE ((Size)0)
+
 /* ArenaDefaultZONESET is the zone set used by LocusPrefDEFAULT.
  *
  * TODO: This is left over from before branches 2014-01-29/mps-chain-zones
@@ -478,6 +616,8 @@
   FALSE,               /* high */ \
   ArenaDefaultZONESET, /* zoneSet */ \
   ZoneSetEMPTY,        /* avoid */ \
+  NULL,                /* base */ \
+  FALSE,               /* zeroed */ \
 }
 
 #define LDHistoryLENGTH ((Size)4)
@@ -487,6 +627,14 @@
 
 #define VM_ARENA_SIZE_DEFAULT ((Size)1 << 28)
 
+/* Default value of MPS_KEY_ARENA_SIZE for a VM arena created with
+ * MPS_KEY_ARENA_SINGLE_CHUNK. See <design/arena#.chunk.single>. */
+#if MPS_WORD_WIDTH == 64
+#define VM_ARENA_SINGLE_CHUNK_SIZE_DEFAULT ((Size)1 << 40)
+#else
+#define VM_ARENA_SINGLE_CHUNK_SIZE_DEFAULT ((Size)1 << 30)
+#endif
+
 
 /* Locus configuration -- see <code/locus.c> */
 
@@ -494,6 +642,21 @@
  * average computation of the mortality of a generation. */
 #define LocusMortalityALPHA (0.4)
 
+/* Weighting for the current observation, in the exponential moving
+ * averages of the collection rate and overhead of a generation. See
+ * <design/strategy#.policy.model>. */
+#define LocusRateALPHA (0.3)
+
+/* Maximum factor by which an adaptive generation's capacity may grow
+ * or shrink after a single collection. See
+ * <design/strategy#.policy.adapt>. */
+#define LocusAdaptRATIO (2.0)
+
+/* The number of recently freed address ranges that a nursery
+ * generation remembers for reuse. See
+ * <design/strategy#.policy.nursery.recycle>. */
+#define GenRecycleLENGTH 16
+
 
 /* Stack probe configuration -- see <code/sp*.c> */
 
@@ -518,6 +681,12 @@
 #define VMJunkBYTE ((unsigned char)0xA9)
 #define VMParamSize (sizeof(Word))
 
+/* Size of huge page requested by MPS_KEY_ARENA_HUGE_PAGES where the
+ * operating system supports them: the size of a page mapped by a
+ * single page-middle-directory entry on x86-64, and on AArch64 with
+ * 4 KiB pages. See <design/vm#.impl.ix.huge>. */
+#define VM_HUGE_PAGE_SIZE ((Size)2 << 20)
+
 
 /* .feature.li: Linux feature specification
  *
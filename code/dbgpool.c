@@ -673,6 +673,11 @@ static void TagWalk(Pool pool, ObjectsVisitor visitor, void *p)
     (*visitor)(tag->addr, tag->size, NULL, pool, &tag->userdata, p);
     node = SplayTreeNext(&debug->index, &tag->addr);
   }
+
+  /* Walking the tree in order with SplayTreeNext leaves it as a
+     linear list, so restore its balance for the next search
+     <design/splay#.function.splay.tree.balance>. */
+  SplayTreeBalance(&debug->index);
 }
 
 
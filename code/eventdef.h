@@ -37,7 +37,7 @@
 
 #define EVENT_VERSION_MAJOR  ((unsigned)2)
 #define EVENT_VERSION_MEDIAN ((unsigned)0)
-#define EVENT_VERSION_MINOR  ((unsigned)0)
+#define EVENT_VERSION_MINOR  ((unsigned)5)
 
 
 /* EVENT_LIST -- list of event types and general properties
@@ -61,7 +61,7 @@
  */
 
 #define EventNameMAX ((size_t)19)
-#define EventCodeMAX ((EventCode)0x005c)
+#define EventCodeMAX ((EventCode)0x0061)
 
 #define EVENT_LIST(EVENT, X) \
   /*       0123456789012345678 <- don't exceed without changing EventNameMAX */ \
@@ -156,7 +156,12 @@
   EVENT(X, VMFinish           , 0x0059,  TRUE, Arena) \
   EVENT(X, VMInit             , 0x005a,  TRUE, Arena) \
   EVENT(X, VMMap              , 0x005b,  TRUE, Seg) \
-  EVENT(X, VMUnmap            , 0x005c,  TRUE, Seg)
+  EVENT(X, VMUnmap            , 0x005c,  TRUE, Seg) \
+  EVENT(X, GenModel           , 0x005d,  TRUE, Trace) \
+  EVENT(X, GenCapacity        , 0x005e,  TRUE, Trace) \
+  EVENT(X, SoftLimitSet       , 0x005f,  TRUE, Arena) \
+  EVENT(X, PressureRelieved   , 0x0060,  TRUE, Arena) \
+  EVENT(X, AMCRamp            , 0x0061,  TRUE, Pool)
 
 
 /* Remember to update EventNameMAX and EventCodeMAX above!
@@ -314,6 +319,16 @@
   PARAM(X,  1, W, limit, "new commit limit") \
   PARAM(X,  2, U, res, "result code")
 
+#define EVENT_SoftLimitSet_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, W, limit, "new soft limit")
+
+#define EVENT_PressureRelieved_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, U, level, "pressure level reported") \
+  PARAM(X,  2, W, target, "size handler was asked to release") \
+  PARAM(X,  3, W, released, "size handler released")
+
 #define EVENT_EventClockSync_PARAMS(PARAM, X) \
   PARAM(X,  0, W, clock, "mps_clock() value")
 
@@ -326,6 +341,12 @@
   PARAM(X,  5, U, wordWidth, "MPS_WORD_WIDTH") \
   PARAM(X,  6, W, clocksPerSec, "mps_clocks_per_sec()")
 
+#define EVENT_GenCapacity_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "generation's arena") \
+  PARAM(X,  1, P, trace, "the trace that collected it") \
+  PARAM(X,  2, P, gen, "the generation") \
+  PARAM(X,  3, W, capacity, "new capacity in bytes")
+
 #define EVENT_GenFinish_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena, "generation's arena") \
   PARAM(X,  1, P, gen, "the generation") \
@@ -338,6 +359,16 @@
   PARAM(X,  3, W, capacity, "capacity in bytes") \
   PARAM(X,  4, D, mortality, "initial mortality estimate")
 
+#define EVENT_GenModel_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "generation's arena") \
+  PARAM(X,  1, P, trace, "the trace that collected it") \
+  PARAM(X,  2, P, gen, "the oldest generation condemned") \
+  PARAM(X,  3, W, work, "tracing work done by the trace") \
+  PARAM(X,  4, D, scanTime, "seconds spent advancing the trace") \
+  PARAM(X,  5, D, flipTime, "seconds spent flipping the trace") \
+  PARAM(X,  6, D, rate, "collection rate (moving average)") \
+  PARAM(X,  7, D, overhead, "collection overhead (moving average)")
+
 #define EVENT_GenZoneSet_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena, "generation's arena") \
   PARAM(X,  1, P, gen, "the generation") \
@@ -400,6 +431,12 @@
   PARAM(X,  2, P, poolClass, "pool's class") \
   PARAM(X,  3, U, serial, "pool's serial number within the arena")
 
+#define EVENT_AMCRamp_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, pool, "the pool") \
+  PARAM(X,  1, B, ramping, "entered ramp (else left it)?") \
+  PARAM(X,  2, D, survival, "nursery survival estimate") \
+  PARAM(X,  3, D, rate, "allocation rate (bytes/second)")
+
 #define EVENT_PoolInitAMCZ_PARAMS(PARAM, X) \
   PARAM(X,  0, P, pool, "the pool") \
   PARAM(X,  1, P, format, "pool's format")
@@ -31,6 +31,7 @@
  */
 
 #include "mpm.h"
+#include "poolmrg.h"
 #include "testlib.h"
 #include "mpslib.h"
 #include "mps.h"
@@ -139,6 +140,29 @@ static void register_indirect_tree(mps_word_t tree, mps_arena_t arena)
     }
 }
 
+/* register_batch_tree -- register a numbered tree all at once */
+
+static mps_addr_t batch[1 << maxtreeDEPTH];
+static size_t batch_count;
+
+static void collect_numbered_tree(mps_word_t tree)
+{
+    /* don't finalize ints */
+    if ((tree & 1) == 0) {
+        Insist(batch_count < NELEMS(batch));
+        batch[batch_count++] = (mps_addr_t)tree;
+        collect_numbered_tree(DYLAN_VECTOR_SLOT(tree, 0));
+        collect_numbered_tree(DYLAN_VECTOR_SLOT(tree, 1));
+    }
+}
+
+static void register_batch_tree(mps_word_t tree, mps_arena_t arena)
+{
+    batch_count = 0;
+    collect_numbered_tree(tree);
+    die(mps_finalize_many(arena, batch, batch_count), "mps_finalize_many");
+}
+
 static void *root[rootCOUNT];
 
 static void test_trees(int mode, const char *name, mps_arena_t arena,
@@ -199,6 +223,15 @@ static void test_trees(int mode, const char *name, mps_arena_t arena,
       Insist(free_size <= total_size);
       Insist(free_size + live_size <= total_size);
     }
+    if (reg == register_batch_tree) {
+      /* Fetch finalized objects in bulk. */
+      mps_addr_t refs[64];
+      size_t n;
+      while ((n = mps_finalization_get(arena, refs, NELEMS(refs))) > 0) {
+        Insist(n <= NELEMS(refs));
+        final_this_time += n;
+      }
+    }
     while (mps_message_queue_type(&type, arena)) {
       mps_message_t message;
       cdie(mps_message_get(&message, arena, type), "message_get");
@@ -258,11 +291,95 @@ static void test_pool(int mode, mps_arena_t arena, mps_chain_t chain,
              register_numbered_tree);
   test_trees(mode, "indirect", arena, pool, ap, make_indirect_tree,
              register_indirect_tree);
+  test_trees(mode, "batch", arena, pool, ap, make_numbered_tree,
+             register_batch_tree);
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(mps_root);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(fmt);
+}
+
+
+/* test_migrate -- guardians follow their referents to older generations
+ *
+ * <design/poolmrg#.migrate>.
+ */
 
+static void test_migrate(mps_arena_t arena)
+{
+  mps_gen_param_s params[2] = { { 1024, 0.5 }, { 1024, 0.5 } };
+  mps_chain_t chain;
+  mps_fmt_t fmt;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t mps_root;
+  mps_message_t message;
+  mps_word_t obj;
+  Pool finalPool;
+  size_t i, finals;
+
+  mps_arena_park(arena);
+  die(mps_chain_create(&chain, arena, NELEMS(params), params),
+      "chain_create\n");
+  die(mps_fmt_create_A(&fmt, arena, dylan_fmt_A()), "fmt_create\n");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, fmt);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create\n");
+  } MPS_ARGS_END(args);
+  die(mps_root_create_table(&mps_root, arena, mps_rank_exact(), (mps_rm_t)0,
+                            root, (size_t)rootCOUNT),
+      "root_create\n");
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create\n");
+
+  for (i = 0; i < rootCOUNT; ++i) {
+    die(make_dylan_vector(&obj, ap, 1), "make_dylan_vector");
+    root[i] = (void *)obj;
+    die(mps_finalize(arena, &root[i]), "finalize\n");
+  }
+  finalPool = arena->finalPool;
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 0)) == rootCOUNT);
+
+  /* The survivors are promoted to generation 1, and their guardians
+   * follow them when the collection ends, without any more
+   * registrations. */
+  die(mps_arena_collect(arena), "collect\n");
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 0)) == 0);
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 1)) == rootCOUNT);
+
+  /* A new registration goes to the nursery. The next collection
+   * finalizes it, since it is unreachable, and moves the other
+   * guardians up a generation again. */
+  die(make_dylan_vector(&obj, ap, 1), "make_dylan_vector");
+  die(mps_finalize(arena, (mps_addr_t *)&obj), "finalize\n");
+  obj = 0;
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 0)) == 1);
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 1)) == rootCOUNT);
+  die(mps_arena_collect(arena), "collect\n");
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 0)) == 0);
+  Insist(MRGGuardianCount(finalPool, ChainGen(chain, 1)) == 0);
+  Insist(MRGGuardianCount(finalPool, &arena->topGen) == rootCOUNT);
+
+  /* Migrated guardians still finalize their objects. */
+  for (i = 0; i < rootCOUNT; ++i)
+    root[i] = NULL;
+  die(mps_arena_collect(arena), "collect\n");
+  finals = 0;
+  while (mps_message_get(&message, arena, mps_message_type_finalization())) {
+    ++ finals;
+    mps_message_discard(arena, message);
+  }
+  Insist(finals == rootCOUNT + 1);
+
+  mps_arena_park(arena);
   mps_ap_destroy(ap);
   mps_root_destroy(mps_root);
   mps_pool_destroy(pool);
   mps_fmt_destroy(fmt);
+  mps_chain_destroy(chain);
+  mps_arena_release(arena);
 }
 
 
@@ -309,6 +426,7 @@ int main(int argc, char *argv[])
 
   test_mode(ModePOLL, arena, chain);
   test_mode(ModePARK, arena, NULL);
+  test_migrate(arena);
 
   mps_arena_park(arena);
   mps_chain_destroy(chain);
@@ -57,6 +57,7 @@ static unsigned pinleaf = FALSE;  /* are leaf objects pinned at start */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
 static double spare = ARENA_SPARE_DEFAULT; /* spare commit fraction */
+static size_t nursery_cache_size = ARENA_DEFAULT_NURSERY_CACHE_SIZE;
 
 typedef struct gcthread_s *gcthread_t;
 
@@ -68,14 +69,16 @@ struct gcthread_s {
     mps_root_t reg_root;
     mps_ap_t ap;
     gcthread_fn_t fn;
+    unsigned long allocs;       /* number of objects allocated */
 };
 
 typedef mps_word_t obj_t;
 
-static obj_t mkvector(mps_ap_t ap, size_t n)
+static obj_t mkvector(gcthread_t thread, size_t n)
 {
   mps_word_t v;
-  RESMUST(make_dylan_vector(&v, ap, n));
+  RESMUST(make_dylan_vector(&v, thread->ap, n));
+  ++thread->allocs;
   return v;
 }
 
@@ -90,15 +93,15 @@ static void aset(obj_t v, size_t i, obj_t val)
 }
 
 /* mktree - make a tree of nodes with depth d. */
-static obj_t mktree(mps_ap_t ap, unsigned d, obj_t leaf)
+static obj_t mktree(gcthread_t thread, unsigned d, obj_t leaf)
 {
   obj_t tree;
   size_t i;
   if (d <= 0)
     return leaf;
-  tree = mkvector(ap, width);
+  tree = mkvector(thread, width);
   for (i = 0; i < width; ++i) {
-    aset(tree, i, mktree(ap, d - 1, leaf));
+    aset(tree, i, mktree(thread, d - 1, leaf));
   }
   return tree;
 }
@@ -120,7 +123,7 @@ static obj_t random_subtree(obj_t tree, unsigned levels)
  * NOTE: Changing preuse will dramatically change how much work
  * is done.  In particular, if preuse==1, the old tree is returned
  * unchanged. */
-static obj_t new_tree(mps_ap_t ap, obj_t oldtree, unsigned d)
+static obj_t new_tree(gcthread_t thread, obj_t oldtree, unsigned d)
 {
   obj_t subtree;
   size_t i;
@@ -129,9 +132,9 @@ static obj_t new_tree(mps_ap_t ap, obj_t oldtree, unsigned d)
   } else {
     if (d == 0)
       return objNULL;
-    subtree = mkvector(ap, width);
+    subtree = mkvector(thread, width);
     for (i = 0; i < width; ++i) {
-      aset(subtree, i, new_tree(ap, oldtree, d - 1));
+      aset(subtree, i, new_tree(thread, oldtree, d - 1));
     }
   }
   return subtree;
@@ -140,22 +143,22 @@ static obj_t new_tree(mps_ap_t ap, obj_t oldtree, unsigned d)
 /* Update tree to be identical tree but with nodes reallocated
  * with probability pupdate.  This avoids writing to vector slots
  * if unnecessary. */
-static obj_t update_tree(mps_ap_t ap, obj_t oldtree, unsigned d)
+static obj_t update_tree(gcthread_t thread, obj_t oldtree, unsigned d)
 {
   obj_t tree;
   size_t i;
   if (oldtree == objNULL || d == 0)
     return oldtree;
   if (rnd_double() < pupdate) {
-    tree = mkvector(ap, width);
+    tree = mkvector(thread, width);
     for (i = 0; i < width; ++i) {
-      aset(tree, i, update_tree(ap, aref(oldtree, i), d - 1));
+      aset(tree, i, update_tree(thread, aref(oldtree, i), d - 1));
     }
   } else {
     tree = oldtree;
     for (i = 0; i < width; ++i) {
       obj_t oldsubtree = aref(oldtree, i);
-      obj_t subtree = update_tree(ap, oldsubtree, d - 1);
+      obj_t subtree = update_tree(thread, oldsubtree, d - 1);
       if (subtree != oldsubtree) {
         aset(tree, i, subtree);
       }
@@ -167,15 +170,14 @@ static obj_t update_tree(mps_ap_t ap, obj_t oldtree, unsigned d)
 static void *gc_tree(gcthread_t thread)
 {
   unsigned i, j;
-  mps_ap_t ap = thread->ap;
-  obj_t leaf = pinleaf ? mktree(ap, 1, objNULL) : objNULL;
+  obj_t leaf = pinleaf ? mktree(thread, 1, objNULL) : objNULL;
   for (i = 0; i < niter; ++i) {
-    obj_t tree = mktree(ap, depth, leaf);
+    obj_t tree = mktree(thread, depth, leaf);
     for (j = 0 ; j < npass; ++j) {
       if (preuse < 1.0)
-        tree = new_tree(ap, tree, depth);
+        tree = new_tree(thread, tree, depth);
       if (pupdate > 0.0)
-        tree = update_tree(ap, tree, depth);
+        tree = update_tree(thread, tree, depth);
     }
   }
   return NULL;
@@ -197,42 +199,63 @@ static void *start(void *p)
   return NULL;
 }
 
-static void weave(gcthread_fn_t fn)
+/* weave -- run the benchmark in nthreads threads and return the
+ * total number of objects allocated */
+static unsigned long weave(gcthread_fn_t fn)
 {
   gcthread_t threads = alloca(sizeof(threads[0]) * nthreads);
+  unsigned long allocs = 0;
   unsigned t;
 
   for (t = 0; t < nthreads; ++t) {
     gcthread_t thread = &threads[t];
     thread->fn = fn;
+    thread->allocs = 0;
     testthr_create(&thread->thread, start, thread);
   }
 
-  for (t = 0; t < nthreads; ++t)
+  for (t = 0; t < nthreads; ++t) {
     testthr_join(&threads[t].thread, NULL);
+    allocs += threads[t].allocs;
+  }
+  return allocs;
 }
 
-static void weave1(gcthread_fn_t fn)
+static unsigned long weave1(gcthread_fn_t fn)
 {
   gcthread_t thread = alloca(sizeof(thread[0]));
 
   thread->fn = fn;
+  thread->allocs = 0;
   start(thread);
+  return thread->allocs;
 }
 
 
+/* watch -- run the benchmark and report the processor time taken,
+ * and the elapsed cycles per allocation (measured using the telemetry
+ * clock, which counts processor cycles on most platforms; see
+ * <code/clock.h>). */
+
 static void watch(gcthread_fn_t fn, const char *name)
 {
   clock_t begin, end;
+  EventClock cyclesBegin, cyclesEnd;
+  unsigned long allocs;
 
   begin = clock();
+  EVENT_CLOCK(cyclesBegin);
   if (nthreads == 1)
-    weave1(fn);
+    allocs = weave1(fn);
   else
-    weave(fn);
+    allocs = weave(fn);
+  EVENT_CLOCK(cyclesEnd);
   end = clock();
 
   printf("%s: %g\n", name, (double)(end - begin) / CLOCKS_PER_SEC);
+  if (allocs > 0)
+    printf("%s: %lu allocations, %g cycles per allocation\n", name, allocs,
+           (double)(cyclesEnd - cyclesBegin) / (double)allocs);
 }
 
 
@@ -248,6 +271,7 @@ static void arena_setup(gcthread_fn_t fn,
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
     MPS_ARGS_ADD(args, MPS_KEY_SPARE, spare);
+    MPS_ARGS_ADD(args, MPS_KEY_NURSERY_CACHE_SIZE, nursery_cache_size);
     RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
   RESMUST(dylan_fmt(&format, arena));
@@ -291,6 +315,7 @@ static struct option longopts[] = {
   {"arena-unzoned",    no_argument,       NULL, 'z'},
   {"pause-time",       required_argument, NULL, 'P'},
   {"spare",            required_argument, NULL, 'S'},
+  {"nursery-cache",    required_argument, NULL, 'n'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -316,7 +341,7 @@ int main(int argc, char *argv[])
 
   seed = rnd_seed();
 
-  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:S:",
+  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:S:n:",
                            longopts, NULL)) != -1)
     switch (ch) {
     case 't':
@@ -413,6 +438,20 @@ int main(int argc, char *argv[])
     case 'S':
       spare = strtod(optarg, NULL);
       break;
+    case 'n': {
+        char *p;
+        nursery_cache_size = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': nursery_cache_size <<= 30; break;
+        case 'M': nursery_cache_size <<= 20; break;
+        case 'K': nursery_cache_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad nursery cache size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -462,6 +501,8 @@ int main(int argc, char *argv[])
               "    Maximum pause time in seconds (default %f)\n"
               "  -S f, --spare\n"
               "    Maximum spare committed fraction (default %f)\n"
+              "  -n c, --nursery-cache=c[KMG]\n"
+              "    Recycle nursery memory within cache size c\n"
               "Tests:\n"
               "  amc   pool class AMC\n"
               "  ams   pool class AMS\n"
@@ -52,6 +52,20 @@ static void arenaReleaseRingLock(void)
 }
 
 
+/* arenaLeaveWithoutHooks -- leave the arena without calling hooks
+ *
+ * For use where the client's GC event hook must not be called, for
+ * example while the arena ring lock is held, or from a protection
+ * fault handler. Any queued events stay queued until the next call to
+ * ArenaLeave. <design/message-gc#.hook.deliver.not>.
+ */
+
+static void arenaLeaveWithoutHooks(Arena arena)
+{
+  ArenaLeaveLock(arena, FALSE);
+}
+
+
 /* GlobalsClaimAll -- claim all MPS locks
  * <design/thread-safety#.sol.fork.lock>
  */
@@ -68,7 +82,7 @@ void GlobalsClaimAll(void)
 
 void GlobalsReleaseAll(void)
 {
-  GlobalsArenaMap(ArenaLeave);
+  GlobalsArenaMap(arenaLeaveWithoutHooks);
   arenaReleaseRingLock();
   LockReleaseGlobalRecursive();
 }
@@ -80,6 +94,9 @@ static void arenaReinitLock(Arena arena)
   AVERT(Arena, arena);
   ShieldLeave(arena);
   LockInit(ArenaGlobals(arena)->lock);
+  /* The idle collector's thread doesn't exist in the child process.
+   * Its structure is freed with the control pool. */
+  arena->idle = NULL;
 }
 
 /* GlobalsReinitializeAll -- reinitialize all MPS locks, and leave the
@@ -128,7 +145,7 @@ static void arenaDenounce(Arena arena)
 
   /* Temporarily give up the arena lock to avoid deadlock, */
   /* see <design/thread-safety#.deadlock>. */
-  ArenaLeave(arena);
+  arenaLeaveWithoutHooks(arena);
 
   /* Detach the arena from the global list. */
   arenaClaimRingLock();
@@ -192,6 +209,16 @@ Bool GlobalsCheck(Globals arenaGlobals)
   CHECKD_NOSIG(Ring, &arena->messageRing);
   if (arena->enabledMessageTypes != NULL)
     CHECKD_NOSIG(BT, arena->enabledMessageTypes);
+  /* gcEventHook and gcEventClosure are arbitrary */
+  CHECKL(arena->gcEventCount <= ArenaGCEventQueueLENGTH);
+  /* pressureHandler and pressureClosure are arbitrary */
+  CHECKL(0.0 < arena->pressureModerate);
+  CHECKL(arena->pressureModerate <= arena->pressureCritical);
+  CHECKL(arena->pressureCritical <= 1.0);
+  CHECKL(arena->pressureLevel < PressureLIMIT);
+  CHECKL(arena->pressurePending < PressureLIMIT);
+  CHECKL(BoolCheck(arena->pressureAsked));
+  CHECKL(BoolCheck(arena->pressureDelivering));
   CHECKL(BoolCheck(arena->isFinalPool));
   if (arena->isFinalPool) {
     CHECKD(Pool, arena->finalPool);
@@ -227,6 +254,10 @@ Bool GlobalsCheck(Globals arenaGlobals)
   CHECKL(arena->tracedWork >= 0.0);
   CHECKL(arena->tracedTime >= 0.0);
   /* no check for arena->lastWorldCollect (Clock) */
+  if (arena->idle != NULL)
+    CHECKD_NOSIG(Idle, arena->idle);
+  CHECKL(arena->idleFillMutatorSize >= 0.0);
+  /* no check for arena->idleSince (Clock) */
 
   /* can't write a check for arena->epoch */
   CHECKD(History, ArenaHistory(arena));
@@ -319,6 +350,21 @@ Res GlobalsInit(Globals arenaGlobals)
   RingInit(&arena->messageRing);
   arena->enabledMessageTypes = NULL;
   arena->droppedMessages = 0;
+  arena->gcEventHook = NULL;
+  arena->gcEventClosure = NULL;
+  arena->gcEventCount = 0;
+  arena->droppedGCEvents = 0;
+  arena->pressureHandler = NULL;
+  arena->pressureClosure = NULL;
+  arena->pressureModerate = ARENA_DEFAULT_PRESSURE_MODERATE;
+  arena->pressureCritical = ARENA_DEFAULT_PRESSURE_CRITICAL;
+  arena->pressureLevel = PressureNONE;
+  arena->pressurePending = PressureNONE;
+  arena->pressureTarget = 0;
+  arena->pressureAsked = FALSE;
+  arena->pressureDelivering = FALSE;
+  arena->pressureCredit = 0;
+  arena->pressureReleased = 0;
   arena->isFinalPool = FALSE;
   arena->finalPool = NULL;
   arena->busyTraces = TraceSetEMPTY;    /* <code/trace.c> */
@@ -326,6 +372,9 @@ Res GlobalsInit(Globals arenaGlobals)
   arena->tracedWork = 0.0;
   arena->tracedTime = 0.0;
   arena->lastWorldCollect = ClockNow();
+  arena->idle = NULL;
+  arena->idleFillMutatorSize = 0.0;
+  arena->idleSince = arena->lastWorldCollect;
   ShieldInit(ArenaShield(arena));
 
   for (ti = 0; ti < TraceLIMIT; ++ti) {
@@ -435,6 +484,7 @@ void GlobalsFinish(Globals arenaGlobals)
 
   arena = GlobalsArena(arenaGlobals);
   AVERT(Globals, arenaGlobals);
+  AVER(arena->idle == NULL); /* mps_arena_destroy stops it */
 
   arenaGlobals->sig = SigInvalid;
 
@@ -592,12 +642,59 @@ void ArenaEnterRecursive(Arena arena)
   ArenaEnterLock(arena, TRUE);
 }
 
-/* ArenaLeave -- leave the state where you can look at MPM data structures */
+/* ArenaLeave -- leave the state where you can look at MPM data structures
+ *
+ * Any GC events queued while the arena was entered are passed to the
+ * client's hook after the lock is released, so that the hook can call
+ * the MPS. <design/message-gc#.hook.deliver>.
+ */
 
 void ArenaLeave(Arena arena)
 {
+  (void)ArenaLeaveRelieved(arena);
+}
+
+
+/* ArenaLeaveRelieved -- leave the arena and report memory pressure
+ *
+ * As ArenaLeave, but also calls the client's pressure handler, if
+ * there is pressure to report, and returns the size that the handler
+ * says it released (zero if it wasn't called).
+ * <design/message-gc#.pressure.deliver>.
+ */
+
+Size ArenaLeaveRelieved(Arena arena)
+{
+  GCEventStruct events[ArenaGCEventQueueLENGTH];
+  GCEventHook hook;
+  void *closure;
+  Count i, count;
+  PressureHandler handler;
+  void *handlerClosure;
+  PressureLevel level;
+  Size target, released;
+  Bool pressure;
+
   AVERT(Arena, arena);
+  if (arena->gcEventCount == 0 && arena->pressurePending == PressureNONE) {
+    ArenaLeaveLock(arena, FALSE);
+    return 0;
+  }
+
+  count = ArenaGCEventsTake(events, &hook, &closure, arena);
+  pressure = ArenaPressureTake(&level, &target, &handler, &handlerClosure,
+                               arena);
   ArenaLeaveLock(arena, FALSE);
+  for (i = 0; i < count; ++i)
+    (*hook)(arena, &events[i], closure);
+  if (!pressure)
+    return 0;
+
+  released = (*handler)(arena, level, target, handlerClosure);
+  ArenaEnter(arena);
+  ArenaPressureRelieved(arena, level, target, released);
+  ArenaLeave(arena);
+  return released;
 }
 
 void ArenaLeaveLock(Arena arena, Bool recursive)
@@ -675,7 +772,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
            or a fault in a nested exception handler: nothing to do now. */
       }
       EVENT1(ArenaAccessEnd, arena);
-      ArenaLeave(arena);
+      arenaLeaveWithoutHooks(arena);
       return TRUE;
     } else if (RootOfAddr(&root, arena, addr)) {
       arenaReleaseRingLock();
@@ -683,7 +780,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
       if (mode != AccessSetEMPTY)
         RootAccess(root, mode);
       EVENT1(ArenaAccessEnd, arena);
-      ArenaLeave(arena);
+      arenaLeaveWithoutHooks(arena);
       return TRUE;
     } else {
       /* No segment or root was found at the address: this must mean
@@ -691,7 +788,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
        * via a signal or exception handler) caused the segment or root
        * to go away. So there's nothing to do now. */
       EVENT1(ArenaAccessEnd, arena);
-      ArenaLeave(arena);
+      arenaLeaveWithoutHooks(arena);
     }
   }
 
@@ -754,6 +851,9 @@ void (ArenaPoll)(Globals globals)
     ArenaAccumulateTime(arena, start, ClockNow());
   }
 
+  ArenaSpareDecay(arena);
+  ArenaZeroSpare(arena);
+
   EVENT2(ArenaPollEnd, arena, BOOLOF(workWasDone));
 
   globals->insidePoll = FALSE;
@@ -803,21 +903,157 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
         if (!PolicyStartTrace(&trace, &worldCollected, arena, FALSE))
           break;
       }
+      /* Don't charge the start of the trace to advancing it. */
+      now = ClockNow();
     }
     TraceAdvance(trace);
+    {
+      Clock advanceStart = now;
+      now = ClockNow();
+      trace->advanceTime += now - advanceStart;
+    }
     if (trace->state == TraceFINISHED)
       TraceDestroyFinished(trace);
     workWasDone = TRUE;
-    now = ClockNow();
   } while (now < intervalEnd);
 
   if (workWasDone) {
     ArenaAccumulateTime(arena, start, now);
   }
 
+  ArenaSpareDecay(arena);
+  ArenaZeroSpare(arena);
+
   return workWasDone;
 }
 
+/* ArenaIdleStart -- start the idle collector
+ *
+ * Called with the arena lock held. The thread can't do anything
+ * until the lock is released. <design/arena#.idle>.
+ */
+
+Res ArenaIdleStart(Arena arena, double period)
+{
+  void *p;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(period >= ARENA_IDLE_PERIOD_MIN);
+
+  if (arena->idle != NULL)
+    return ResOK;
+
+  res = ControlAlloc(&p, arena, IdleSize());
+  if (res != ResOK)
+    return res;
+  res = IdleInit(p, arena, period);
+  if (res != ResOK) {
+    ControlFree(arena, p, IdleSize());
+    return res;
+  }
+  arena->idle = p;
+  arena->idleFillMutatorSize = ArenaGlobals(arena)->fillMutatorSize;
+  arena->idleSince = ClockNow();
+  return ResOK;
+}
+
+
+/* ArenaIdleStop -- stop the idle collector, if there is one
+ *
+ * Must be called without the arena lock, because it waits for the
+ * idle collector's thread to exit, and the thread might be waiting
+ * for the lock. The thread notices that arena->idle has changed, so
+ * it does no more work after this has detached it.
+ */
+
+void ArenaIdleStop(Arena arena)
+{
+  Idle idle;
+
+  ArenaEnter(arena);
+  idle = arena->idle;
+  arena->idle = NULL;
+  ArenaLeave(arena);
+
+  if (idle == NULL)
+    return;
+  IdleFinish(idle);
+
+  ArenaEnter(arena);
+  ControlFree(arena, idle, IdleSize());
+  ArenaLeave(arena);
+}
+
+
+/* arenaIdleActive -- has the mutator been active since the last check?
+ *
+ * The mutator is considered active if it has filled a buffer, that
+ * is, allocated anything other than from the inline allocation
+ * point fast path.
+ */
+
+static Bool arenaIdleActive(Arena arena)
+{
+  Globals globals = ArenaGlobals(arena);
+  if (globals->fillMutatorSize == arena->idleFillMutatorSize)
+    return FALSE;
+  arena->idleFillMutatorSize = globals->fillMutatorSize;
+  arena->idleSince = ClockNow();
+  return TRUE;
+}
+
+
+/* ArenaIdle -- do collection work while the mutator is idle
+ *
+ * Called by the idle collector's thread, without the arena lock,
+ * each time its period elapses. If the mutator hasn't been active
+ * since the last call, do collection work as ArenaStep does, one
+ * quantum at a time, releasing the arena lock between quanta so that
+ * the mutator isn't held up if it wakes. When there is no more work
+ * to do, return the spare committed memory to the operating system.
+ * <design/arena#.idle.work>.
+ *
+ * The idle thread is internal to the MPS, so it leaves the arena
+ * without calling the client's GC event hook or pressure handler.
+ * Anything it queues is delivered by the next client call.
+ * <design/message-gc#.hook.deliver.not>.
+ */
+
+void ArenaIdle(Arena arena, Idle idle)
+{
+  Globals globals;
+
+  AVERT(Idle, idle);
+
+  ArenaEnter(arena);
+  globals = ArenaGlobals(arena);
+  while (arena->idle == idle && !globals->clamped
+         && !arenaIdleActive(arena) && !IdleStopping(idle))
+  {
+    double interval = arena->pauseTime;
+    double idleTime = (double)(ClockNow() - arena->idleSince)
+      / (double)ClocksPerSec();
+    double multiplier = 1.0;
+
+    /* Assume the mutator stays idle for as long again, and allow the
+     * policy to collect the world if it would finish in that time. */
+    if (interval > 0.0 && idleTime > interval)
+      multiplier = idleTime / interval;
+    if (!ArenaStep(globals, interval, multiplier)) {
+      if (arena->spareCommitted > 0)
+        (void)Method(Arena, arena, purgeSpare)(arena, arena->spareCommitted);
+      break;
+    }
+
+    /* Let the mutator in. */
+    arenaLeaveWithoutHooks(arena);
+    ArenaEnter(arena);
+  }
+  arenaLeaveWithoutHooks(arena);
+}
+
+
 /* ArenaFinalize -- registers an object for finalization
  *
  * <design/finalize>.  */
@@ -846,6 +1082,33 @@ Res ArenaFinalize(Arena arena, Ref obj)
 }
 
 
+/* ArenaFinalizeMany -- registers an array of objects for finalization
+ *
+ * Either all the objects are registered, or none of them are. The
+ * references are read from the array through the barrier, since it
+ * may be in memory managed by the MPS. <design/finalize#.int.finalize-many>.
+ */
+
+Res ArenaFinalizeMany(Arena arena, Ref *refs, Count count)
+{
+  Res res;
+  Index i;
+
+  AVERT(Arena, arena);
+  AVER(refs != NULL || count == 0);
+
+  for (i = 0; i < count; ++i) {
+    res = ArenaFinalize(arena, ArenaPeek(arena, &refs[i]));
+    if (res != ResOK) {
+      if (i > 0)
+        MRGRegisterUndo(arena->finalPool, i);
+      return res;
+    }
+  }
+  return ResOK;
+}
+
+
 /* ArenaDefinalize -- removes one finalization registration of an object
  *
  * <design/finalize>.  */
@@ -0,0 +1,89 @@
+/* idle.h: IDLE COLLECTOR THREAD INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: An idle collector is a thread, managed by the MPS, that
+ * wakes up periodically and calls ArenaIdle to do collection work if
+ * the mutator has been idle. See <design/arena#.idle>.
+ */
+
+#ifndef idle_h
+#define idle_h
+
+#include "mpmtypes.h"
+
+
+#define IdleSig         ((Sig)0x5191D1E0) /* SIGnature IDLE */
+
+
+/* IdleSize -- return the size of an IdleStruct */
+
+extern Size IdleSize(void);
+
+
+/* IdleInit -- initialize an idle collector and start its thread
+ *
+ * The thread calls ArenaIdle(arena, idle) every period seconds until
+ * IdleFinish is called. Returns ResUNIMPL if the platform can't
+ * create threads, or another result code if creating the thread
+ * failed.
+ */
+
+extern Res IdleInit(Idle idle, Arena arena, double period);
+
+
+/* IdleFinish -- stop the thread and finish the idle collector
+ *
+ * Waits for the thread to exit, so it must not be called with the
+ * arena lock held.
+ */
+
+extern void IdleFinish(Idle idle);
+
+
+/* IdleCheck -- check the consistency of an idle collector */
+
+extern Bool IdleCheck(Idle idle);
+
+
+/* IdleStopping -- has IdleFinish been called?
+ *
+ * ArenaIdle calls this between units of work, so that the idle
+ * collector stops promptly.
+ */
+
+extern Bool IdleStopping(Idle idle);
+
+
+#endif /* idle_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,82 @@
+/* idlean.c: ANSI IDLE COLLECTOR
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This is a non-functional implementation of the idle
+ * collector interface (idle.h), for platforms where the MPS can't
+ * create threads. IdleInit always fails, so none of the other
+ * functions are ever called.
+ */
+
+#include "mpm.h"
+
+SRCID(idlean, "$Id$");
+
+
+Size IdleSize(void)
+{
+  return sizeof(Sig);
+}
+
+
+Res IdleInit(Idle idle, Arena arena, double period)
+{
+  AVER(idle != NULL);
+  AVERT(Arena, arena);
+  AVER(period > 0.0);
+  return ResUNIMPL;
+}
+
+
+void IdleFinish(Idle idle)
+{
+  UNUSED(idle);
+  NOTREACHED;
+}
+
+
+Bool IdleCheck(Idle idle)
+{
+  UNUSED(idle);
+  NOTREACHED;
+  return FALSE;
+}
+
+
+Bool IdleStopping(Idle idle)
+{
+  UNUSED(idle);
+  NOTREACHED;
+  return TRUE;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
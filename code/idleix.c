@@ -0,0 +1,221 @@
+/* idleix.c: IDLE COLLECTOR FOR POSIX SYSTEMS
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .posix: The implementation uses POSIX threads, and should be
+ * reusable for many Unix-like operating systems.
+ *
+ * .design: <design/arena#.idle>. The thread waits on a condition
+ * variable with a timeout of the period, so that IdleFinish can wake
+ * it immediately.
+ *
+ * .signals: The thread blocks all signals, so that signals directed
+ * at the process are delivered to the client's threads, which have
+ * handlers for them. The thread is not registered with the arena, so
+ * it is never suspended, and its stack is not scanned: it must not
+ * hold references to objects in automatically managed pools.
+ */
+
+#include "mpm.h"
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_LI) && !defined(MPS_OS_XC)
+#error "idleix.c is specific to MPS_OS_FR, MPS_OS_LI or MPS_OS_XC"
+#endif
+
+#include "idle.h"
+
+#include <errno.h> /* ETIMEDOUT */
+#include <pthread.h> /* see .feature.li in config.h */
+#include <signal.h> /* sigfillset, pthread_sigmask */
+#include <time.h> /* clock_gettime */
+
+SRCID(idleix, "$Id$");
+
+
+/* IdleStruct -- the idle collector structure */
+
+typedef struct IdleStruct {
+  Sig sig;                      /* design.mps.sig.field */
+  Arena arena;                  /* arena to collect */
+  double period;                /* seconds between calls to ArenaIdle */
+  Bool stopping;                /* has IdleFinish been called? */
+  pthread_mutex_t mut;          /* protects stopping */
+  pthread_cond_t cond;          /* signalled when stopping is set */
+  pthread_t thread;             /* the idle collector thread */
+} IdleStruct;
+
+
+Size IdleSize(void)
+{
+  return sizeof(IdleStruct);
+}
+
+
+Bool IdleCheck(Idle idle)
+{
+  CHECKS(Idle, idle);
+  /* Can't check arena: IdleCheck may be called without its lock. */
+  CHECKL(idle->period > 0.0);
+  CHECKL(BoolCheck(idle->stopping));
+  return TRUE;
+}
+
+
+/* idleWait -- wait for the period, or until stopping
+ *
+ * Returns TRUE if the idle collector is stopping.
+ */
+
+static Bool idleWait(Idle idle)
+{
+  struct timespec deadline;
+  double seconds;
+  Bool stopping;
+  int res;
+
+  res = clock_gettime(CLOCK_REALTIME, &deadline);
+  AVER(res == 0);
+  seconds = (double)deadline.tv_nsec / 1e9 + idle->period;
+  deadline.tv_sec += (time_t)seconds;
+  deadline.tv_nsec = (long)((seconds - (double)(time_t)seconds) * 1e9);
+
+  res = pthread_mutex_lock(&idle->mut);
+  AVER(res == 0);
+  while (!idle->stopping) {
+    res = pthread_cond_timedwait(&idle->cond, &idle->mut, &deadline);
+    if (res == ETIMEDOUT)
+      break;
+    AVER(res == 0);
+  }
+  stopping = idle->stopping;
+  res = pthread_mutex_unlock(&idle->mut);
+  AVER(res == 0);
+  return stopping;
+}
+
+
+/* idleMain -- main function of the idle collector thread */
+
+static void *idleMain(void *p)
+{
+  Idle idle = p;
+
+  while (!idleWait(idle))
+    ArenaIdle(idle->arena, idle);
+  return NULL;
+}
+
+
+Res IdleInit(Idle idle, Arena arena, double period)
+{
+  sigset_t all, old;
+  int res;
+
+  AVER(idle != NULL);
+  AVERT(Arena, arena);
+  AVER(period > 0.0);
+
+  idle->arena = arena;
+  idle->period = period;
+  idle->stopping = FALSE;
+  res = pthread_mutex_init(&idle->mut, NULL);
+  if (res != 0)
+    goto failMutex;
+  res = pthread_cond_init(&idle->cond, NULL);
+  if (res != 0)
+    goto failCond;
+  idle->sig = IdleSig;
+  AVERT(Idle, idle);
+
+  /* The new thread inherits the signal mask. See .signals. */
+  res = sigfillset(&all);
+  AVER(res == 0);
+  res = pthread_sigmask(SIG_SETMASK, &all, &old);
+  AVER(res == 0);
+  res = pthread_create(&idle->thread, NULL, idleMain, idle);
+  (void)pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if (res != 0)
+    goto failThread;
+
+  return ResOK;
+
+failThread:
+  idle->sig = SigInvalid;
+  (void)pthread_cond_destroy(&idle->cond);
+failCond:
+  (void)pthread_mutex_destroy(&idle->mut);
+failMutex:
+  return ResRESOURCE;
+}
+
+
+void IdleFinish(Idle idle)
+{
+  int res;
+
+  AVERT(Idle, idle);
+
+  res = pthread_mutex_lock(&idle->mut);
+  AVER(res == 0);
+  idle->stopping = TRUE;
+  res = pthread_cond_signal(&idle->cond);
+  AVER(res == 0);
+  res = pthread_mutex_unlock(&idle->mut);
+  AVER(res == 0);
+
+  res = pthread_join(idle->thread, NULL);
+  AVER(res == 0);
+
+  idle->sig = SigInvalid;
+  res = pthread_cond_destroy(&idle->cond);
+  AVER(res == 0);
+  res = pthread_mutex_destroy(&idle->mut);
+  AVER(res == 0);
+}
+
+
+Bool IdleStopping(Idle idle)
+{
+  Bool stopping;
+  int res;
+
+  AVERT(Idle, idle);
+
+  res = pthread_mutex_lock(&idle->mut);
+  AVER(res == 0);
+  stopping = idle->stopping;
+  res = pthread_mutex_unlock(&idle->mut);
+  AVER(res == 0);
+  return stopping;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,238 @@
+/* idletest.c: IDLE COLLECTOR TEST
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Check that the idle collector collects the world and
+ * returns the spare committed memory to the operating system when
+ * the mutator stops allocating, and that it can be stopped, and
+ * stopped by mps_arena_destroy, and that it doesn't call the GC event
+ * hook from its own thread. <design/arena#.idle>.
+ *
+ * Loosely based on <code/amcss.c>.
+ */
+
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "testlib.h"
+#include "mpslib.h"
+#include "mpscamc.h"
+#include "mpsavm.h"
+#include "mps.h"
+
+#include <stdio.h> /* printf */
+
+
+#define testArenaSIZE   ((size_t)16 << 20)
+#define exactRootsCOUNT 100
+#define objCOUNT        100000
+#define idlePERIOD      0.01    /* seconds between idle checks */
+#define idleTIMEOUT     10      /* seconds to wait for the idle collector */
+#define genCOUNT        2
+
+static mps_gen_param_s testChain[genCOUNT] = {
+  { 1024, 0.85 }, { 4096, 0.45 } };
+
+/* objNULL needs to be odd so that it's ignored in exactRoots. */
+#define objNULL         ((mps_addr_t)MPS_WORD_CONST(0xDECEA5ED))
+
+static mps_addr_t exactRoots[exactRootsCOUNT];
+static volatile unsigned long hookCalls = 0;
+
+
+/* hook -- GC event hook that counts the events delivered */
+
+static void hook(mps_arena_t arena, const mps_gc_event_s *event,
+                 void *closure)
+{
+  testlib_unused(arena);
+  testlib_unused(event);
+  testlib_unused(closure);
+  ++hookCalls;
+}
+
+
+/* make -- allocate one object */
+
+static mps_addr_t make(mps_ap_t ap)
+{
+  size_t length = rnd() % 10;
+  size_t size = (length + 2) * sizeof(mps_word_t);
+  mps_addr_t p;
+  mps_res_t res;
+
+  do {
+    MPS_RESERVE_BLOCK(res, p, ap, size);
+    if (res)
+      die(res, "MPS_RESERVE_BLOCK");
+    res = dylan_init(p, size, exactRoots, exactRootsCOUNT);
+    if (res)
+      die(res, "dylan_init");
+  } while (!mps_commit(ap, p, size));
+
+  return p;
+}
+
+
+/* churn -- allocate objects, keeping a few of them alive */
+
+static void churn(mps_ap_t ap)
+{
+  unsigned long i;
+  for (i = 0; i < objCOUNT; ++i)
+    exactRoots[rnd() % exactRootsCOUNT] = make(ap);
+}
+
+
+/* waitQuiet -- wait without entering the MPS until the idle collector
+ * has started a collection, and check that it didn't deliver the
+ * events to the hook itself, but left them for the next client call
+ * <design/message-gc#.hook.deliver.not>
+ */
+
+static void waitQuiet(mps_arena_t arena, mps_word_t collections)
+{
+  unsigned long calls = hookCalls;
+  mps_clock_t timeout = mps_clock()
+    + (mps_clock_t)idleTIMEOUT * mps_clocks_per_sec();
+
+  while (mps_collections(arena) == collections) {
+    if (mps_clock() > timeout)
+      error("idle collector did nothing in %d seconds", idleTIMEOUT);
+  }
+  Insist(hookCalls == calls);
+  (void)mps_arena_spare_committed(arena); /* enter and leave the arena */
+  Insist(hookCalls > calls);
+  printf("Hook called %lu times after the idle collector started.\n",
+         hookCalls - calls);
+}
+
+
+/* waitIdle -- wait without allocating until the idle collector has
+ * collected and purged the spare committed memory
+ */
+
+static void waitIdle(mps_arena_t arena, mps_word_t collections)
+{
+  mps_clock_t start = mps_clock();
+  mps_clock_t timeout = start + (mps_clock_t)idleTIMEOUT * mps_clocks_per_sec();
+
+  while (mps_collections(arena) == collections
+         || mps_arena_spare_committed(arena) > 0)
+  {
+    if (mps_clock() > timeout)
+      error("idle collector did nothing in %d seconds", idleTIMEOUT);
+  }
+  printf("Idle collector did %lu collections in %.3f seconds.\n",
+         (unsigned long)(mps_collections(arena) - collections),
+         (double)(mps_clock() - start) / (double)mps_clocks_per_sec());
+}
+
+
+static void test(mps_arena_t arena)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  mps_res_t res;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+  for (i = 0; i < exactRootsCOUNT; ++i)
+    exactRoots[i] = objNULL;
+  die(mps_root_create_table_masked(&root, arena, mps_rank_exact(),
+                                   (mps_rm_t)0, &exactRoots[0],
+                                   exactRootsCOUNT, (mps_word_t)1),
+      "root_create_table");
+
+  res = mps_arena_idle_start(arena, idlePERIOD);
+  if (res == MPS_RES_UNIMPL) {
+    printf("No idle collector on this platform.\n");
+  } else {
+    mps_word_t collections;
+    die(res, "idle_start");
+    mps_arena_gc_event_hook_set(arena, hook, NULL);
+    churn(ap);
+    collections = mps_collections(arena);
+    waitQuiet(arena, collections);
+    waitIdle(arena, collections);
+
+    /* Stop and start again. */
+    mps_arena_idle_stop(arena);
+    mps_arena_idle_stop(arena);
+    die(mps_arena_idle_start(arena, idlePERIOD), "idle_start again");
+    die(mps_arena_idle_start(arena, idlePERIOD), "idle_start running");
+    churn(ap);
+    waitIdle(arena, mps_collections(arena));
+    /* Leave it running: mps_arena_destroy stops it. */
+  }
+
+  mps_arena_park(arena);
+  mps_root_destroy(root);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+  mps_thr_t thread;
+
+  testlib_init(argc, argv);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  test(arena);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
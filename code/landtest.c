@@ -3,12 +3,18 @@
  * $Id$
  * Copyright (c) 2001-2020 Ravenbrook Limited.  See end of file for license.
  *
- * Test all three Land implementations against duplicate operations on
+ * Test all four Land implementations against duplicate operations on
  * a bit-table.
  *
- * Test the "steal" operations on a CBS.
+ * Test the "steal" operations on a CBS and a B-tree.
+ *
+ * Compare LandFindInZones on zoned CBS and B-tree.
+ *
+ * Compare the speed of the CBS and B-tree classes on the same
+ * sequence of operations.
  */
 
+#include "btree.h"
 #include "cbs.h"
 #include "failover.h"
 #include "freelist.h"
@@ -20,15 +26,17 @@
 #include "testlib.h"
 
 #include <stdio.h> /* printf */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
 
 SRCID(landtest, "$Id$");
 
 
 #define ArraySize ((Size)123456)
 
-/* CBS is much faster than Freelist, so we apply more operations to
- * the former. */
+/* CBS and B-tree are much faster than Freelist, so we apply more
+ * operations to the former. */
 #define nCBSOperations ((Size)125000)
+#define nBTOperations ((Size)125000)
 #define nFLOperations ((Size)12500)
 #define nFOOperations ((Size)12500)
 
@@ -441,15 +449,24 @@ static void test_land(void)
     {CBSFastClassGet, 3},
     {CBSZonedClassGet, 3},
   };
+  static const struct {
+    LandClass (*klass)(void);
+    unsigned operations;
+  } btreeConfig[] = {
+    {BTreeClassGet, 3},
+    {BTreeZonedClassGet, 3},
+  };
   mps_arena_t mpsArena;
   Arena arena;
   TestStateStruct state;
   void *p;
   MFSStruct blockPool;
   CBSStruct cbsStruct;
+  BTreeStruct btreeStruct;
   FreelistStruct flStruct;
   FailoverStruct foStruct;
   Land cbs = CBSLand(&cbsStruct);
+  Land btree = BTreeLand(&btreeStruct);
   Land fl = FreelistLand(&flStruct);
   Land fo = FailoverLand(&foStruct);
   Pool mfs = MFSPool(&blockPool);
@@ -490,7 +507,18 @@ static void test_land(void)
     LandFinish(cbs);
   }
 
-  /* 2. Test Freelist */
+  /* 2. Test B-tree */
+
+  for (i = 0; i < NELEMS(btreeConfig); ++i) {
+    die((mps_res_t)LandInit(btree, btreeConfig[i].klass(), arena,
+                            state.align, NULL, mps_args_none),
+        "failed to initialise B-tree");
+    state.land = btree;
+    test(&state, nBTOperations, btreeConfig[i].operations);
+    LandFinish(btree);
+  }
+
+  /* 3. Test Freelist */
 
   die((mps_res_t)LandInit(fl, CLASS(Freelist), arena, state.align,
                           NULL, mps_args_none),
@@ -499,7 +527,7 @@ static void test_land(void)
   test(&state, nFLOperations, 3);
   LandFinish(fl);
 
-  /* 3. Test CBS-failing-over-to-Freelist (always failing over on
+  /* 4. Test CBS-failing-over-to-Freelist (always failing over on
    * first iteration, never failing over on second; see fotest.c for a
    * test case that randomly switches fail-over on and off)
    */
@@ -562,14 +590,20 @@ static void shuffle(Addr *addr, size_t n)
   }
 }
 
-static void test_steal(void)
+static void test_steal(LandClass klass)
 {
   mps_arena_t mpsArena;
   Arena arena;
-  MFSStruct mfs;                /* stores blocks for the CBS */
+  MFSStruct mfs;                /* stores blocks for the land */
   Pool pool = MFSPool(&mfs);
-  CBSStruct cbs;                /* allocated memory land */
-  Land land = CBSLand(&cbs);
+  union {
+    CBSStruct cbs;
+    BTreeStruct btree;
+  } landUnion;                  /* allocated memory land */
+  Bool isBTree = IsSubclass(klass, BTree);
+  Land land = isBTree ? BTreeLand(&landUnion.btree)
+                      : CBSLand(&landUnion.cbs);
+  Size unitSize = isBTree ? sizeof(BTreeNodeStruct) : sizeof(RangeTreeStruct);
   Addr base;
   Addr addr[4096];
   Size grainSize;
@@ -582,15 +616,18 @@ static void test_steal(void)
   grainSize = ArenaGrainSize(arena);
 
   MPS_ARGS_BEGIN(args) {
-    MPS_ARGS_ADD(args, MPS_KEY_MFS_UNIT_SIZE, sizeof(RangeTreeStruct));
+    MPS_ARGS_ADD(args, MPS_KEY_MFS_UNIT_SIZE, unitSize);
     MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, grainSize);
     MPS_ARGS_ADD(args, MFSExtendSelf, FALSE);
     die(PoolInit(pool, arena, CLASS(MFSPool), args), "pool");
   } MPS_ARGS_END(args);
 
   MPS_ARGS_BEGIN(args) {
-    MPS_ARGS_ADD(args, CBSBlockPool, pool);
-    die(LandInit(land, CLASS(CBS), arena, grainSize, NULL, args),
+    if (isBTree)
+      MPS_ARGS_ADD(args, BTreeNodePool, pool);
+    else
+      MPS_ARGS_ADD(args, CBSBlockPool, pool);
+    die(LandInit(land, klass, arena, grainSize, NULL, args),
         "land");
   } MPS_ARGS_END(args);
 
@@ -636,15 +673,227 @@ static void test_steal(void)
   mps_arena_destroy(arena);
   Insist(stolenInsert <= missingDelete);
   Insist(missingDelete < n);
-  printf("Stolen on insert: %"PRIuLONGEST"\n", (ulongest_t)stolenInsert);
-  printf("Missing on delete: %"PRIuLONGEST"\n", (ulongest_t)missingDelete);
+  printf("%s stolen on insert: %"PRIuLONGEST"\n",
+         ClassName(klass), (ulongest_t)stolenInsert);
+  printf("%s missing on delete: %"PRIuLONGEST"\n",
+         ClassName(klass), (ulongest_t)missingDelete);
+}
+
+
+/* test_zones -- compare LandFindInZones on CBS and B-tree
+ *
+ * Applies the same operations to a zoned CBS and a zoned B-tree, and
+ * checks that they find the same ranges.
+ */
+
+#define nZonesOperations ((Size)20000)
+#define zonesLIVE 1024
+#define zonesSTRIPES 8
+
+static void test_zones(void)
+{
+  mps_arena_t mpsArena;
+  Arena arena;
+  CBSStruct cbsStruct;
+  BTreeStruct btreeStruct;
+  Land cbs = CBSLand(&cbsStruct);
+  Land btree = BTreeLand(&btreeStruct);
+  RangeStruct live[zonesLIVE];
+  RangeStruct range, cbsRange, btreeRange, cbsOld, btreeOld;
+  Align align = MPS_PF_ALIGN;
+  Size stripe, blockSize;
+  Count nLive = 0, nFound = 0;
+  void *p;
+  Size op;
+  Res res;
+
+  die(mps_arena_create(&mpsArena, mps_arena_class_vm(), testArenaSIZE),
+      "mps_arena_create");
+  arena = (Arena)mpsArena; /* avoid pun */
+  stripe = ArenaStripeSize(arena);
+  blockSize = stripe * zonesSTRIPES;
+  die((mps_res_t)ControlAlloc(&p, arena, blockSize + stripe),
+      "failed to allocate block");
+
+  die((mps_res_t)LandInit(cbs, CLASS(CBSZoned), arena, align, NULL,
+                          mps_args_none), "failed to initialise CBS");
+  die((mps_res_t)LandInit(btree, CLASS(BTreeZoned), arena, align, NULL,
+                          mps_args_none), "failed to initialise B-tree");
+  RangeInitSize(&range, AddrAlignUp(p, stripe), blockSize);
+  die((mps_res_t)LandInsert(&cbsOld, cbs, &range), "LandInsert");
+  die((mps_res_t)LandInsert(&btreeOld, btree, &range), "LandInsert");
+
+  for (op = 0; op < nZonesOperations; ++op) {
+    Word r = rnd();
+    Size size = (1 + (r >> 8) % (stripe / align / 4)) * align;
+    if (r % 4 == 0 && nLive < zonesLIVE) {
+      ZoneSet zoneSet = (ZoneSet)rnd_addr();
+      Bool high = (r >> 2) % 2, cbsFound, btreeFound;
+      res = LandFindInZones(&cbsFound, &cbsRange, &cbsOld, cbs, size,
+                            zoneSet, high);
+      die((mps_res_t)res, "LandFindInZones");
+      res = LandFindInZones(&btreeFound, &btreeRange, &btreeOld, btree,
+                            size, zoneSet, high);
+      die((mps_res_t)res, "LandFindInZones");
+      Insist(cbsFound == btreeFound);
+      if (cbsFound) {
+        Insist(RangesEqual(&cbsRange, &btreeRange));
+        Insist(RangesEqual(&cbsOld, &btreeOld));
+        RangeCopy(&live[nLive], &cbsRange);
+        ++ nLive;
+        ++ nFound;
+      }
+    } else if (nLive == 0 || (nLive < zonesLIVE && r % 2 == 0)) {
+      Bool cbsFound = LandFindFirst(&cbsRange, &cbsOld, cbs, size,
+                                    FindDeleteLOW);
+      Bool btreeFound = LandFindFirst(&btreeRange, &btreeOld, btree, size,
+                                      FindDeleteLOW);
+      Insist(cbsFound == btreeFound);
+      if (cbsFound) {
+        Insist(RangesEqual(&cbsRange, &btreeRange));
+        RangeCopy(&live[nLive], &cbsRange);
+        ++ nLive;
+      }
+    } else {
+      Index j = (r >> 8) % nLive;
+      die((mps_res_t)LandInsert(&cbsOld, cbs, &live[j]), "LandInsert");
+      die((mps_res_t)LandInsert(&btreeOld, btree, &live[j]), "LandInsert");
+      Insist(RangesEqual(&cbsOld, &btreeOld));
+      -- nLive;
+      RangeCopy(&live[j], &live[nLive]);
+    }
+    Insist(LandSize(cbs) == LandSize(btree));
+  }
+
+  LandFinish(btree);
+  LandFinish(cbs);
+  ControlFree(arena, p, blockSize + stripe);
+  mps_arena_destroy(arena);
+  printf("Found in zones: %"PRIuLONGEST"\n", (ulongest_t)nFound);
+}
+
+
+/* test_bench -- compare the speed of CBS and B-tree
+ *
+ * Runs the same sequence of operations on each class: first-fit
+ * allocation with LandFindFirst, occasional LandFindLargest, and
+ * freeing with LandInsert, as a manual pool would, until there are
+ * benchLIVE blocks allocated, then keeping about that many. The lands
+ * must end up in the same state.
+ */
+
+#define nBenchOperations ((Size)250000)
+#define benchLIVE 4096
+#define benchSIZE_MAX 64
+
+typedef struct BenchStateStruct {
+  Count ranges;
+  Size size;
+} BenchStateStruct, *BenchState;
+
+static Bool benchVisitor(Land land, Range range, void *closure)
+{
+  BenchState bench = closure;
+  testlib_unused(land);
+  ++ bench->ranges;
+  bench->size += RangeSize(range);
+  return TRUE;
+}
+
+static void test_bench(void)
+{
+  static const struct {
+    LandClass (*klass)(void);
+  } benchConfig[] = {
+    {CBSFastClassGet},
+    {CBSZonedClassGet},
+    {BTreeClassGet},
+    {BTreeZonedClassGet},
+  };
+  mps_arena_t mpsArena;
+  Arena arena;
+  union {
+    CBSStruct cbs;
+    BTreeStruct btree;
+  } landUnion;
+  RangeStruct live[benchLIVE];
+  BenchStateStruct expected = {0, 0};
+  rnd_state_t seed;
+  Align align = MPS_PF_ALIGN;
+  Size blockSize = (Size)benchLIVE * benchSIZE_MAX * align * 2;
+  void *p;
+  Addr block;
+  size_t i;
+
+  die(mps_arena_create(&mpsArena, mps_arena_class_vm(), testArenaSIZE),
+      "mps_arena_create");
+  arena = (Arena)mpsArena; /* avoid pun */
+  die((mps_res_t)ControlAlloc(&p, arena, blockSize + align),
+      "failed to allocate block");
+  block = AddrAlignUp(p, align);
+  seed = rnd_state();
+
+  for (i = 0; i < NELEMS(benchConfig); ++i) {
+    LandClass klass = benchConfig[i].klass();
+    Land land = IsSubclass(klass, BTree) ? BTreeLand(&landUnion.btree)
+                                         : CBSLand(&landUnion.cbs);
+    BenchStateStruct bench = {0, 0};
+    RangeStruct range, oldRange;
+    Count nLive = 0;
+    clock_t start, finish;
+    Size op;
+
+    rnd_state_set(seed);
+    die((mps_res_t)LandInit(land, klass, arena, align, NULL, mps_args_none),
+        "failed to initialise land");
+    RangeInitSize(&range, block, blockSize);
+    die((mps_res_t)LandInsert(&oldRange, land, &range), "LandInsert");
+
+    start = clock();
+    for (op = 0; op < nBenchOperations; ++op) {
+      Word r = rnd();
+      if (r % 64 == 0) {
+        Bool b = LandFindLargest(&range, &oldRange, land, align,
+                                 FindDeleteNONE);
+        Insist(b);
+      } else if (nLive == 0 || (nLive < benchLIVE && r % 3 != 0)) {
+        Size size = (1 + (r >> 8) % benchSIZE_MAX) * align;
+        if (LandFindFirst(&live[nLive], &oldRange, land, size,
+                          FindDeleteLOW))
+          ++ nLive;
+      } else {
+        Index j = (r >> 8) % nLive;
+        die((mps_res_t)LandInsert(&oldRange, land, &live[j]), "LandInsert");
+        -- nLive;
+        RangeCopy(&live[j], &live[nLive]);
+      }
+    }
+    finish = clock();
+
+    (void)LandIterate(land, benchVisitor, &bench);
+    if (i == 0)
+      expected = bench;
+    Insist(bench.ranges == expected.ranges);
+    Insist(bench.size == expected.size);
+    printf("%s: %"PRIuLONGEST" operations in %.3f s, %"PRIuLONGEST
+           " ranges\n", ClassName(klass), (ulongest_t)nBenchOperations,
+           (double)(finish - start) / CLOCKS_PER_SEC,
+           (ulongest_t)bench.ranges);
+    LandFinish(land);
+  }
+
+  ControlFree(arena, p, blockSize + align);
+  mps_arena_destroy(arena);
 }
 
 int main(int argc, char *argv[])
 {
   testlib_init(argc, argv);
   test_land();
-  test_steal();
+  test_steal(CLASS(CBS));
+  test_steal(CLASS(BTree));
+  test_zones();
+  test_bench();
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
 }
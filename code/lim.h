@@ -0,0 +1,76 @@
+/* lim.h: MEMORY LIMIT INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ */
+
+#ifndef lim_h
+#define lim_h
+
+#include "mpmtypes.h"
+
+
+/* MemoryLimit -- find the operating system's memory limit
+ *
+ * This function should find the amount of main memory that the
+ * operating system allows the process to use before it starts
+ * failing requests or killing the process (for example, the limit
+ * on the control group that the process belongs to on Linux). If
+ * there is such a limit, it should set *limitReturn to it and return
+ * ResOK. If it has determined that there is no limit, it should set
+ * *limitReturn to SizeMAX and return ResOK. If it can't determine
+ * the limit, it should return ResFAIL, and if the platform has no
+ * way to find the limit, ResUNIMPL.
+ *
+ * See <design/arena#.soft-limit.os>.
+ */
+
+extern Res MemoryLimit(Size *limitReturn);
+
+
+/* MemoryLimitParse, MemoryLimitCgroup -- parse Linux cgroup files
+ *
+ * These parse the contents of a cgroup's memory limit file and of
+ * /proc/self/cgroup respectively, for MemoryLimit. They are
+ * external so that they can be tested on fixed strings (limtest.c).
+ * See <code/limli.c>.
+ */
+
+#if defined(MPS_OS_LI)
+extern Bool MemoryLimitParse(Size *limitReturn, const char *s, Bool v1);
+extern Bool MemoryLimitCgroup(Bool *v1Return, const char **pathReturn,
+                              Size *pathLengthReturn, const char *cgroups);
+#endif
+
+
+#endif /* lim_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,361 @@
+/* limli.c: MEMORY LIMIT (LINUX)
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This is the implementation of the memory limit interface
+ * (lim.h) for Linux. The limit is the memory limit of the control
+ * group (cgroup) that the process belongs to, which is how container
+ * runtimes limit the memory of a container. Exceeding it gets the
+ * process killed by the kernel's out-of-memory killer.
+ *
+ * .source: The cgroup of the process is read from /proc/self/cgroup,
+ * in which each line has the form "hierarchy-ID:controllers:path".
+ * See cgroups(7).
+ *
+ * .v2: In the unified hierarchy (cgroup version 2) the line has
+ * hierarchy-ID 0 and no controllers, and the limit is in the file
+ * memory.max in the cgroup's directory under /sys/fs/cgroup, which
+ * contains "max" if there is no limit. The limits of the ancestors
+ * of the cgroup apply too, so the least of them is taken.
+ *
+ * .v1: In the legacy hierarchy (cgroup version 1) the line for the
+ * memory controller has "memory" in its controllers, and the limit is
+ * in the file memory.limit_in_bytes in the cgroup's directory under
+ * /sys/fs/cgroup/memory. This includes the limits of the ancestors.
+ * If there is no limit, it contains a very large number.
+ *
+ * .namespace: Inside a container, /proc/self/cgroup may show the
+ * path of the cgroup on the host, while /sys/fs/cgroup has the
+ * container's own cgroup at its root. So the root of the hierarchy is
+ * always tried too.
+ *
+ * .no-stdio: The files are read with open(2) and read(2) rather than
+ * the C library's stdio, which the MPS doesn't otherwise depend on.
+ */
+
+#include "mpm.h"
+
+#if !defined(MPS_OS_LI)
+#error "limli.c is specific to MPS_OS_LI"
+#endif
+
+#include "lim.h"
+
+#include <errno.h> /* errno, EINTR */
+#include <fcntl.h> /* open, O_RDONLY */
+#include <unistd.h> /* close, read */
+
+SRCID(limli, "$Id$");
+
+
+#define limBufSIZE ((Size)4096) /* size of buffers for paths and files */
+#define limRootV2 "/sys/fs/cgroup"
+#define limRootV1 "/sys/fs/cgroup/memory"
+#define limFileV2 "/memory.max"
+#define limFileV1 "/memory.limit_in_bytes"
+
+/* .v1.none: Version 1 reports no limit as the largest number of pages
+ * that fits in a signed 64-bit counter, times the page size. On 32-bit
+ * platforms this doesn't fit in a Size, so MemoryLimitParse saturates
+ * it. */
+#if MPS_WORD_WIDTH == 64
+#define limNoLimitV1 ((Size)1 << 62)
+#else
+#define limNoLimitV1 SizeMAX
+#endif
+
+
+/* limRead -- read a small file into a buffer as a string */
+
+static Bool limRead(char *buf, Size size, const char *path)
+{
+  int fd;
+  Size length = 0;
+  ssize_t n;
+
+  AVER(buf != NULL);
+  AVER(size > 0);
+  AVER(path != NULL);
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return FALSE;
+  do {
+    n = read(fd, buf + length, size - 1 - length);
+    if (n > 0)
+      length += (Size)n;
+  } while ((n > 0 && length < size - 1) || (n < 0 && errno == EINTR));
+  (void)close(fd);
+  if (n < 0)
+    return FALSE;
+  buf[length] = '\0';
+  return TRUE;
+}
+
+
+/* limAppend -- append a string of given length to a buffer */
+
+static Bool limAppend(char *buf, Size size, Size *lengthIO,
+                      const char *s, Size n)
+{
+  Size length = *lengthIO;
+  Index i;
+
+  if (n >= size - length)
+    return FALSE;
+  for (i = 0; i < n; ++i)
+    buf[length + i] = s[i];
+  buf[length + n] = '\0';
+  *lengthIO = length + n;
+  return TRUE;
+}
+
+
+/* MemoryLimitParse -- parse the contents of a limit file
+ *
+ * The contents are "max" (.v2) or a decimal number, followed by
+ * optional white space. A number too large for a Size saturates. If
+ * v1 is TRUE, a number of at least limNoLimitV1 means that there is
+ * no limit (.v1.none). Returns FALSE if the contents are malformed.
+ */
+
+Bool MemoryLimitParse(Size *limitReturn, const char *s, Bool v1)
+{
+  Size limit = 0;
+
+  AVER(limitReturn != NULL);
+  AVER(s != NULL);
+  AVERT(Bool, v1);
+
+  if (s[0] == 'm' && s[1] == 'a' && s[2] == 'x') {
+    limit = SizeMAX;
+    s += 3;
+  } else {
+    if (*s < '0' || *s > '9')
+      return FALSE;
+    for (; '0' <= *s && *s <= '9'; ++s) {
+      Size digit = (Size)(*s - '0');
+      if (limit > (SizeMAX - digit) / 10)
+        limit = SizeMAX; /* saturate */
+      else
+        limit = limit * 10 + digit;
+    }
+    if (v1 && limit >= limNoLimitV1)
+      limit = SizeMAX;
+  }
+  while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r')
+    ++ s;
+  if (*s != '\0')
+    return FALSE;
+  *limitReturn = limit;
+  return TRUE;
+}
+
+
+/* limReadLimit -- read the limit from root, path and file */
+
+static Bool limReadLimit(Size *limitReturn, const char *root,
+                         const char *path, Size pathLength,
+                         const char *file, Bool v1)
+{
+  char name[limBufSIZE], contents[64];
+  Size length = 0;
+
+  if (!limAppend(name, sizeof name, &length, root, StringLength(root))
+      || !limAppend(name, sizeof name, &length, path, pathLength)
+      || !limAppend(name, sizeof name, &length, file, StringLength(file)))
+    return FALSE;
+  return limRead(contents, sizeof contents, name)
+    && MemoryLimitParse(limitReturn, contents, v1);
+}
+
+
+/* limCgroupV2 -- find the limit in the unified hierarchy (.v2) */
+
+static Res limCgroupV2(Size *limitReturn, const char *path, Size pathLength)
+{
+  Size limit = SizeMAX, value;
+  Bool found = FALSE;
+
+  for (;;) {
+    /* Strip the trailing slash, so that the root is the empty path. */
+    if (pathLength > 0 && path[pathLength - 1] == '/')
+      -- pathLength;
+    if (limReadLimit(&value, limRootV2, path, pathLength, limFileV2,
+                     FALSE)) {
+      found = TRUE;
+      if (value < limit)
+        limit = value;
+    }
+    if (pathLength == 0)
+      break;
+    /* Move to the parent cgroup. */
+    while (pathLength > 0 && path[pathLength - 1] != '/')
+      -- pathLength;
+  }
+
+  if (!found)
+    return ResFAIL;
+  *limitReturn = limit;
+  return ResOK;
+}
+
+
+/* limCgroupV1 -- find the limit in the legacy hierarchy (.v1) */
+
+static Res limCgroupV1(Size *limitReturn, const char *path, Size pathLength)
+{
+  Size limit;
+
+  if (pathLength > 0 && path[pathLength - 1] == '/')
+    -- pathLength;
+  if (!limReadLimit(&limit, limRootV1, path, pathLength, limFileV1, TRUE)
+      && !limReadLimit(&limit, limRootV1, "", 0, limFileV1, TRUE))
+    return ResFAIL;
+  *limitReturn = limit;
+  return ResOK;
+}
+
+
+/* limHasMemory -- do the controllers include the memory controller? */
+
+static Bool limHasMemory(const char *controllers, Size length)
+{
+  Index i = 0;
+
+  while (i < length) {
+    Index start = i;
+    while (i < length && controllers[i] != ',')
+      ++ i;
+    if (i - start == 6
+        && controllers[start] == 'm' && controllers[start + 1] == 'e'
+        && controllers[start + 2] == 'm' && controllers[start + 3] == 'o'
+        && controllers[start + 4] == 'r' && controllers[start + 5] == 'y')
+      return TRUE;
+    ++ i;
+  }
+  return FALSE;
+}
+
+
+/* MemoryLimitCgroup -- find the memory cgroup of the process
+ *
+ * Parses the contents of /proc/self/cgroup (.source). If there is a
+ * line for the memory controller in the legacy hierarchy, sets
+ * *v1Return to TRUE and *pathReturn and *pathLengthReturn to that
+ * line's path; otherwise if there is a line for the unified
+ * hierarchy, sets *v1Return to FALSE and returns its path. In a
+ * hybrid hierarchy, the memory controller is in version 1. Returns
+ * FALSE if there is no such line or a line is malformed. The path is
+ * not terminated.
+ */
+
+Bool MemoryLimitCgroup(Bool *v1Return, const char **pathReturn,
+                       Size *pathLengthReturn, const char *cgroups)
+{
+  const char *line, *v1Path = NULL, *v2Path = NULL;
+  Size v1Length = 0, v2Length = 0;
+
+  AVER(v1Return != NULL);
+  AVER(pathReturn != NULL);
+  AVER(pathLengthReturn != NULL);
+  AVER(cgroups != NULL);
+
+  line = cgroups;
+  while (*line != '\0') {
+    const char *id = line, *controllers, *path;
+    Size idLength, controllersLength, pathLength;
+
+    for (idLength = 0; id[idLength] != ':'; ++idLength)
+      if (id[idLength] == '\0' || id[idLength] == '\n')
+        return FALSE;
+    controllers = id + idLength + 1;
+    for (controllersLength = 0; controllers[controllersLength] != ':';
+         ++controllersLength)
+      if (controllers[controllersLength] == '\0'
+          || controllers[controllersLength] == '\n')
+        return FALSE;
+    path = controllers + controllersLength + 1;
+    for (pathLength = 0;
+         path[pathLength] != '\0' && path[pathLength] != '\n';
+         ++pathLength)
+      NOOP;
+
+    if (idLength == 1 && id[0] == '0' && controllersLength == 0) {
+      v2Path = path;
+      v2Length = pathLength;
+    } else if (limHasMemory(controllers, controllersLength)) {
+      v1Path = path;
+      v1Length = pathLength;
+    }
+
+    line = path + pathLength;
+    if (*line == '\n')
+      ++ line;
+  }
+
+  if (v1Path != NULL) {
+    *v1Return = TRUE;
+    *pathReturn = v1Path;
+    *pathLengthReturn = v1Length;
+    return TRUE;
+  }
+  if (v2Path != NULL) {
+    *v1Return = FALSE;
+    *pathReturn = v2Path;
+    *pathLengthReturn = v2Length;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+
+/* MemoryLimit -- find the operating system's memory limit */
+
+Res MemoryLimit(Size *limitReturn)
+{
+  char cgroups[limBufSIZE];
+  const char *path;
+  Size pathLength;
+  Bool v1;
+
+  AVER(limitReturn != NULL);
+
+  if (!limRead(cgroups, sizeof cgroups, "/proc/self/cgroup")
+      || !MemoryLimitCgroup(&v1, &path, &pathLength, cgroups))
+    return ResFAIL;
+  if (v1)
+    return limCgroupV1(limitReturn, path, pathLength);
+  return limCgroupV2(limitReturn, path, pathLength);
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,171 @@
+/* limtest.c: MEMORY LIMIT PARSER TEST
+ *
+ * $Id$
+ * Copyright (c) 2020 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Check that the parsers for the Linux cgroup files that
+ * MemoryLimit reads handle the forms that the kernel writes, and
+ * reject malformed contents. <code/limli.c>.
+ */
+
+#include "mpm.h"
+#include "lim.h"
+#include "testlib.h"
+
+#include <stdio.h> /* printf */
+#include <string.h> /* strncmp */
+
+
+#if defined(MPS_OS_LI)
+
+/* checkParse -- check that MemoryLimitParse gets the expected limit */
+
+static void checkParse(const char *s, Bool v1, Size expected)
+{
+  Size limit = 0;
+  Insist(MemoryLimitParse(&limit, s, v1));
+  Insist(limit == expected);
+}
+
+
+static void testParse(void)
+{
+  Size limit;
+
+  /* Version 2 has "max" for no limit. */
+  checkParse("max\n", FALSE, SizeMAX);
+  checkParse("max", FALSE, SizeMAX);
+
+  /* Numeric limits, with or without trailing white space. */
+  checkParse("536870912\n", FALSE, (Size)536870912);
+  checkParse("536870912\n", TRUE, (Size)536870912);
+  checkParse("4096 \r\n", FALSE, (Size)4096);
+  checkParse("0\n", FALSE, (Size)0);
+
+  /* Version 1 has the largest number of pages in a signed 64-bit
+     counter for no limit. */
+  checkParse("9223372036854771712\n", TRUE, SizeMAX);
+  /* In version 2, a large number is a limit (saturated on 32-bit). */
+  if (MPS_WORD_WIDTH == 64) {
+    Size large = ((Size)1 << (MPS_WORD_WIDTH - 1)) - 4096;
+    checkParse("9223372036854771712\n", FALSE, large);
+  } else {
+    checkParse("9223372036854771712\n", FALSE, SizeMAX);
+  }
+  checkParse("99999999999999999999999999\n", FALSE, SizeMAX);
+
+  /* Malformed and empty contents. */
+  Insist(!MemoryLimitParse(&limit, "", FALSE));
+  Insist(!MemoryLimitParse(&limit, "\n", TRUE));
+  Insist(!MemoryLimitParse(&limit, "-1\n", TRUE));
+  Insist(!MemoryLimitParse(&limit, "12k\n", FALSE));
+  Insist(!MemoryLimitParse(&limit, "maximum\n", FALSE));
+  Insist(!MemoryLimitParse(&limit, " 4096\n", FALSE));
+}
+
+
+/* checkCgroup -- check that MemoryLimitCgroup finds the expected path */
+
+static void checkCgroup(const char *cgroups, Bool v1, const char *path)
+{
+  Bool v1Found;
+  const char *pathFound;
+  Size length;
+
+  Insist(MemoryLimitCgroup(&v1Found, &pathFound, &length, cgroups));
+  Insist(v1Found == v1);
+  Insist(length == strlen(path));
+  Insist(strncmp(pathFound, path, length) == 0);
+}
+
+
+static void testCgroup(void)
+{
+  Bool v1;
+  const char *path;
+  Size length;
+
+  /* Unified hierarchy, with nested paths. */
+  checkCgroup("0::/\n", FALSE, "/");
+  checkCgroup("0::/user.slice/user-1000.slice/session-2.scope\n",
+              FALSE, "/user.slice/user-1000.slice/session-2.scope");
+  checkCgroup("0::/docker/abc", FALSE, "/docker/abc");
+
+  /* Legacy hierarchy: the memory controller may be shared. */
+  checkCgroup("12:pids:/a\n"
+              "11:cpu,cpuacct:/b\n"
+              "4:memory:/docker/abc\n"
+              "1:name=systemd:/c\n",
+              TRUE, "/docker/abc");
+  checkCgroup("3:cpuset,memory:/x/y\n", TRUE, "/x/y");
+
+  /* Hybrid hierarchy: the memory controller is in version 1. */
+  checkCgroup("0::/init.scope\n"
+              "5:memory:/v1/path\n",
+              TRUE, "/v1/path");
+
+  /* A controller whose name merely contains "memory" doesn't count. */
+  checkCgroup("6:memory_extra:/no\n"
+              "0::/yes\n",
+              FALSE, "/yes");
+
+  /* Malformed lines, no memory cgroup, and an empty file. */
+  Insist(!MemoryLimitCgroup(&v1, &path, &length, "0::/\nrubbish\n"));
+  Insist(!MemoryLimitCgroup(&v1, &path, &length, "4:memory\n"));
+  Insist(!MemoryLimitCgroup(&v1, &path, &length, "11:cpu:/b\n"));
+  Insist(!MemoryLimitCgroup(&v1, &path, &length, ""));
+}
+
+
+int main(int argc, char *argv[])
+{
+  testlib_init(argc, argv);
+
+  testParse();
+  testCgroup();
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+#else /* !defined(MPS_OS_LI) */
+
+int main(int argc, char *argv[])
+{
+  testlib_init(argc, argv);
+  printf("No cgroup memory limit on this platform.\n");
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+#endif /* !defined(MPS_OS_LI) */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
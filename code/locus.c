@@ -25,6 +25,8 @@ Bool LocusPrefCheck(LocusPref pref)
 {
   CHECKS(LocusPref, pref);
   CHECKL(BoolCheck(pref->high));
+  CHECKL(BoolCheck(pref->zeroed));
+  /* base can't be checked because it's arbitrary. */
   /* zones can't be checked because it's arbitrary. */
   /* avoid can't be checked because it's arbitrary. */
   return TRUE;
@@ -71,6 +73,11 @@ void LocusPrefExpress(LocusPref pref, LocusPrefKind kind, void *p)
     pref->zones = *(ZoneSet *)p;
     break;
 
+  case LocusPrefZEROED:
+    AVER(p == NULL);
+    pref->zeroed = TRUE;
+    break;
+
   default:
     /* Unknown kinds are ignored for binary compatibility. */
     break;
@@ -94,6 +101,8 @@ Res LocusPrefDescribe(LocusPref pref, mps_lib_FILE *stream, Count depth)
                "  high $S\n", WriteFYesNo(pref->high),
                "  zones $B\n", (WriteFB)pref->zones,
                "  avoid $B\n", (WriteFB)pref->avoid,
+               "  base $A\n", (WriteFA)pref->base,
+               "  zeroed $S\n", WriteFYesNo(pref->zeroed),
                "} LocusPref $P\n", (WriteFP)pref,
                NULL);
   return res;
@@ -110,6 +119,21 @@ Bool GenDescCheck(GenDesc gen)
   CHECKL(gen->capacity > 0);
   CHECKL(gen->mortality >= 0.0);
   CHECKL(gen->mortality <= 1.0);
+  CHECKL(gen->collectionRate >= 0.0);
+  CHECKL(gen->collectionOverhead >= 0.0);
+  if (gen->maxCapacity > 0) {
+    CHECKL(gen->minCapacity > 0);
+    CHECKL(gen->minCapacity <= gen->capacity);
+    CHECKL(gen->capacity <= gen->maxCapacity);
+  }
+  CHECKL(gen->targetInterval >= 0.0);
+  CHECKL(gen->targetPause >= 0.0);
+  CHECKL(gen->recycledCount <= GenRecycleLENGTH);
+  CHECKL(gen->recycledSize <= gen->recycleLimit);
+  if (gen->recycledCount > 0) {
+    CHECKL(gen->recycleLimit > 0);
+    CHECKD_NOSIG(Range, &gen->recycled[0]);
+  }
   CHECKD_NOSIG(Ring, &gen->locusRing);
   CHECKD_NOSIG(Ring, &gen->segRing);
   return TRUE;
@@ -145,6 +169,18 @@ static void GenDescInit(Arena arena, GenDesc gen, GenParamStruct *params)
   gen->zones = ZoneSetEMPTY;
   gen->capacity = params->capacity * 1024;
   gen->mortality = params->mortality;
+  gen->collections = 0;
+  gen->promotedSize = 0;
+  gen->collectionRate = 0.0;
+  gen->collectionOverhead = 0.0;
+  gen->minCapacity = 0;
+  gen->maxCapacity = 0;
+  gen->targetInterval = 0.0;
+  gen->targetPause = 0.0;
+  gen->lastCollected = 0;
+  gen->recycleLimit = 0;
+  gen->recycledSize = 0;
+  gen->recycledCount = 0;
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
   gen->activeTraces = TraceSetEMPTY;
@@ -213,6 +249,62 @@ void GenDescStartTrace(GenDesc gen, Trace trace)
 }
 
 
+/* genDescAdapt -- adapt the capacity of a generation
+ *
+ * Called at the end of a trace that the policy started because some
+ * generation was over capacity. If the generation has adaptive
+ * capacity, scale its capacity towards the target interval between
+ * collections, then limit it so that the predicted time to collect
+ * the survivors is within the target pause, using the generation's
+ * mortality and collection model. <design/strategy#.policy.adapt>.
+ */
+
+static void genDescAdapt(GenDesc gen, Trace trace)
+{
+  Clock now = ClockNow();
+  double capacity = (double)gen->capacity;
+
+  if (gen->maxCapacity == 0)
+    return;
+
+  if (gen->targetInterval > 0.0 && gen->lastCollected != 0
+      && now > gen->lastCollected)
+  {
+    double interval = (double)(now - gen->lastCollected)
+      / (double)ClocksPerSec();
+    double ratio = gen->targetInterval / interval;
+    if (ratio > LocusAdaptRATIO)
+      ratio = LocusAdaptRATIO;
+    else if (ratio < 1.0 / LocusAdaptRATIO)
+      ratio = 1.0 / LocusAdaptRATIO;
+    capacity *= ratio;
+  }
+  gen->lastCollected = now;
+
+  if (gen->targetPause > 0.0 && gen->collectionRate > 0.0
+      && gen->mortality < 1.0)
+  {
+    double budget = gen->targetPause - gen->collectionOverhead;
+    double limit = budget * gen->collectionRate / (1.0 - gen->mortality);
+    if (limit < capacity)
+      capacity = limit;
+  }
+
+  /* Keep the nursery within the cache. <design/strategy#.policy.nursery> */
+  if (gen->recycleLimit > 0 && capacity > (double)gen->recycleLimit)
+    capacity = (double)gen->recycleLimit;
+
+  if (capacity < (double)gen->minCapacity)
+    gen->capacity = gen->minCapacity;
+  else if (capacity > (double)gen->maxCapacity)
+    gen->capacity = gen->maxCapacity;
+  else
+    gen->capacity = (Size)capacity;
+
+  EVENT4(GenCapacity, trace->arena, trace, gen, gen->capacity);
+}
+
+
 /* genDescEndTrace -- notify generation of end of a trace */
 
 void GenDescEndTrace(GenDesc gen, Trace trace)
@@ -238,6 +330,9 @@ void GenDescEndTrace(GenDesc gen, Trace trace)
            genTrace->forwarded, genTrace->preservedInPlace, mortality,
            gen->mortality);
   }
+
+  if (trace->why == TraceStartWhyCHAIN_GEN0CAP)
+    genDescAdapt(gen, trace);
 }
 
 
@@ -274,6 +369,84 @@ void GenDescSurvived(GenDesc gen, Trace trace, Size forwarded,
 }
 
 
+/* GenDescPromoted -- memory in a generation was promoted by a trace
+ *
+ * Call this when a pool moves memory to an older generation instead
+ * of condemning it. The memory counts towards the generation's
+ * mortality as if it had been condemned and had all survived, but it
+ * is not part of the trace's condemned set, so the trace's own
+ * accounting is unchanged.
+ */
+
+void GenDescPromoted(GenDesc gen, Trace trace, Size size)
+{
+  GenTrace genTrace;
+
+  AVERT(GenDesc, gen);
+  AVERT(Trace, trace);
+
+  genTrace = &gen->trace[trace->ti];
+  genTrace->condemned += size;
+  genTrace->preservedInPlace += size;
+  gen->promotedSize += size;
+}
+
+
+/* GenDescAccountForCollection -- update the collection model
+ *
+ * Called at the end of a trace for the oldest generation it condemned
+ * (see GenDescOldestCondemned), since that generation determines which
+ * younger generations are condemned with it, and so the cost of the
+ * collection. work is the tracing work done, scanTime the processor
+ * time spent advancing the trace, and flipTime the processor time
+ * spent flipping it, all in seconds. <design/strategy#.policy.model>.
+ */
+
+void GenDescAccountForCollection(GenDesc gen, Trace trace, Work work,
+                                 double scanTime, double flipTime)
+{
+  double alpha = LocusRateALPHA;
+
+  AVERT(GenDesc, gen);
+  AVERT(Trace, trace);
+  AVER(scanTime >= 0.0);
+  AVER(flipTime >= 0.0);
+
+  /* The clock may be too coarse to measure a short trace. */
+  if (work > 0 && scanTime > 0.0) {
+    double rate = (double)work / scanTime;
+    if (gen->collectionRate == 0.0)
+      gen->collectionRate = rate;
+    else
+      gen->collectionRate = gen->collectionRate * (1 - alpha) + rate * alpha;
+  }
+  if (gen->collections == 0)
+    gen->collectionOverhead = flipTime;
+  else
+    gen->collectionOverhead
+      = gen->collectionOverhead * (1 - alpha) + flipTime * alpha;
+  ++ gen->collections;
+
+  EVENT8(GenModel, trace->arena, trace, gen, work, scanTime, flipTime,
+         gen->collectionRate, gen->collectionOverhead);
+}
+
+
+/* GenDescOldestCondemned -- oldest generation condemned by a trace
+ *
+ * Generations are condemned youngest first, so this is the last on
+ * the trace's ring of generations, or NULL if there are none.
+ */
+
+GenDesc GenDescOldestCondemned(Trace trace)
+{
+  AVERT(Trace, trace);
+  if (RingIsSingle(&trace->genRing))
+    return NULL;
+  return GenDescOfTraceRing(RingPrev(&trace->genRing), trace);
+}
+
+
 /* GenDescTotalSize -- return total size of generation */
 
 Size GenDescTotalSize(GenDesc gen)
@@ -310,6 +483,17 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
                "  zones $B\n", (WriteFB)gen->zones,
                "  capacity $U\n", (WriteFW)gen->capacity,
                "  mortality $D\n", (WriteFD)gen->mortality,
+               "  collections $U\n", (WriteFU)gen->collections,
+               "  promotedSize $U\n", (WriteFW)gen->promotedSize,
+               "  collectionRate $D\n", (WriteFD)gen->collectionRate,
+               "  collectionOverhead $D\n", (WriteFD)gen->collectionOverhead,
+               "  minCapacity $U\n", (WriteFW)gen->minCapacity,
+               "  maxCapacity $U\n", (WriteFW)gen->maxCapacity,
+               "  targetInterval $D\n", (WriteFD)gen->targetInterval,
+               "  targetPause $D\n", (WriteFD)gen->targetPause,
+               "  recycleLimit $U\n", (WriteFW)gen->recycleLimit,
+               "  recycledSize $U\n", (WriteFW)gen->recycledSize,
+               "  recycledCount $U\n", (WriteFW)gen->recycledCount,
                "  activeTraces $B\n", (WriteFB)gen->activeTraces,
                NULL);
   if (res != ResOK)
@@ -387,6 +571,15 @@ Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
 
   for (i = 0; i < genCount; ++i)
     GenDescInit(arena, &gens[i], &params[i]);
+
+  /* Keep the nursery within the cache. <design/strategy#.policy.nursery> */
+  if (arena->nurseryCacheSize > 0) {
+    GenDesc nursery = &gens[0];
+    nursery->recycleLimit = arena->nurseryCacheSize;
+    if (nursery->capacity > arena->nurseryCacheSize)
+      nursery->capacity = arena->nurseryCacheSize;
+  }
+
   ChainInit(chain, arena, gens, genCount);
 
   *chainReturn = chain;
@@ -482,6 +675,62 @@ double ChainDeferral(Chain chain)
 }
 
 
+/* ChainAdapt -- make the capacities of a chain's generations adaptive
+ *
+ * The first genCount generations get adaptive capacities within the
+ * bounds given by the corresponding elements of bounds (in kB), and
+ * the other generations keep fixed capacities. interval and pause are
+ * the targets for the time between collections of each adaptive
+ * generation and the time to collect it (in seconds, or zero for no
+ * target). A generation's current capacity is clamped to its bounds.
+ * <design/strategy#.policy.adapt>.
+ */
+
+void ChainAdapt(Chain chain, size_t genCount, GenBounds bounds,
+                double interval, double pause)
+{
+  size_t i;
+
+  AVERT(Chain, chain);
+  AVER(genCount <= chain->genCount);
+  AVER(genCount == 0 || bounds != NULL);
+  AVER(interval >= 0.0);
+  AVER(pause >= 0.0);
+
+  for (i = 0; i < chain->genCount; ++i) {
+    GenDesc gen = &chain->gens[i];
+    if (i < genCount) {
+      AVER(bounds[i].minCapacity > 0);
+      AVER(bounds[i].minCapacity <= bounds[i].maxCapacity);
+      AVER(bounds[i].maxCapacity <= SizeMAX / 1024);
+      gen->minCapacity = bounds[i].minCapacity * 1024;
+      gen->maxCapacity = bounds[i].maxCapacity * 1024;
+      /* Keep the nursery within the cache.
+         <design/strategy#.policy.nursery> */
+      if (gen->recycleLimit > 0) {
+        if (gen->maxCapacity > gen->recycleLimit)
+          gen->maxCapacity = gen->recycleLimit;
+        if (gen->minCapacity > gen->maxCapacity)
+          gen->minCapacity = gen->maxCapacity;
+      }
+      if (gen->capacity < gen->minCapacity)
+        gen->capacity = gen->minCapacity;
+      if (gen->capacity > gen->maxCapacity)
+        gen->capacity = gen->maxCapacity;
+      gen->targetInterval = interval;
+      gen->targetPause = pause;
+    } else {
+      gen->minCapacity = 0;
+      gen->maxCapacity = 0;
+      gen->targetInterval = 0.0;
+      gen->targetPause = 0.0;
+    }
+    gen->lastCollected = 0;
+    AVERT(GenDesc, gen);
+  }
+}
+
+
 /* ChainDescribe -- describe a chain */
 
 Res ChainDescribe(Chain chain, mps_lib_FILE *stream, Count depth)
@@ -590,12 +839,72 @@ static void PoolGenAccountForAlloc(PoolGen pgen, Size size)
 }
 
 
+/* genDescRecycleDrop -- forget a recycled range */
+
+static void genDescRecycleDrop(GenDesc gen, Index i)
+{
+  AVER(i < gen->recycledCount);
+  AVER(gen->recycledSize >= RangeSize(&gen->recycled[i]));
+  gen->recycledSize -= RangeSize(&gen->recycled[i]);
+  -- gen->recycledCount;
+  for (; i < gen->recycledCount; ++i)
+    RangeCopy(&gen->recycled[i], &gen->recycled[i + 1]);
+}
+
+
+/* genDescRecycleRemember -- remember memory freed from a generation
+ *
+ * The range is remembered as the most recently freed, forgetting the
+ * oldest ranges if there are too many or they are too large in total.
+ * <design/strategy#.policy.nursery.recycle>.
+ */
+
+static void genDescRecycleRemember(GenDesc gen, Addr base, Addr limit)
+{
+  Size size = AddrOffset(base, limit);
+
+  AVER(gen->recycleLimit > 0);
+
+  if (size > gen->recycleLimit)
+    return;
+  while (gen->recycledCount == GenRecycleLENGTH
+         || gen->recycledSize + size > gen->recycleLimit)
+    genDescRecycleDrop(gen, 0);
+  RangeInit(&gen->recycled[gen->recycledCount], base, limit);
+  ++ gen->recycledCount;
+  gen->recycledSize += size;
+}
+
+
+/* genDescRecycleFind -- find the most recently freed range that fits */
+
+static Bool genDescRecycleFind(Index *iReturn, GenDesc gen, Size size)
+{
+  Index i = gen->recycledCount;
+
+  while (i > 0) {
+    --i;
+    if (RangeSize(&gen->recycled[i]) >= size) {
+      *iReturn = i;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+
 /* PoolGenAlloc -- allocate a segment in a pool generation
  *
  * Allocate a segment belong to klass (which must be GCSegClass or a
  * subclass), attach it to the generation, and update the accounting.
+ *
+ * If args contains PoolGenZeroed with value TRUE, the segment's
+ * memory is guaranteed to contain zeros. See
+ * <design/arena#.spare-committed.zeroed>.
  */
 
+ARG_DEFINE_KEY(PoolGenZeroed, Bool);
+
 Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass, Size size,
                  ArgList args)
 {
@@ -605,6 +914,9 @@ Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass, Size size,
   ZoneSet zones, moreZones;
   Arena arena;
   GenDesc gen;
+  Bool recycle;
+  Index i = 0; /* suppress uninit warning */
+  ArgStruct arg;
 
   AVER(segReturn != NULL);
   AVERT(PoolGen, pgen);
@@ -621,10 +933,27 @@ Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass, Size size,
   pref.high = FALSE;
   pref.zones = zones;
   pref.avoid = ZoneSetBlacklist(arena);
+  if (ArgPick(&arg, args, PoolGenZeroed) && arg.val.b)
+    LocusPrefExpress(&pref, LocusPrefZEROED, NULL);
+  recycle = genDescRecycleFind(&i, gen, size);
+  if (recycle)
+    pref.base = RangeBase(&gen->recycled[i]);
   res = SegAlloc(&seg, klass, &pref, size, pgen->pool, args);
   if (res != ResOK)
     return res;
 
+  if (recycle) {
+    /* If the segment wasn't allocated at the recycled range, then
+     * some of the range has been reused since, so forget it. */
+    Range range = &gen->recycled[i];
+    if (SegBase(seg) == RangeBase(range) && SegLimit(seg) < RangeLimit(range)) {
+      RangeSetBase(range, SegLimit(seg));
+      gen->recycledSize -= SegSize(seg);
+    } else {
+      genDescRecycleDrop(gen, i);
+    }
+  }
+
   RingAppend(&gen->segRing, &SegGCSeg(seg)->genRing);
 
   moreZones = ZoneSetUnion(zones, ZoneSetOfSeg(arena, seg));
@@ -827,10 +1156,60 @@ void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
 
   RingRemove(&SegGCSeg(seg)->genRing);
 
+  if (pgen->gen->recycleLimit > 0)
+    genDescRecycleRemember(pgen->gen, SegBase(seg), SegLimit(seg));
+
   SegFree(seg);
 }
 
 
+/* PoolGenTransfer -- move a segment to another pool generation
+ *
+ * Call this when a pool moves a segment from one of its generations to
+ * another without copying its contents, for example when promoting a
+ * densely live segment in place. Pass the amount of memory in the
+ * segment that is accounted as free, old, or new, respectively, in
+ * the source generation. Deferred memory can't be transferred.
+ *
+ * <design/strategy#.accounting.op.transfer>
+ */
+
+void PoolGenTransfer(PoolGen to, PoolGen from, Seg seg, Size freeSize,
+                     Size oldSize, Size newSize)
+{
+  Arena arena;
+  GenDesc gen;
+  ZoneSet zones, moreZones;
+  Size size;
+
+  AVERT(PoolGen, to);
+  AVERT(PoolGen, from);
+  AVER(to != from);
+  AVER(to->pool == from->pool);
+  AVERT(Seg, seg);
+
+  size = SegSize(seg);
+  AVER(freeSize + oldSize + newSize == size);
+
+  PoolGenAccountForFree(from, size, oldSize, newSize, FALSE);
+  RingRemove(&SegGCSeg(seg)->genRing);
+
+  PoolGenAccountForAlloc(to, size);
+  AVER(to->freeSize >= oldSize + newSize);
+  to->freeSize -= oldSize + newSize;
+  to->newSize += oldSize + newSize;
+
+  arena = PoolArena(to->pool);
+  gen = to->gen;
+  RingAppend(&gen->segRing, &SegGCSeg(seg)->genRing);
+  zones = gen->zones;
+  moreZones = ZoneSetUnion(zones, ZoneSetOfSeg(arena, seg));
+  gen->zones = moreZones;
+  if (!ZoneSetSuper(zones, moreZones))
+    EVENT3(GenZoneSet, arena, gen, moreZones);
+}
+
+
 /* PoolGenDescribe -- describe a PoolGen */
 
 Res PoolGenDescribe(PoolGen pgen, mps_lib_FILE *stream, Count depth)
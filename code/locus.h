@@ -9,6 +9,7 @@
 
 #include "mpmtypes.h"
 #include "ring.h"
+#include "range.h"
 
 
 /* GenParamStruct -- structure for specifying generation parameters */
@@ -22,6 +23,17 @@ typedef struct GenParamStruct {
 } GenParamStruct;
 
 
+/* GenBoundsStruct -- structure for specifying capacity bounds */
+/* .gen-bounds: This structure must match <code/mps.h#gen-bounds>. */
+
+typedef struct GenBoundsStruct *GenBounds;
+
+typedef struct GenBoundsStruct {
+  Size minCapacity;             /* minimum capacity in kB */
+  Size maxCapacity;             /* maximum capacity in kB */
+} GenBoundsStruct;
+
+
 /* GenTrace -- per-generation per-trace structure */
 
 typedef struct GenTraceStruct *GenTrace;
@@ -46,6 +58,19 @@ typedef struct GenDescStruct {
   ZoneSet zones;        /* zoneset for this generation */
   Size capacity;        /* capacity in bytes */
   double mortality;     /* moving average mortality */
+  Count collections;    /* collections with this as oldest generation */
+  Size promotedSize;    /* total size promoted without being condemned */
+  double collectionRate; /* moving average work per second collecting */
+  double collectionOverhead; /* moving average flip time in seconds */
+  Size minCapacity;     /* minimum adaptive capacity in bytes */
+  Size maxCapacity;     /* maximum adaptive capacity, or 0 if fixed */
+  double targetInterval; /* target seconds between collections, or 0 */
+  double targetPause;   /* target seconds to collect, or 0 */
+  Clock lastCollected;  /* when last collected by the policy, or 0 */
+  Size recycleLimit;    /* limit on recycled memory, or 0 if none */
+  Size recycledSize;    /* total size of recycled ranges */
+  Count recycledCount;  /* number of recycled ranges */
+  RangeStruct recycled[GenRecycleLENGTH]; /* freed memory, oldest first */
   RingStruct locusRing; /* Ring of all PoolGen's in this GenDesc (locus) */
   RingStruct segRing;   /* Ring of GCSegs in this generation */
   TraceSet activeTraces; /* set of traces collecting this generation */
@@ -96,6 +121,10 @@ extern void GenDescStartTrace(GenDesc gen, Trace trace);
 extern void GenDescEndTrace(GenDesc gen, Trace trace);
 extern void GenDescCondemned(GenDesc gen, Trace trace, Size size);
 extern void GenDescSurvived(GenDesc gen, Trace trace, Size forwarded, Size preservedInPlace);
+extern void GenDescPromoted(GenDesc gen, Trace trace, Size size);
+extern void GenDescAccountForCollection(GenDesc gen, Trace trace, Work work,
+                                        double scanTime, double flipTime);
+extern GenDesc GenDescOldestCondemned(Trace trace);
 extern Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth);
 #define GenDescOfTraceRing(node, tr) PARENT(GenDescStruct, trace, RING_ELT(GenTrace, traceRing, node) - (tr)->ti)
 
@@ -108,6 +137,12 @@ extern double ChainDeferral(Chain chain);
 extern size_t ChainGens(Chain chain);
 extern GenDesc ChainGen(Chain chain, Index gen);
 extern Res ChainDescribe(Chain chain, mps_lib_FILE *stream, Count depth);
+extern void ChainAdapt(Chain chain, size_t genCount, GenBounds bounds,
+                       double interval, double pause);
+
+extern const struct mps_key_s _mps_key_PoolGenZeroed;
+#define PoolGenZeroed (&_mps_key_PoolGenZeroed)
+#define PoolGenZeroed_FIELD b
 
 extern Bool PoolGenCheck(PoolGen pgen);
 extern Res PoolGenInit(PoolGen pgen, GenDesc gen, Pool pool);
@@ -116,6 +151,8 @@ extern Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass,
                         Size size, ArgList args);
 extern void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
                         Size newSize, Bool deferred);
+extern void PoolGenTransfer(PoolGen to, PoolGen from, Seg seg, Size freeSize,
+                            Size oldSize, Size newSize);
 extern void PoolGenAccountForFill(PoolGen pgen, Size size);
 extern void PoolGenAccountForEmpty(PoolGen pgen, Size used, Size unused, Bool deferred);
 extern void PoolGenAccountForAge(PoolGen pgen, Size wasBuffered, Size wasNew, Bool deferred);
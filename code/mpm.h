@@ -27,6 +27,8 @@
 #include "prmc.h"
 #include "prot.h"
 #include "sp.h"
+#include "lim.h"
+#include "idle.h"
 #include "th.h"
 #include "ss.h"
 #include "mpslib.h"
@@ -361,6 +363,8 @@ extern void ScanStateInitSeg(ScanState ss, TraceSet ts, Arena arena,
 extern void ScanStateFinish(ScanState ss);
 extern Bool ScanStateCheck(ScanState ss);
 extern void ScanStateSetSummary(ScanState ss, RefSet summary);
+extern void ScanStateSetSplatTable(ScanState ss, BT table,
+                                   Addr base, Addr limit);
 extern RefSet ScanStateSummary(ScanState ss);
 extern void ScanStateUpdateSummary(ScanState ss, Seg seg, Bool wasTotal);
 
@@ -404,6 +408,26 @@ extern void TracePostMessage(Trace trace);  /* trace end */
 extern Bool TraceIdMessagesCheck(Arena arena, TraceId ti);
 extern Res TraceIdMessagesCreate(Arena arena, TraceId ti);
 extern void TraceIdMessagesDestroy(Arena arena, TraceId ti);
+extern void ArenaGCEventHookSet(Arena arena, GCEventHook hook,
+                                void *closure);
+extern void TracePostGCEvent(Trace trace, GCEventKind kind);
+extern void ArenaPostPressureEvent(Arena arena, Size size);
+extern Count ArenaGCEventsTake(GCEventStruct events[],
+                               GCEventHook *hookReturn,
+                               void **closureReturn, Arena arena);
+extern void ArenaPressureHandlerSet(Arena arena, PressureHandler handler,
+                                    void *closure, double moderate,
+                                    double critical);
+extern void ArenaPressureCheck(Arena arena);
+extern void ArenaPostPressure(Arena arena, PressureLevel level, Size target);
+extern Bool ArenaPressureDefer(Arena arena, Size target);
+extern Size ArenaPressureCreditTake(Arena arena);
+extern Bool ArenaPressureTake(PressureLevel *levelReturn,
+                              Size *targetReturn,
+                              PressureHandler *handlerReturn,
+                              void **closureReturn, Arena arena);
+extern void ArenaPressureRelieved(Arena arena, PressureLevel level,
+                                  Size target, Size released);
 
 /* Equivalent to <code/mps.h> MPS_SCAN_BEGIN */
 
@@ -517,6 +541,10 @@ extern void ArenaLeaveLock(Arena arena, Bool recursive);
 
 extern void ArenaEnter(Arena arena);
 extern void ArenaLeave(Arena arena);
+extern Size ArenaLeaveRelieved(Arena arena);
+extern Res ArenaIdleStart(Arena arena, double period);
+extern void ArenaIdleStop(Arena arena);
+extern void ArenaIdle(Arena arena, Idle idle);
 extern void (ArenaPoll)(Globals globals);
 
 #if defined(SHIELD)
@@ -584,17 +612,25 @@ extern Size ArenaCommitted(Arena arena);
 extern Size ArenaSpareCommitted(Arena arena);
 extern double ArenaSpare(Arena arena);
 extern void ArenaSetSpare(Arena arena, double spare);
+extern void ArenaSpareDecay(Arena arena);
+extern void ArenaZeroSpare(Arena arena);
 #define ArenaSpareCommitLimit(arena) ((Size)((double)ArenaCommitted(arena) * ArenaSpare(arena)))
 #define ArenaCurrentSpare(arena) ((double)ArenaSpareCommitted(arena) / (double)ArenaCommitted(arena))
 
 extern Size ArenaCommitLimit(Arena arena);
 extern Res ArenaSetCommitLimit(Arena arena, Size limit);
+extern Size ArenaSoftLimit(Arena arena);
+extern void ArenaSetSoftLimit(Arena arena, Size limit);
+extern Res ArenaRefreshSoftLimit(Arena arena);
 extern double ArenaPauseTime(Arena arena);
 extern void ArenaSetPauseTime(Arena arena, double pauseTime);
 extern Size ArenaNoPurgeSpare(Arena arena, Size size);
+extern void ArenaTrivZero(Arena arena, Addr base, Size size);
+extern Size ArenaNoZeroSpare(Arena arena, Size size);
 extern Res ArenaNoGrow(Arena arena, LocusPref pref, Size size);
 
 extern Size ArenaAvail(Arena arena);
+extern Size ArenaSoftAvail(Arena arena);
 extern Size ArenaCollectable(Arena arena);
 
 extern Res ArenaExtend(Arena, Addr base, Size size);
@@ -602,12 +638,15 @@ extern Res ArenaExtend(Arena, Addr base, Size size);
 extern void ArenaCompact(Arena arena, Trace trace);
 
 extern Res ArenaFinalize(Arena arena, Ref obj);
+extern Res ArenaFinalizeMany(Arena arena, Ref *refs, Count count);
 extern Res ArenaDefinalize(Arena arena, Ref obj);
 
 extern Res ArenaAlloc(Addr *baseReturn, LocusPref pref,
                       Size size, Pool pool);
 extern Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
                               Bool high, Size size, Pool pool);
+extern Res ArenaFreeLandAllocAt(Tract *tractReturn, Arena arena, Addr base,
+                                Size size, Pool pool);
 extern void ArenaFree(Addr base, Size size, Pool pool);
 
 extern Res ArenaNoExtend(Arena arena, Addr base, Size size);
@@ -693,7 +732,7 @@ extern void SegClassMixInNoSplitMerge(SegClass klass);
 extern Size SegSize(Seg seg);
 extern Addr (SegBase)(Seg seg);
 extern Addr (SegLimit)(Seg seg);
-#define SegBase(seg)            (TractBase((seg)->firstTract))
+#define SegBase(seg)            RVALUE((seg)->base)
 #define SegLimit(seg)           ((seg)->limit)
 #define SegPool(seg)            (TractPool((seg)->firstTract))
 /* .bitfield.promote: The bit field accesses need to be cast to the */
@@ -754,6 +793,7 @@ extern void BufferFinish(Buffer buffer);
 extern Bool BufferIsReset(Buffer buffer);
 extern Bool BufferIsReady(Buffer buffer);
 extern Bool BufferIsMutator(Buffer buffer);
+#define BufferIsZeroed(buffer) RVALUE((buffer)->zeroed)
 extern void BufferSetAllocAddr(Buffer buffer, Addr addr);
 extern void BufferAttach(Buffer buffer,
                          Addr base, Addr limit, Addr init, Size size);
@@ -831,6 +871,8 @@ extern Bool RankSetCheck(RankSet rankSet);
 
 #define AddrZone(arena, addr) \
   (((Word)(addr) >> (arena)->zoneShift) & (MPS_WORD_WIDTH - 1))
+#define AddrFineZone(arena, addr) \
+  (((Word)(addr) >> (arena)->fineZoneShift) & (MPS_WORD_WIDTH - 1))
 
 #define RefSetUnion(rs1, rs2)   BS_UNION((rs1), (rs2))
 #define RefSetInter(rs1, rs2)   BS_INTER((rs1), (rs2))
@@ -861,6 +903,8 @@ extern Bool RankSetCheck(RankSet rankSet);
 
 extern ZoneSet ZoneSetOfRange(Arena arena, Addr base, Addr limit);
 extern ZoneSet ZoneSetOfSeg(Arena arena, Seg seg);
+extern void FineZoneSetAddRange(ZoneSet fineZoneSet[MPS_WORD_WIDTH],
+                                Arena arena, Addr base, Addr limit);
 typedef Bool (*RangeInZoneSet)(Addr *baseReturn, Addr *limitReturn,
                                Addr base, Addr limit,
                                Arena arena, ZoneSet zoneSet, Size size);
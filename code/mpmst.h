@@ -222,6 +222,7 @@ typedef struct SegStruct {      /* segment structure */
   Sig sig;                      /* design.mps.sig.field */
   Tract firstTract;             /* first tract of segment */
   RingStruct poolRing;          /* link in list of segs in pool */
+  Addr base;                    /* base of segment */
   Addr limit;                   /* limit of segment */
   unsigned depth : ShieldDepthWIDTH; /* see <design/shield#.def.depth> */
   BOOLFIELD(queued);            /* in shield queue? */
@@ -266,6 +267,8 @@ typedef struct LocusPrefStruct { /* locus placement preferences */
   Bool high;                    /* high or low */
   ZoneSet zones;                /* preferred zones */
   ZoneSet avoid;                /* zones to avoid */
+  Addr base;                    /* preferred base address, or NULL */
+  Bool zeroed;                  /* memory must contain zeros */
 } LocusPrefStruct;
 
 
@@ -314,6 +317,7 @@ typedef struct BufferStruct {
   Pool pool;                    /* owning pool */
   RingStruct poolRing;          /* buffers are attached to pools */
   Bool isMutator;               /* TRUE iff buffer used by mutator */
+  Bool zeroed;                  /* fills must contain zeros */
   BufferMode mode;              /* Attached/Logged/Flipped/etc */
   double fillSize;              /* bytes filled in this buffer */
   double emptySize;             /* bytes emptied from this buffer */
@@ -409,6 +413,10 @@ typedef struct ScanStateStruct {
   Rank rank;                    /* reference rank of scanning */
   Bool wasMarked;               /* <design/fix#.protocol.was-ready> */
   RefSet fixedSummary;          /* accumulated summary of fixed references */
+  BT splatTable;                /* NULL, or table of splatted slots */
+  Addr splatBase;               /* base of area covered by splatTable */
+  Addr splatLimit;              /* limit of area covered by splatTable */
+  ZoneSet *fineWhite;           /* NULL, or fine white set of only trace */
   STATISTIC_DECL(Count fixRefCount) /* refs which pass zone check */
   STATISTIC_DECL(Count segRefCount) /* refs which refer to segs */
   STATISTIC_DECL(Count whiteSegRefCount) /* refs which refer to white segs */
@@ -431,6 +439,7 @@ typedef struct TraceStruct {
   Arena arena;                  /* owning arena */
   TraceStartWhy why;            /* why the trace began */
   ZoneSet white;                /* zones in the white set */
+  ZoneSet fineWhite[MPS_WORD_WIDTH]; /* fine zones in white set, by zone */
   ZoneSet mayMove;              /* zones containing possibly moving objs */
   TraceState state;             /* current state of trace */
   Rank band;                    /* current band */
@@ -443,6 +452,8 @@ typedef struct TraceStruct {
   Size notCondemned;            /* collectable but not condemned */
   Size foundation;              /* initial grey set size */
   Work quantumWork;             /* tracing work to be done in each poll */
+  Clock flipTime;               /* processor time spent flipping */
+  Clock advanceTime;            /* processor time spent in TraceAdvance */
   STATISTIC_DECL(Count greySegCount) /* number of grey segments */
   STATISTIC_DECL(Count greySegMax) /* maximum number of grey segments */
   STATISTIC_DECL(Count rootScanCount) /* number of roots scanned */
@@ -490,6 +501,8 @@ typedef struct mps_arena_class_s {
   ArenaCompactMethod compact;
   ArenaPagesMarkAllocatedMethod pagesMarkAllocated;
   ArenaChunkPageMappedMethod chunkPageMapped;
+  ArenaZeroMethod zero;
+  ArenaZeroSpareMethod zeroSpare;
   Sig sig; /* design.mps.sig.field.end.outer */
 } ArenaClassStruct;
 
@@ -606,6 +619,31 @@ typedef struct CBSStruct {
 } CBSStruct;
 
 
+/* BTreeStruct -- B-tree land
+ *
+ * BTree is a Land implementation that maintains a collection of
+ * disjoint ranges in a B-tree whose nodes are augmented with the
+ * maximum size (and optionally the zone set) of their sub-trees.
+ *
+ * See <code/btree.c>.
+ */
+
+#define BTreeSig ((Sig)0x519B73EE) /* SIGnature BTREE */
+
+typedef struct BTreeStruct {
+  LandStruct landStruct;        /* superclass fields come first */
+  struct BTreeNodeStruct *root; /* root node, or NULL if empty */
+  Count height;                 /* height of root (0 if it is a leaf) */
+  Count nodes;                  /* number of nodes in the tree */
+  Count ranges;                 /* number of ranges in the tree */
+  Pool nodePool;                /* pool that manages nodes */
+  Bool ownPool;                 /* did we create nodePool? */
+  Bool zoned;                   /* maintain zone sets of sub-trees? */
+  Size size;                    /* total size of ranges in tree */
+  Sig sig;                      /* design.mps.sig.field.end.outer */
+} BTreeStruct;
+
+
 /* FailoverStruct -- fail over from one land to another
  *
  * Failover is a Land implementation that combines two other Lands,
@@ -745,10 +783,18 @@ typedef struct mps_arena_s {
   Size reserved;                /* total reserved address space */
   Size committed;               /* total committed memory */
   Size commitLimit;             /* client-configurable commit limit */
+  Size softLimit;               /* client-configurable soft limit */
+  Size osSoftLimit;             /* soft limit from operating system */
+  double softLimitFraction;     /* fraction of OS limit, or 0 if none */
 
   Size spareCommitted;          /* amount of memory in hysteresis fund */
   double spare;                 /* maximum spareCommitted/committed */
+  double spareHalfLife;         /* spare decay half-life, or 0 if none */
+  Clock spareDecayClock;        /* time spare memory last decayed */
+  Size spareZeroed;             /* spare memory known to contain zeros */
+  Bool zeroedWanted;            /* has zeroed memory been allocated? */
   double pauseTime;             /* maximum pause time, in seconds */
+  Size nurseryCacheSize;        /* nursery recycling limit, or 0 */
 
   Shift zoneShift;              /* see also <code/ref.c> */
   Size grainSize;               /* <design/arena#.grain> */
@@ -762,10 +808,18 @@ typedef struct mps_arena_s {
   Serial chunkSerial;           /* next chunk number */
 
   Bool hasFreeLand;              /* Is freeLand available? */
-  MFSStruct freeCBSBlockPoolStruct;
-  CBSStruct freeLandStruct;
+  Bool freeBTree;               /* <design/arena#.free.btree> */
+  MFSStruct freeCBSBlockPoolStruct; /* CBS blocks or B-tree nodes */
+  union {
+    CBSStruct cbs;
+    BTreeStruct btree;
+  } freeLandStruct;
   ZoneSet freeZones;            /* zones not yet allocated */
   Bool zoned;                   /* use zoned allocation? */
+  ZoneSet freeLandZones;        /* zones with free address space */
+  Bool fineZones;               /* filter fixes by fine zones? */
+  Shift fineZoneShift;          /* <design/trace#.fix.fine> */
+  Size freeLandZoneSize[MPS_WORD_WIDTH]; /* free address space per zone */
 
   /* locus fields <code/locus.c> */
   GenDescStruct topGen;         /* generation descriptor for dynamic gen */
@@ -780,6 +834,26 @@ typedef struct mps_arena_s {
   BT enabledMessageTypes;       /* map of which types are enabled */
   Count droppedMessages;        /* <design/message-gc#.lifecycle> */
 
+  /* GC event hook fields <design/message-gc#.hook> */
+  GCEventHook gcEventHook;      /* client's hook, or NULL */
+  void *gcEventClosure;         /* closure argument for hook */
+  Count gcEventCount;           /* number of queued events */
+  Count droppedGCEvents;        /* events dropped because queue full */
+  GCEventStruct gcEvents[ArenaGCEventQueueLENGTH]; /* queued events */
+
+  /* memory pressure fields <design/message-gc#.pressure> */
+  PressureHandler pressureHandler; /* client's handler, or NULL */
+  void *pressureClosure;        /* closure argument for handler */
+  double pressureModerate;      /* moderate threshold, fraction of limit */
+  double pressureCritical;      /* critical threshold, fraction of limit */
+  PressureLevel pressureLevel;  /* level when last checked */
+  PressureLevel pressurePending; /* level to report, or PressureNONE */
+  Size pressureTarget;          /* size to ask handler to release */
+  Bool pressureAsked;           /* asked before collecting the world? */
+  Bool pressureDelivering;      /* is the handler running? */
+  Size pressureCredit;          /* released since last policy decision */
+  Size pressureReleased;        /* total size released by handler */
+
   /* finalization fields <design/finalize>, <code/poolmrg.c> */
   Bool isFinalPool;             /* indicator for finalPool */
   Pool finalPool;               /* either NULL or an MRG pool */
@@ -806,6 +880,11 @@ typedef struct mps_arena_s {
   double tracedTime;
   Clock lastWorldCollect;
 
+  /* idle collector fields <design/arena#.idle> */
+  Idle idle;                    /* idle collector, or NULL */
+  double idleFillMutatorSize;   /* fillMutatorSize when last checked */
+  Clock idleSince;              /* when the mutator was last active */
+
   RingStruct greyRing[RankLIMIT]; /* ring of grey segments at each rank */
   RingStruct chainRing;         /* ring of chains */
 
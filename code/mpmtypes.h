@@ -73,6 +73,7 @@ typedef struct BufferClassStruct *BufferClass; /* <design/buffer> */
 typedef unsigned BufferMode;            /* <design/buffer> */
 typedef struct mps_fmt_s *Format;       /* <design/format> */
 typedef struct LockStruct *Lock;        /* <code/lock.c>* */
+typedef struct IdleStruct *Idle;        /* <code/idle.h> */
 typedef struct mps_pool_s *Pool;        /* <design/pool> */
 typedef Pool AbstractPool;
 typedef struct mps_pool_class_s *PoolClass;  /* <code/poolclas.c> */
@@ -127,6 +128,8 @@ typedef Res (*ArenaPagesMarkAllocatedMethod)(Arena arena, Chunk chunk,
                                              Index baseIndex, Count pages,
                                              Pool pool);
 typedef Bool (*ArenaChunkPageMappedMethod)(Chunk chunk, Index index);
+typedef void (*ArenaZeroMethod)(Arena arena, Addr base, Size size);
+typedef Size (*ArenaZeroSpareMethod)(Arena arena, Size size);
 
 
 /* These are not generally exposed and public, but are part of a commercial
@@ -221,6 +224,19 @@ typedef PoolDebugMixin (*PoolDebugMixinMethod)(Pool pool);
 typedef Size (*PoolSizeMethod)(Pool pool);
 
 
+/* GC event hooks
+ *
+ * <design/message-gc#.hook>
+ */
+
+typedef mps_gc_event_kind_t GCEventKind;
+typedef mps_gc_event_s GCEventStruct;
+typedef mps_gc_event_s *GCEvent;
+typedef mps_gc_event_hook_t GCEventHook;
+typedef mps_pressure_level_t PressureLevel;
+typedef mps_pressure_handler_t PressureHandler;
+
+
 /* Messages
  *
  * <design/message>
@@ -282,7 +298,8 @@ typedef Res (*LandFindInZonesMethod)(Bool *foundReturn, Range rangeReturn, Range
 #define RankSetUNIV     ((RankSet)((1u << RankLIMIT) - 1))
 #define AttrGC          ((Attr)(1<<0))
 #define AttrMOVINGGC    ((Attr)(1<<1))
-#define AttrMASK        (AttrGC | AttrMOVINGGC)
+#define AttrZEROFILL    ((Attr)(1<<2))
+#define AttrMASK        (AttrGC | AttrMOVINGGC | AttrZEROFILL)
 
 
 /* Locus preferences */
@@ -290,6 +307,7 @@ enum {
   LocusPrefHIGH = 1,
   LocusPrefLOW,
   LocusPrefZONESET,
+  LocusPrefZEROED,
   LocusPrefLIMIT
 };
 
@@ -380,7 +398,10 @@ enum {
     "Client requests: immediate full collection.")                      \
   X(WALK, "walk", "Walking all live objects.")                          \
   X(EXTENSION, "extension", \
-    "Extension: an MPS extension started the trace.")
+    "Extension: an MPS extension started the trace.")                  \
+  X(SOFTLIMIT, "soft limit",                                            \
+    "Need to start full collection now, or there won't be enough "      \
+    "memory below the soft limit (ArenaSoftAvail) to complete it.")
 
 enum {
 #define X(WHY, SHORT, LONG) TraceStartWhy ## WHY,
@@ -401,6 +422,29 @@ enum {
 };
 
 
+/* GC event kinds -- see <design/message-gc#.hook> */
+/* .gc.event.kinds: Keep in sync with <code/mps.h#gc.event.kinds> */
+
+enum {
+  GCEventSTART,                 /* MPS_GC_EVENT_START */
+  GCEventFLIP,                  /* MPS_GC_EVENT_FLIP */
+  GCEventEND,                   /* MPS_GC_EVENT_END */
+  GCEventPRESSURE,              /* MPS_GC_EVENT_PRESSURE */
+  GCEventLIMIT                  /* not a GC event kind, the limit of the enum. */
+};
+
+
+/* Memory pressure levels -- see <design/message-gc#.pressure> */
+/* .pressure.levels: Keep in sync with <code/mps.h#pressure.levels> */
+
+enum {
+  PressureNONE,                 /* below the thresholds */
+  PressureMODERATE,             /* MPS_PRESSURE_MODERATE */
+  PressureCRITICAL,             /* MPS_PRESSURE_CRITICAL */
+  PressureLIMIT                 /* not a level, the limit of the enum. */
+};
+
+
 /* FindDelete operations -- see <design/land> */
 
 enum {
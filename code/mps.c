@@ -67,6 +67,7 @@
 #include "rangetree.c"
 #include "splay.c"
 #include "cbs.c"
+#include "btree.c"
 #include "ss.c"
 #include "version.c"
 #include "table.c"
@@ -110,6 +111,8 @@
 #include "prmcan.c"     /* generic operating system mutator context */
 #include "prmcanan.c"   /* generic architecture mutator context */
 #include "span.c"       /* generic stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idlean.c"     /* generic idle collector */
 
 /* macOS on ARM64 built with Clang */
 
@@ -124,6 +127,8 @@
 #include "prmcxc.c"     /* macOS mutator context */
 #include "prmcxca6.c"   /* ARM64 for macOS mutator context */
 #include "span.c"       /* generic stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* macOS on IA-32 built with Clang or GCC */
 
@@ -138,6 +143,8 @@
 #include "prmcxc.c"     /* macOS mutator context */
 #include "prmcxci3.c"   /* IA-32 for macOS mutator context */
 #include "span.c"       /* generic stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* macOS on x86-64 build with Clang or GCC */
 
@@ -152,6 +159,8 @@
 #include "prmcxc.c"     /* macOS mutator context */
 #include "prmcxci6.c"   /* x86-64 for macOS mutator context */
 #include "span.c"       /* generic stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* FreeBSD on IA-32 built with GCC or Clang */
 
@@ -167,6 +176,8 @@
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmcfri3.c"   /* IA-32 for FreeBSD mutator context */
 #include "span.c"       /* generic stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* FreeBSD on x86-64 built with GCC or Clang */
 
@@ -182,6 +193,8 @@
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmcfri6.c"   /* x86-64 for FreeBSD mutator context */
 #include "span.c"       /* generic stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* Linux on ARM64 with GCC or Clang */
 
@@ -197,6 +210,8 @@
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmclia6.c"   /* x86-64 for Linux mutator context */
 #include "span.c"       /* generic stack probe */
+#include "limli.c"      /* Linux memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* Linux on IA-32 with GCC */
 
@@ -212,6 +227,8 @@
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmclii3.c"   /* IA-32 for Linux mutator context */
 #include "span.c"       /* generic stack probe */
+#include "limli.c"      /* Linux memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* Linux on x86-64 with GCC or Clang */
 
@@ -227,6 +244,8 @@
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmclii6.c"   /* x86-64 for Linux mutator context */
 #include "span.c"       /* generic stack probe */
+#include "limli.c"      /* Linux memory limit */
+#include "idleix.c"     /* Posix idle collector */
 
 /* Windows on IA-32 with Microsoft Visual Studio or Pelles C */
 
@@ -240,6 +259,8 @@
 #include "prmcw3.c"     /* Windows mutator context */
 #include "prmcw3i3.c"   /* Windows on IA-32 mutator context */
 #include "spw3i3.c"     /* Windows on IA-32 stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idlean.c"     /* generic idle collector */
 #include "mpsiw3.c"     /* Windows interface layer extras */
 
 /* Windows on x86-64 with Microsoft Visual Studio or Pelles C */
@@ -254,6 +275,8 @@
 #include "prmcw3.c"     /* Windows mutator context */
 #include "prmcw3i6.c"   /* Windows on x86-64 mutator context */
 #include "spw3i6.c"     /* Windows on x86-64 stack probe */
+#include "liman.c"      /* generic memory limit */
+#include "idlean.c"     /* generic idle collector */
 #include "mpsiw3.c"     /* Windows interface layer extras */
 
 #else
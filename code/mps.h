@@ -205,6 +205,18 @@ extern const struct mps_key_s _mps_key_SPARE_COMMIT_LIMIT;
 extern const struct mps_key_s _mps_key_PAUSE_TIME;
 #define MPS_KEY_PAUSE_TIME      (&_mps_key_PAUSE_TIME)
 #define MPS_KEY_PAUSE_TIME_FIELD d
+extern const struct mps_key_s _mps_key_NURSERY_CACHE_SIZE;
+#define MPS_KEY_NURSERY_CACHE_SIZE (&_mps_key_NURSERY_CACHE_SIZE)
+#define MPS_KEY_NURSERY_CACHE_SIZE_FIELD size
+extern const struct mps_key_s _mps_key_SPARE_HALF_LIFE;
+#define MPS_KEY_SPARE_HALF_LIFE (&_mps_key_SPARE_HALF_LIFE)
+#define MPS_KEY_SPARE_HALF_LIFE_FIELD d
+extern const struct mps_key_s _mps_key_SOFT_LIMIT;
+#define MPS_KEY_SOFT_LIMIT      (&_mps_key_SOFT_LIMIT)
+#define MPS_KEY_SOFT_LIMIT_FIELD size
+extern const struct mps_key_s _mps_key_SOFT_LIMIT_FRACTION;
+#define MPS_KEY_SOFT_LIMIT_FRACTION (&_mps_key_SOFT_LIMIT_FRACTION)
+#define MPS_KEY_SOFT_LIMIT_FRACTION_FIELD d
 
 extern const struct mps_key_s _mps_key_EXTEND_BY;
 #define MPS_KEY_EXTEND_BY       (&_mps_key_EXTEND_BY)
@@ -234,6 +246,18 @@ extern const struct mps_key_s _mps_key_INTERIOR;
 extern const struct mps_key_s _mps_key_VMW3_TOP_DOWN;
 #define MPS_KEY_VMW3_TOP_DOWN   (&_mps_key_VMW3_TOP_DOWN)
 #define MPS_KEY_VMW3_TOP_DOWN_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_HUGE_PAGES;
+#define MPS_KEY_ARENA_HUGE_PAGES (&_mps_key_ARENA_HUGE_PAGES)
+#define MPS_KEY_ARENA_HUGE_PAGES_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_SINGLE_CHUNK;
+#define MPS_KEY_ARENA_SINGLE_CHUNK (&_mps_key_ARENA_SINGLE_CHUNK)
+#define MPS_KEY_ARENA_SINGLE_CHUNK_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_FINE_ZONES;
+#define MPS_KEY_ARENA_FINE_ZONES (&_mps_key_ARENA_FINE_ZONES)
+#define MPS_KEY_ARENA_FINE_ZONES_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_FREE_BTREE;
+#define MPS_KEY_ARENA_FREE_BTREE (&_mps_key_ARENA_FREE_BTREE)
+#define MPS_KEY_ARENA_FREE_BTREE_FIELD b
 
 extern const struct mps_key_s _mps_key_FMT_ALIGN;
 #define MPS_KEY_FMT_ALIGN   (&_mps_key_FMT_ALIGN)
@@ -262,6 +286,9 @@ extern const struct mps_key_s _mps_key_FMT_CLASS;
 extern const struct mps_key_s _mps_key_ap_hash_arrays;
 #define MPS_KEY_AP_HASH_ARRAYS (&_mps_key_ap_hash_arrays)
 #define MPS_KEY_AP_HASH_ARRAYS_FIELD b
+extern const struct mps_key_s _mps_key_AP_ZEROED;
+#define MPS_KEY_AP_ZEROED (&_mps_key_AP_ZEROED)
+#define MPS_KEY_AP_ZEROED_FIELD b
 
 /* Maximum length of a keyword argument list. */
 #define MPS_ARGS_MAX          32
@@ -468,6 +495,9 @@ extern size_t mps_arena_spare_committed(mps_arena_t);
 
 extern size_t mps_arena_commit_limit(mps_arena_t);
 extern mps_res_t mps_arena_commit_limit_set(mps_arena_t, size_t);
+extern size_t mps_arena_soft_limit(mps_arena_t);
+extern void mps_arena_soft_limit_set(mps_arena_t, size_t);
+extern mps_res_t mps_arena_soft_limit_refresh(mps_arena_t);
 extern double mps_arena_spare(mps_arena_t);
 extern void mps_arena_spare_set(mps_arena_t, double);
 extern void mps_arena_spare_commit_limit_set(mps_arena_t, size_t);
@@ -525,9 +555,17 @@ typedef struct mps_gen_param_s {
   double mps_mortality;
 } mps_gen_param_s;
 
+/* .gen-bounds: This structure must match <code/locus.h#gen-bounds>. */
+typedef struct mps_gen_bounds_s {
+  size_t mps_min_capacity;
+  size_t mps_max_capacity;
+} mps_gen_bounds_s;
+
 extern mps_res_t mps_chain_create(mps_chain_t *, mps_arena_t,
                                   size_t, mps_gen_param_s *);
 extern void mps_chain_destroy(mps_chain_t);
+extern void mps_chain_adapt(mps_chain_t, size_t, mps_gen_bounds_s *,
+                            double, double);
 
 
 /* Manual Allocation */
@@ -741,6 +779,7 @@ extern mps_clock_t mps_message_clock(mps_arena_t, mps_message_t);
 /* -- mps_message_type_finalization */
 extern void mps_message_finalization_ref(mps_addr_t *,
                                          mps_arena_t, mps_message_t);
+extern size_t mps_finalization_get(mps_arena_t, mps_addr_t *, size_t);
 
 /* -- mps_message_type_gc */
 extern size_t mps_message_gc_live_size(mps_arena_t, mps_message_t);
@@ -752,9 +791,65 @@ extern size_t mps_message_gc_not_condemned_size(mps_arena_t,
 extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
 
 
+/* GC event hooks
+ *
+ * <a id="gc.event.kinds"> Keep in sync with
+ * <code/mpmtypes.h#gc.event.kinds> */
+
+typedef int mps_gc_event_kind_t;
+enum {
+  MPS_GC_EVENT_START,           /* a collection started */
+  MPS_GC_EVENT_FLIP,            /* a collection flipped */
+  MPS_GC_EVENT_END,             /* a collection finished reclaiming */
+  MPS_GC_EVENT_PRESSURE         /* an allocation hit the commit limit */
+};
+
+typedef struct mps_gc_event_s {
+  mps_gc_event_kind_t kind;     /* what happened */
+  mps_clock_t clock;            /* when it happened */
+  const char *why;              /* START: why the collection started */
+  size_t condemned_size;        /* START, FLIP, END: size condemned */
+  size_t live_size;             /* END: size that survived */
+  size_t not_condemned_size;    /* END: size not condemned */
+  size_t requested_size;        /* PRESSURE: size of failed request */
+  size_t committed;             /* memory committed by the arena */
+} mps_gc_event_s;
+
+typedef void (*mps_gc_event_hook_t)(mps_arena_t, const mps_gc_event_s *,
+                                    void *);
+extern void mps_arena_gc_event_hook_set(mps_arena_t, mps_gc_event_hook_t,
+                                        void *);
+
+
+/* Idle collector */
+
+extern mps_res_t mps_arena_idle_start(mps_arena_t, double);
+extern void mps_arena_idle_stop(mps_arena_t);
+
+
+/* Memory pressure
+ *
+ * <a id="pressure.levels"> Keep in sync with
+ * <code/mpmtypes.h#pressure.levels> */
+
+typedef int mps_pressure_level_t;
+enum {
+  MPS_PRESSURE_MODERATE = 1,    /* crossed the moderate threshold */
+  MPS_PRESSURE_CRITICAL         /* crossed the critical threshold, or
+                                   about to collect or fail */
+};
+
+typedef size_t (*mps_pressure_handler_t)(mps_arena_t, mps_pressure_level_t,
+                                         size_t, void *);
+extern void mps_arena_pressure_handler_set(mps_arena_t,
+                                           mps_pressure_handler_t, void *,
+                                           double, double);
+
+
 /* Finalization */
 
 extern mps_res_t mps_finalize(mps_arena_t, mps_addr_t *);
+extern mps_res_t mps_finalize_many(mps_arena_t, mps_addr_t *, size_t);
 extern mps_res_t mps_definalize(mps_arena_t, mps_addr_t *);
 
 
@@ -9,6 +9,16 @@
 
 #include "mps.h"
 
+extern const struct mps_key_s _mps_key_AMC_PROMOTE_SURVIVAL;
+#define MPS_KEY_AMC_PROMOTE_SURVIVAL (&_mps_key_AMC_PROMOTE_SURVIVAL)
+#define MPS_KEY_AMC_PROMOTE_SURVIVAL_FIELD d
+extern const struct mps_key_s _mps_key_AMC_OBJECT_STARTS;
+#define MPS_KEY_AMC_OBJECT_STARTS (&_mps_key_AMC_OBJECT_STARTS)
+#define MPS_KEY_AMC_OBJECT_STARTS_FIELD b
+extern const struct mps_key_s _mps_key_AMC_AUTO_RAMP;
+#define MPS_KEY_AMC_AUTO_RAMP (&_mps_key_AMC_AUTO_RAMP)
+#define MPS_KEY_AMC_AUTO_RAMP_FIELD b
+
 extern mps_pool_class_t mps_class_amc(void);
 extern mps_pool_class_t mps_class_amcz(void);
 
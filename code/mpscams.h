@@ -13,6 +13,9 @@
 extern const struct mps_key_s _mps_key_AMS_SUPPORT_AMBIGUOUS;
 #define MPS_KEY_AMS_SUPPORT_AMBIGUOUS (&_mps_key_AMS_SUPPORT_AMBIGUOUS)
 #define MPS_KEY_AMS_SUPPORT_AMBIGUOUS_FIELD b
+extern const struct mps_key_s _mps_key_AMS_OBJECT_SIZE;
+#define MPS_KEY_AMS_OBJECT_SIZE (&_mps_key_AMS_OBJECT_SIZE)
+#define MPS_KEY_AMS_OBJECT_SIZE_FIELD size
 
 extern mps_pool_class_t mps_class_ams(void);
 extern mps_pool_class_t mps_class_ams_debug(void);
@@ -12,11 +12,20 @@
 extern const struct mps_key_s _mps_key_AWL_FIND_DEPENDENT;
 #define MPS_KEY_AWL_FIND_DEPENDENT (&_mps_key_AWL_FIND_DEPENDENT)
 #define MPS_KEY_AWL_FIND_DEPENDENT_FIELD addr_method
+extern const struct mps_key_s _mps_key_AWL_RECORD_SPLATS;
+#define MPS_KEY_AWL_RECORD_SPLATS (&_mps_key_AWL_RECORD_SPLATS)
+#define MPS_KEY_AWL_RECORD_SPLATS_FIELD b
 
 extern mps_pool_class_t mps_class_awl(void);
 
 typedef mps_addr_t (*mps_awl_find_dependent_t)(mps_addr_t addr);
 
+typedef void (*mps_awl_splat_visitor_t)(mps_addr_t obj, mps_addr_t *slot,
+                                        void *closure);
+extern void mps_awl_splats_walk(mps_pool_t pool,
+                                mps_awl_splat_visitor_t visitor,
+                                void *closure);
+
 #endif /* mpscawl_h */
 
 
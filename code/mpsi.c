@@ -84,6 +84,20 @@ static Bool mpsi_check(void)
   CHECKL((int)MessageTypeGCSTART
          == (int)_mps_MESSAGE_TYPE_GC_START);
 
+  /* Check that external and internal GC event kinds match. */
+  /* See <code/mps.h#gc.event.kinds> and */
+  /* <code/mpmtypes.h#gc.event.kinds>. */
+  CHECKL((int)GCEventSTART == (int)MPS_GC_EVENT_START);
+  CHECKL((int)GCEventFLIP == (int)MPS_GC_EVENT_FLIP);
+  CHECKL((int)GCEventEND == (int)MPS_GC_EVENT_END);
+  CHECKL((int)GCEventPRESSURE == (int)MPS_GC_EVENT_PRESSURE);
+
+  /* Check that external and internal pressure levels match. */
+  /* See <code/mps.h#pressure.levels> and */
+  /* <code/mpmtypes.h#pressure.levels>. */
+  CHECKL((int)PressureMODERATE == (int)MPS_PRESSURE_MODERATE);
+  CHECKL((int)PressureCRITICAL == (int)MPS_PRESSURE_CRITICAL);
+
   /* The external idea of a word width and the internal one */
   /* had better match.  <design/interface-c#.cons>. */
   CHECKL(sizeof(mps_word_t) == sizeof(void *));
@@ -198,6 +212,35 @@ mps_res_t mps_arena_commit_limit_set(mps_arena_t arena, size_t limit)
   return (mps_res_t)res;
 }
 
+size_t mps_arena_soft_limit(mps_arena_t arena)
+{
+  Size size;
+
+  ArenaEnter(arena);
+  size = ArenaSoftLimit(arena);
+  ArenaLeave(arena);
+
+  return size;
+}
+
+void mps_arena_soft_limit_set(mps_arena_t arena, size_t limit)
+{
+  ArenaEnter(arena);
+  ArenaSetSoftLimit(arena, limit);
+  ArenaLeave(arena);
+}
+
+mps_res_t mps_arena_soft_limit_refresh(mps_arena_t arena)
+{
+  Res res;
+
+  ArenaEnter(arena);
+  res = ArenaRefreshSoftLimit(arena);
+  ArenaLeave(arena);
+
+  return (mps_res_t)res;
+}
+
 void mps_arena_spare_set(mps_arena_t arena, double spare)
 {
   ArenaEnter(arena);
@@ -386,6 +429,7 @@ mps_res_t mps_arena_create_k(mps_arena_t *mps_arena_o,
 
 void mps_arena_destroy(mps_arena_t arena)
 {
+  ArenaIdleStop(arena);
   ArenaEnter(arena);
   ArenaDestroy(arena);
 }
@@ -798,10 +842,14 @@ size_t mps_pool_free_size(mps_pool_t pool)
 }
 
 
-mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
+/* mpsAlloc -- allocate from a pool, returning the size released by
+ * the client's pressure handler on the way out of the arena.
+ */
+
+static Res mpsAlloc(Addr *pReturn, Size *releasedReturn,
+                    Pool pool, size_t size)
 {
   Arena arena;
-  Addr p;
   Res res;
 
   AVER_CRITICAL(TESTT(Pool, pool));
@@ -812,16 +860,31 @@ mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
 
     ArenaPoll(ArenaGlobals(arena)); /* .poll */
 
-    AVER_CRITICAL(p_o != NULL);
+    AVER_CRITICAL(pReturn != NULL);
     AVERT_CRITICAL(Pool, pool);
     AVER_CRITICAL(size > 0);
     /* Note: class may allow unaligned size, see */
     /* <design/pool#.method.alloc.size.align>. */
 
-    res = PoolAlloc(&p, pool, size);
+    res = PoolAlloc(pReturn, pool, size);
 
   } STACK_CONTEXT_END(arena);
-  ArenaLeave(arena);
+  *releasedReturn = ArenaLeaveRelieved(arena);
+  return res;
+}
+
+mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
+{
+  Addr p;
+  Size released;
+  Res res;
+
+  AVER_CRITICAL(p_o != NULL);
+
+  res = mpsAlloc(&p, &released, pool, size);
+  if (res == ResCOMMIT_LIMIT && released > 0)
+    /* <design/message-gc#.pressure.retry> */
+    res = mpsAlloc(&p, &released, pool, size);
 
   if (res != ResOK)
     return (mps_res_t)res;
@@ -1080,11 +1143,15 @@ mps_res_t (mps_ap_frame_pop)(mps_ap_t mps_ap, mps_frame_t frame)
  * mps_reserve macro, but may be "called" directly by the client code
  * if necessary. See <manual/topic/allocation> */
 
-mps_res_t mps_ap_fill(mps_addr_t *p_o, mps_ap_t mps_ap, size_t size)
+/* apFill -- fill an allocation point, returning the size released by
+ * the client's pressure handler on the way out of the arena.
+ */
+
+static Res apFill(Addr *pReturn, Size *releasedReturn,
+                  mps_ap_t mps_ap, size_t size)
 {
   Buffer buf = BufferOfAP(mps_ap);
   Arena arena;
-  Addr p;
   Res res;
 
   AVER(mps_ap != NULL);
@@ -1096,15 +1163,30 @@ mps_res_t mps_ap_fill(mps_addr_t *p_o, mps_ap_t mps_ap, size_t size)
 
     ArenaPoll(ArenaGlobals(arena)); /* .poll */
 
-    AVER(p_o != NULL);
+    AVER(pReturn != NULL);
     AVERT(Buffer, buf);
     AVER(size > 0);
     AVER(SizeIsAligned(size, BufferPool(buf)->alignment)); /* <design/check/#.common> */
 
-    res = BufferFill(&p, buf, size);
+    res = BufferFill(pReturn, buf, size);
 
   } STACK_CONTEXT_END(arena);
-  ArenaLeave(arena);
+  *releasedReturn = ArenaLeaveRelieved(arena);
+  return res;
+}
+
+mps_res_t mps_ap_fill(mps_addr_t *p_o, mps_ap_t mps_ap, size_t size)
+{
+  Addr p;
+  Size released;
+  Res res;
+
+  AVER(p_o != NULL);
+
+  res = apFill(&p, &released, mps_ap, size);
+  if (res == ResCOMMIT_LIMIT && released > 0)
+    /* <design/message-gc#.pressure.retry> */
+    res = apFill(&p, &released, mps_ap, size);
 
   if (res != ResOK)
     return (mps_res_t)res;
@@ -1718,6 +1800,22 @@ mps_res_t mps_finalize(mps_arena_t arena, mps_addr_t *refref)
 }
 
 
+/* mps_finalize_many -- register an array of objects for finalization */
+
+mps_res_t mps_finalize_many(mps_arena_t arena, mps_addr_t *refs,
+                            size_t count)
+{
+  Res res;
+
+  ArenaEnter(arena);
+
+  res = ArenaFinalizeMany(arena, (Ref *)refs, count);
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
 /* mps_definalize -- deregister for finalization */
 
 mps_res_t mps_definalize(mps_arena_t arena, mps_addr_t *refref)
@@ -1735,6 +1833,54 @@ mps_res_t mps_definalize(mps_arena_t arena, mps_addr_t *refref)
 }
 
 
+/* GC event hooks */
+
+
+void mps_arena_gc_event_hook_set(mps_arena_t arena,
+                                 mps_gc_event_hook_t hook, void *closure)
+{
+  ArenaEnter(arena);
+  ArenaGCEventHookSet(arena, hook, closure);
+  ArenaLeave(arena);
+}
+
+
+/* Idle collector */
+
+
+mps_res_t mps_arena_idle_start(mps_arena_t arena, double period)
+{
+  Res res;
+
+  ArenaEnter(arena);
+  AVER(period >= ARENA_IDLE_PERIOD_MIN);
+  res = ArenaIdleStart(arena, period);
+  ArenaLeave(arena);
+
+  return (mps_res_t)res;
+}
+
+
+void mps_arena_idle_stop(mps_arena_t arena)
+{
+  ArenaIdleStop(arena);
+}
+
+
+/* Memory pressure */
+
+
+void mps_arena_pressure_handler_set(mps_arena_t arena,
+                                    mps_pressure_handler_t handler,
+                                    void *closure,
+                                    double moderate, double critical)
+{
+  ArenaEnter(arena);
+  ArenaPressureHandlerSet(arena, handler, closure, moderate, critical);
+  ArenaLeave(arena);
+}
+
+
 /* Messages */
 
 
@@ -1873,6 +2019,34 @@ void mps_message_finalization_ref(mps_addr_t *mps_addr_return,
   ArenaLeave(arena);
 }
 
+/* mps_finalization_get -- get and discard many finalization messages
+ *
+ * Store the references from up to count finalization messages in the
+ * array refs, discard the messages, and return the number stored.
+ */
+
+size_t mps_finalization_get(mps_arena_t arena, mps_addr_t *refs,
+                            size_t count)
+{
+  Index i;
+
+  ArenaEnter(arena);
+
+  AVER(refs != NULL || count == 0);
+  for (i = 0; i < count; ++i) {
+    Message message;
+    Ref ref;
+    if (!MessageGet(&message, arena, MessageTypeFINALIZATION))
+      break;
+    MessageFinalizationRef(&ref, arena, message);
+    ArenaPoke(arena, (Ref *)&refs[i], ref);
+    MessageDiscard(arena, message);
+  }
+
+  ArenaLeave(arena);
+  return (size_t)i;
+}
+
 /* -- mps_message_type_gc */
 
 size_t mps_message_gc_live_size(mps_arena_t arena,
@@ -2080,6 +2254,23 @@ mps_res_t mps_chain_create(mps_chain_t *chain_o, mps_arena_t arena,
 }
 
 
+/* mps_chain_adapt -- make a chain's generation capacities adaptive */
+
+void mps_chain_adapt(mps_chain_t chain, size_t gen_count,
+                     mps_gen_bounds_s *bounds, double interval,
+                     double pause)
+{
+  Arena arena;
+
+  AVER(TESTT(Chain, chain));
+  arena = chain->arena;
+
+  ArenaEnter(arena);
+  ChainAdapt(chain, gen_count, (GenBoundsStruct *)bounds, interval, pause);
+  ArenaLeave(arena);
+}
+
+
 /* mps_chain_destroy -- destroy a chain */
 
 void mps_chain_destroy(mps_chain_t chain)
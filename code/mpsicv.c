@@ -294,6 +294,9 @@ static mps_res_t root_single(mps_ss_t ss, void *p, size_t s)
  *   mps_arena_commit_limit_set
  *   mps_arena_committed
  *   mps_arena_reserved
+ *   mps_arena_soft_limit
+ *   mps_arena_soft_limit_refresh
+ *   mps_arena_soft_limit_set
  *   mps_arena_spare
  *   mps_arena_spare_committed
  *   mps_arena_spare_set
@@ -343,6 +346,13 @@ static void arena_commit_test(mps_arena_t arena)
   die(mps_arena_commit_limit_set(arena, limit), "commit_limit_set after");
   res = mps_alloc(&p, pool, FILLER_OBJECT_SIZE);
   die_expect(res, MPS_RES_OK, "Allocation failed after raising commit_limit");
+  Insist(mps_arena_soft_limit(arena) == (size_t)-1);
+  die(mps_arena_soft_limit_refresh(arena), "soft_limit_refresh");
+  Insist(mps_arena_soft_limit(arena) == (size_t)-1);
+  mps_arena_soft_limit_set(arena, 0);
+  Insist(mps_arena_soft_limit(arena) == 0);
+  Insist(mps_arena_spare_committed(arena) == 0);
+  mps_arena_soft_limit_set(arena, (size_t)-1);
   mps_arena_spare_set(arena, 0.0);
   Insist(mps_arena_spare(arena) == 0.0);
   Insist(mps_arena_spare_committed(arena) == 0);
@@ -350,6 +360,75 @@ static void arena_commit_test(mps_arena_t arena)
 }
 
 
+/* arena_pressure_test -- check the pressure handler runs before the
+ * commit limit makes an allocation fail
+ *
+ * intended to test:
+ *   mps_arena_pressure_handler_set
+ */
+
+static mps_pool_t pressurePool;
+static mps_addr_t pressureCache;
+static size_t pressureCacheSize;
+static size_t pressureCalls;
+
+static size_t pressureHandler(mps_arena_t arena, mps_pressure_level_t level,
+                              size_t target, void *closure)
+{
+  size_t released = 0;
+
+  Insist(arena != NULL);
+  Insist(closure == &pressureCalls);
+  Insist(level == MPS_PRESSURE_MODERATE || level == MPS_PRESSURE_CRITICAL);
+  Insist(target > 0);
+  ++ pressureCalls;
+  if (pressureCache != NULL) {
+    /* The handler can call the MPS. */
+    mps_free(pressurePool, pressureCache, pressureCacheSize);
+    pressureCache = NULL;
+    released = pressureCacheSize;
+  }
+  return released;
+}
+
+static void arena_pressure_test(mps_arena_t arena)
+{
+  size_t limit;
+  void *p;
+  mps_res_t res;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, 0x1000);
+    MPS_ARGS_ADD(args, MPS_KEY_MEAN_SIZE, 1024);
+    MPS_ARGS_ADD(args, MPS_KEY_MAX_SIZE, 16384);
+    die(mps_pool_create_k(&pressurePool, arena, mps_class_mvff(), args),
+        "pressure pool create");
+  } MPS_ARGS_END(args);
+
+  pressureCacheSize = 16 * FILLER_OBJECT_SIZE;
+  die(mps_alloc(&pressureCache, pressurePool, pressureCacheSize),
+      "pressure cache");
+  pressureCalls = 0;
+  mps_arena_pressure_handler_set(arena, pressureHandler, &pressureCalls,
+                                 0.5, 0.9);
+  Insist(pressureCalls == 0);
+
+  limit = mps_arena_commit_limit(arena);
+  die(mps_arena_commit_limit_set(arena, mps_arena_committed(arena)),
+      "commit_limit_set before");
+  do {
+    res = mps_alloc(&p, pressurePool, FILLER_OBJECT_SIZE);
+  } while (res == MPS_RES_OK);
+  die_expect(res, MPS_RES_COMMIT_LIMIT, "Commit limit allocation");
+  Insist(pressureCalls > 0);
+  Insist(pressureCache == NULL);
+  die(mps_arena_commit_limit_set(arena, limit), "commit_limit_set after");
+
+  mps_arena_pressure_handler_set(arena, NULL, NULL, 0.8, 0.95);
+  mps_pool_destroy(pressurePool);
+}
+
+
 static void test(mps_arena_t arena)
 {
   mps_fmt_t format;
@@ -528,6 +607,7 @@ static void test(mps_arena_t arena)
   }
 
   arena_commit_test(arena);
+  arena_pressure_test(arena);
   alignmentTest(arena);
 
   die(mps_arena_collect(arena), "collect");
@@ -553,6 +633,50 @@ static void test(mps_arena_t arena)
 #define TEST_ARENA_SIZE              ((size_t)16<<20)
 
 
+/* arena_spare_decay_test -- check that spare memory decays
+ *
+ * intended to test:
+ *   MPS_KEY_SPARE_HALF_LIFE
+ * incidentally tests:
+ *   mps_arena_step
+ */
+
+#define spareHALF_LIFE  0.01    /* seconds */
+#define spareTIMEOUT    10      /* seconds to wait for decay */
+
+static void arena_spare_decay_test(void)
+{
+  mps_arena_t arena;
+  mps_pool_t pool;
+  mps_addr_t p;
+  size_t i, spare;
+  mps_clock_t timeout;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, TEST_ARENA_SIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE, 1.0);
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE_HALF_LIFE, spareHALF_LIFE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create(spare decay)");
+  } MPS_ARGS_END(args);
+  die(mps_pool_create_k(&pool, arena, mps_class_mvff(), mps_args_none),
+      "pool_create(spare decay)");
+  for (i = 0; i < 256; ++i)
+    die(mps_alloc(&p, pool, 0x4000), "alloc(spare decay)");
+  mps_pool_destroy(pool);
+
+  /* The memory is kept at first, and returned gradually. */
+  spare = mps_arena_spare_committed(arena);
+  Insist(spare >= 256 * 0x4000);
+  timeout = mps_clock() + (mps_clock_t)spareTIMEOUT * mps_clocks_per_sec();
+  while (mps_arena_spare_committed(arena) > spare / 4) {
+    Insist(mps_clock() < timeout);
+    (void)mps_arena_step(arena, 0.0, 0.0);
+  }
+  mps_arena_destroy(arena);
+}
+
+
 int main(int argc, char *argv[])
 {
   mps_arena_t arena;
@@ -562,6 +686,8 @@ int main(int argc, char *argv[])
 
   testlib_init(argc, argv);
 
+  arena_spare_decay_test();
+
   MPS_ARGS_BEGIN(args) {
     /* Randomize pause time as a regression test for job004011. */
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, rnd_pause_time());
@@ -321,6 +321,34 @@ Bool NailboardIsSetRange(Nailboard board, Addr base, Addr limit)
 }
 
 
+/* NailboardFindNail -- find the lowest nail set in a range
+ *
+ * If any nail is set in the range between base and limit, update
+ * *nailReturn to the lowest address corresponding to the lowest such
+ * nail that is not below base, and return TRUE. Otherwise return
+ * FALSE. It is an error if any part of the range is not covered by
+ * the nailboard.
+ *
+ * <design/nailboard#.impl.find>.
+ */
+
+Bool NailboardFindNail(Addr *nailReturn, Nailboard board,
+                       Addr base, Addr limit)
+{
+  Index i, ibase, ilimit;
+
+  AVER(nailReturn != NULL);
+  AVERT(Nailboard, board);
+  AVER(base < limit);
+
+  nailboardIndexRange(&ibase, &ilimit, board, 0, base, limit);
+  if (!BTFindFirstSet(&i, board->level[0], ibase, ilimit))
+    return FALSE;
+  *nailReturn = i == ibase ? base : nailboardAddr(board, 0, i);
+  return TRUE;
+}
+
+
 /* NailboardIsResRange -- test if all nails are reset in a range
  *
  * Return TRUE if no nails are set in the range between base and
@@ -50,10 +50,27 @@ Res PolicyAlloc(Tract *tractReturn, Arena arena, LocusPref pref,
     Size necessaryCommitIncrease = size - arena->spareCommitted;
     if (arena->committed + necessaryCommitIncrease > arena->commitLimit
         || arena->committed + necessaryCommitIncrease < arena->committed) {
+      ArenaPostPressureEvent(arena, size);
+      ArenaPostPressure(arena, PressureCRITICAL, size);
       return ResCOMMIT_LIMIT;
     }
   }
 
+  /* Plan 0: allocate at the preferred address. This is memory that
+   * the pool used recently, so it's likely to be in cache. But not if
+   * the range is in a zone that the pool wants to avoid, since the
+   * other plans would only allocate there as a last resort.
+   * <design/strategy#.policy.nursery.avoid>. */
+  if (pref->base != NULL
+      && ZoneSetInter(ZoneSetOfRange(arena, pref->base,
+                                     AddrAdd(pref->base, size)),
+                      pref->avoid) == ZoneSetEMPTY)
+  {
+    res = ArenaFreeLandAllocAt(&tract, arena, pref->base, size, pool);
+    if (res == ResOK)
+      goto found;
+  }
+
   /* Plan A: allocate from the free land in the requested zones */
   zones = ZoneSetDiff(pref->zones, pref->avoid);
   if (zones != ZoneSetEMPTY) {
@@ -131,30 +148,81 @@ found:
 }
 
 
+/* policyCollectionRate -- estimate rate of collecting a generation
+ *
+ * Return an estimate of the rate (in work per second) of a collection
+ * whose oldest condemned generation is gen. Use the generation's own
+ * measurements if there are any, otherwise the average over all
+ * collections, otherwise a default. gen may be NULL, meaning that
+ * there is no particular generation. <design/strategy#.policy.model>.
+ */
+
+static double policyCollectionRate(Arena arena, GenDesc gen)
+{
+  AVERT(Arena, arena);
+
+  if (gen != NULL && gen->collectionRate > 0.0)
+    return gen->collectionRate;
+  /* The condition arena->tracedTime >= 1.0 ensures that the division
+   * can't overflow. */
+  if (arena->tracedTime >= 1.0)
+    return arena->tracedWork / arena->tracedTime;
+  return ARENA_DEFAULT_COLLECTION_RATE;
+}
+
+
 /* policyCollectionTime -- estimate time to collect the world, in seconds */
 
 static double policyCollectionTime(Arena arena)
 {
   Size collectableSize;
-  double collectionRate;
   double collectionTime;
+  GenDesc topGen;
 
   AVERT(Arena, arena);
 
+  /* Collections of the world condemn the arena's top generation. */
+  topGen = &arena->topGen;
   collectableSize = ArenaCollectable(arena);
-  /* The condition arena->tracedTime >= 1.0 ensures that the division
-   * can't overflow. */
-  if (arena->tracedTime >= 1.0)
-    collectionRate = arena->tracedWork / arena->tracedTime;
+  collectionTime = (double)collectableSize
+    / policyCollectionRate(arena, topGen);
+  if (topGen->collections > 0)
+    collectionTime += topGen->collectionOverhead;
   else
-    collectionRate = ARENA_DEFAULT_COLLECTION_RATE;
-  collectionTime = (double)collectableSize / collectionRate;
-  collectionTime += ARENA_DEFAULT_COLLECTION_OVERHEAD;
+    collectionTime += ARENA_DEFAULT_COLLECTION_OVERHEAD;
 
   return collectionTime;
 }
 
 
+/* policyLimitQuantum -- limit the work done by a trace in each poll
+ *
+ * TraceStart sizes the quantum of work so that the trace finishes
+ * before the mutator has allocated too much, but takes no account of
+ * how long a quantum will take. If the measured rate of collecting the
+ * trace's oldest generation means a quantum would take longer than
+ * the arena's pause time, make it smaller. PolicyPollAgain keeps
+ * doing quanta while there is time left, so this does not reduce the
+ * amount of work done in each pause, only the overshoot.
+ */
+
+static void policyLimitQuantum(Arena arena, Trace trace)
+{
+  GenDesc gen;
+  double maxWork;
+
+  AVERT(Arena, arena);
+  AVERT(Trace, trace);
+
+  gen = GenDescOldestCondemned(trace);
+  if (gen == NULL || gen->collectionRate == 0.0)
+    return;
+  maxWork = gen->collectionRate * ArenaPauseTime(arena);
+  if (maxWork >= 1.0 && (double)trace->quantumWork > maxWork)
+    trace->quantumWork = (Work)maxWork;
+}
+
+
 /* PolicyShouldCollectWorld -- should we collect the world now?
  *
  * Return TRUE if we should try collecting the world now, FALSE if
@@ -198,6 +266,26 @@ Bool PolicyShouldCollectWorld(Arena arena, double availableTime,
 }
 
 
+/* policySoftLimitCollect -- may the soft limit start a world collection?
+ *
+ * The soft limit may be less than the live set, so a collection
+ * started because of it mustn't be immediately followed by another,
+ * as the dynamic criterion would be. So apply the same limit on the
+ * fraction of time spent collecting the world as
+ * PolicyShouldCollectWorld. <design/strategy#.policy.soft-limit>.
+ */
+
+static Bool policySoftLimitCollect(Arena arena)
+{
+  double sinceLastWorldCollect;
+
+  sinceLastWorldCollect = (double)(ClockNow() - arena->lastWorldCollect)
+    / (double)ClocksPerSec();
+  return sinceLastWorldCollect
+    > policyCollectionTime(arena) / ARENA_MAX_COLLECT_FRACTION;
+}
+
+
 /* policyCondemnChain -- condemn appropriate parts of this chain
  *
  * If successful, set *mortalityReturn to an estimate of the mortality
@@ -279,7 +367,7 @@ Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
   if (collectWorldAllowed) {
     Size sFoundation, sCondemned, sSurvivors, sConsTrace;
     double tTracePerScan; /* tTrace/cScan */
-    double dynamicDeferral;
+    double dynamicDeferral, softDeferral, credit;
 
     /* Compute dynamic criterion.  See strategy.lisp-machine. */
     sFoundation = (Size)0; /* condemning everything, only roots @@@@ */
@@ -292,13 +380,30 @@ Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
     AVER((double)sSurvivors + tTracePerScan * TraceWorkFactor
          <= (double)SizeMAX);
     sConsTrace = (Size)((double)sSurvivors + tTracePerScan * TraceWorkFactor);
-    dynamicDeferral = (double)ArenaAvail(arena) - (double)sConsTrace;
-
-    if (dynamicDeferral < 0.0) {
+    /* Memory that the client's pressure handler released may still
+     * be held by its pools, so credit it to this decision.
+     * <design/message-gc#.pressure.account> */
+    credit = (double)ArenaPressureCreditTake(arena);
+    dynamicDeferral = (double)ArenaAvail(arena) + credit - (double)sConsTrace;
+    softDeferral = (double)ArenaSoftAvail(arena) + credit - (double)sConsTrace;
+
+    if ((dynamicDeferral < 0.0
+         || (softDeferral < 0.0 && policySoftLimitCollect(arena)))
+        && !ArenaPressureDefer(arena, (Size)(dynamicDeferral < softDeferral
+                                              ? -dynamicDeferral
+                                              : -softDeferral)))
+    {
       /* Start full collection. */
-      res = TraceStartCollectAll(&trace, arena, TraceStartWhyDYNAMICCRITERION);
+      TraceStartWhy why = TraceStartWhyDYNAMICCRITERION;
+      arena->pressureAsked = FALSE;
+      if (dynamicDeferral >= 0.0) {
+        why = TraceStartWhySOFTLIMIT;
+        arena->lastWorldCollect = ClockNow();
+      }
+      res = TraceStartCollectAll(&trace, arena, why);
       if (res != ResOK)
         goto failStart;
+      policyLimitQuantum(arena, trace);
       *collectWorldReturn = TRUE;
       *traceReturn = trace;
       return TRUE;
@@ -336,6 +441,7 @@ Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
                        (double)trace->condemned * TraceWorkFactor);
       /* We don't expect normal GC traces to fail to start. */
       AVER(res == ResOK);
+      policyLimitQuantum(arena, trace);
       *traceReturn = trace;
       return TRUE;
     }
@@ -378,17 +484,25 @@ Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
 {
   Bool moreTime;
   Globals globals;
-  double nextPollThreshold;
+  double nextPollThreshold, elapsed, nextTime = 0.0;
 
   AVERT(Arena, arena);
-  UNUSED(tracedWork);
 
   if (ArenaEmergency(arena))
     return TRUE;
 
+  /* Predict how long another unit of work like the last one would
+   * take, if the rate for the running trace's oldest generation has
+   * been measured. <design/strategy#.policy.model> */
+  if (arena->busyTraces != TraceSetEMPTY) {
+    GenDesc gen = GenDescOldestCondemned(ArenaTrace(arena, (TraceId)0));
+    if (gen != NULL && gen->collectionRate > 0.0)
+      nextTime = (double)tracedWork / gen->collectionRate;
+  }
+
   /* Is there more work to do and more time to do it in? */
-  moreTime = (double)(ClockNow() - start)
-    < ArenaPauseTime(arena) * (double)ClocksPerSec();
+  elapsed = (double)(ClockNow() - start) / (double)ClocksPerSec();
+  moreTime = elapsed + nextTime < ArenaPauseTime(arena);
   if (moreWork && moreTime)
     return TRUE;
 
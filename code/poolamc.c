@@ -56,6 +56,9 @@ typedef struct amcGenStruct {
   PoolGenStruct pgen;
   RingStruct amcRing;           /* link in list of gens in pool */
   Buffer forward;               /* forwarding buffer */
+  double survival;              /* <design/poolamc#.promote.survival> */
+  Count promoteTick;            /* <design/poolamc#.promote.sample> */
+  Count promoted;               /* segments promoted in place from here */
   Sig sig;                      /* design.mps.sig.field.end.outer */
 } amcGenStruct;
 
@@ -99,6 +102,23 @@ enum {
  * collection via TracePoll), and by hash array allocations (where we
  * don't want the allocation to provoke a collection that makes the
  * location dependency stale immediately).
+ *
+ * .seg.large: The "large" flag is TRUE if the segment was created by
+ * amcBufferFill for a single large reserve, so that it holds just one
+ * object followed by padding. See <design/poolamc#.large.single-reserve>.
+ * The segment's size is no guide: an ordinary segment may be as big
+ * as amc->largeSize if extendBy or the arena grain size is.
+ *
+ * .seg.promote: The "promote" flag is TRUE if the segment is a large
+ * segment whose object was preserved in place by amcSegFix, so that
+ * amcSegReclaimNailed should move the segment to the next generation
+ * instead of leaving it where it is. See <design/poolamc#.large.promote>.
+ *
+ * .seg.starts: If the pool keeps object-start tables, "starts" is a
+ * bit table with one bit for each alignment grain in the segment, or
+ * NULL if the table has not been created yet. The bits for the bases
+ * of all the objects below "startsLimit" are set, and all other bits
+ * below startsLimit are reset. See <design/poolamc#.starts>.
  */
 
 typedef struct amcSegStruct *amcSeg;
@@ -113,6 +133,10 @@ typedef struct amcSegStruct {
   BOOLFIELD(accountedAsBuffered); /* .seg.accounted-as-buffered */
   BOOLFIELD(old);           /* .seg.old */
   BOOLFIELD(deferred);      /* .seg.deferred */
+  BOOLFIELD(large);         /* .seg.large */
+  BOOLFIELD(promote);       /* .seg.promote */
+  BT starts;                /* .seg.starts */
+  Addr startsLimit;         /* limit of valid part of starts */
   Sig sig;                  /* design.mps.sig.field.end.outer */
 } amcSegStruct;
 
@@ -127,9 +151,16 @@ static Bool amcSegCheck(amcSeg amcseg)
     CHECKD(Nailboard, amcseg->board);
     CHECKL(SegNailed(MustBeA(Seg, amcseg)) != TraceSetEMPTY);
   }
+  if (amcseg->starts != NULL) {
+    Seg seg = MustBeA(Seg, amcseg);
+    CHECKL(SegBase(seg) <= amcseg->startsLimit);
+    CHECKL(amcseg->startsLimit <= SegLimit(seg));
+  }
   /* CHECKL(BoolCheck(amcseg->accountedAsBuffered)); <design/type#.bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->old)); <design/type#.bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->deferred)); <design/type#.bool.bitfield.check> */
+  /* CHECKL(BoolCheck(amcseg->large)); <design/type#.bool.bitfield.check> */
+  /* CHECKL(BoolCheck(amcseg->promote)); <design/type#.bool.bitfield.check> */
   return TRUE;
 }
 
@@ -160,6 +191,10 @@ static Res AMCSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   amcseg->accountedAsBuffered = FALSE;
   amcseg->old = FALSE;
   amcseg->deferred = FALSE;
+  amcseg->large = FALSE;
+  amcseg->promote = FALSE;
+  amcseg->starts = NULL;
+  amcseg->startsLimit = base;
 
   SetClassOfPoly(seg, CLASS(amcSeg));
   amcseg->sig = amcSegSig;
@@ -176,6 +211,13 @@ static void amcSegFinish(Inst inst)
   Seg seg = MustBeA(Seg, inst);
   amcSeg amcseg = MustBeA(amcSeg, seg);
 
+  if (amcseg->starts != NULL) {
+    Pool pool = SegPool(seg);
+    BTDestroy(amcseg->starts, PoolArena(pool),
+              SegSize(seg) >> pool->alignShift);
+    amcseg->starts = NULL;
+  }
+
   amcseg->sig = SigInvalid;
 
   /* finish the superclass fields last */
@@ -419,9 +461,18 @@ typedef struct AMCStruct { /* <design/poolamc#.struct> */
   amcGen afterRampGen;     /* the generation after rampGen */
   unsigned rampCount;      /* <design/poolamc#.ramp.count> */
   int rampMode;            /* <design/poolamc#.ramp.mode> */
+  Bool autoRamp;           /* detect ramps? <design/poolamc#.ramp.auto> */
+  Bool autoRamping;        /* in an automatically detected ramp? */
+  Count autoRampVotes;     /* consecutive samples for a change */
+  Epoch autoRampEpoch;     /* epoch of last sample */
+  Clock autoRampClock;     /* time of last sample */
+  double autoRampFilled;   /* bytes filled by mutator buffers */
+  double autoRampRate;     /* moving average of allocation rate */
   amcPinnedFunction pinned; /* function determining if block is pinned */
   Size extendBy;           /* segment size to extend pool by */
   Size largeSize;          /* min size of "large" segments */
+  double promoteSurvival;  /* <design/poolamc#.promote.threshold> */
+  Bool objectStarts;       /* keep object-start tables? .seg.starts */
   Sig sig;                 /* design.mps.sig.field.end.outer */
 } AMCStruct;
 
@@ -439,6 +490,8 @@ static Bool amcGenCheck(amcGen gen)
   CHECKU(AMC, amc);
   CHECKD(Buffer, gen->forward);
   CHECKD_NOSIG(Ring, &gen->amcRing);
+  CHECKL(gen->survival >= 0.0);
+  CHECKL(gen->survival <= 1.0);
 
   return TRUE;
 }
@@ -587,6 +640,9 @@ static Res amcGenCreate(amcGen *genReturn, AMC amc, GenDesc gen)
     goto failGenInit;
   RingInit(&amcgen->amcRing);
   amcgen->forward = buffer;
+  amcgen->survival = 0.0;
+  amcgen->promoteTick = 0;
+  amcgen->promoted = 0;
   amcgen->sig = amcGenSig;
 
   AVERT(amcGen, amcgen);
@@ -636,7 +692,9 @@ static Res amcGenDescribe(amcGen gen, mps_lib_FILE *stream, Count depth)
 
   res = WriteF(stream, depth,
                "amcGen $P {\n", (WriteFP)gen,
-               "  buffer $P\n", (WriteFP)gen->forward, NULL);
+               "  buffer $P\n", (WriteFP)gen->forward,
+               "  survival $D\n", (WriteFD)gen->survival,
+               "  promoted $U\n", (WriteFU)gen->promoted, NULL);
   if (res != ResOK)
     return res;
 
@@ -649,6 +707,114 @@ static Res amcGenDescribe(amcGen gen, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* amcSegStartsIndex -- index of an address in the object-start table */
+
+static Index amcSegStartsIndex(Seg seg, Addr addr)
+{
+  return AddrOffset(SegBase(seg), addr) >> SegPool(seg)->alignShift;
+}
+
+
+/* amcSegStartsUpdate -- bring a segment's object-start table up to date
+ *
+ * Record the base of every object in the segment that starts below
+ * limit, creating the table first if necessary. Return FALSE if the
+ * pool doesn't keep object-start tables, or if the table can't be
+ * created. The segment must be exposed. <design/poolamc#.starts>.
+ */
+
+static Bool amcSegStartsUpdate(Seg seg, Addr limit)
+{
+  amcSeg amcseg = MustBeA_CRITICAL(amcSeg, seg);
+  Pool pool = SegPool(seg);
+  AMC amc = MustBeA_CRITICAL(AMCZPool, pool);
+  Format format = pool->format;
+  Size headerSize = format->headerSize;
+  Addr p;
+
+  if (!amc->objectStarts)
+    return FALSE;
+  AVER_CRITICAL(limit <= SegLimit(seg));
+
+  if (amcseg->starts == NULL) {
+    BT starts;
+    Count length = SegSize(seg) >> pool->alignShift;
+    Res res = BTCreate(&starts, PoolArena(pool), length);
+    if (res != ResOK)
+      return FALSE;
+    BTResRange(starts, 0, length);
+    amcseg->starts = starts;
+    amcseg->startsLimit = SegBase(seg);
+  }
+
+  p = amcseg->startsLimit;
+  while (p < limit) {
+    Addr q = AddrSub((*format->skip)(AddrAdd(p, headerSize)), headerSize);
+    AVER_CRITICAL(p < q);
+    BTSet(amcseg->starts, amcSegStartsIndex(seg, p));
+    p = q;
+  }
+  AVER_CRITICAL(p <= SegLimit(seg));
+  amcseg->startsLimit = p;
+  return TRUE;
+}
+
+
+/* amcSegStartsFind -- find the base of the object containing an address
+ *
+ * The address must lie below the limit of the valid part of the
+ * segment's object-start table.
+ */
+
+static Addr amcSegStartsFind(Seg seg, Addr addr)
+{
+  amcSeg amcseg = MustBeA_CRITICAL(amcSeg, seg);
+  Index i;
+  Bool found;
+
+  AVER_CRITICAL(amcseg->starts != NULL);
+  AVER_CRITICAL(SegBase(seg) <= addr);
+  AVER_CRITICAL(addr < amcseg->startsLimit);
+  found = BTFindLastSet(&i, amcseg->starts, 0,
+                        amcSegStartsIndex(seg, addr) + 1);
+  AVER_CRITICAL(found); /* there's always an object at the base */
+  return AddrAdd(SegBase(seg), i << SegPool(seg)->alignShift);
+}
+
+
+/* amcSegStartsReset -- forget the object starts in a segment
+ *
+ * Call this when objects in the segment have been replaced by
+ * padding, so that the table no longer describes them.
+ */
+
+static void amcSegStartsReset(Seg seg)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  if (amcseg->starts != NULL) {
+    BTResRange(amcseg->starts, 0, amcSegStartsIndex(seg, SegLimit(seg)));
+    amcseg->startsLimit = SegBase(seg);
+  }
+}
+
+
+/* amcSegStartsAppend -- record an object appended to a segment
+ *
+ * If the object-start table is valid up to the object, extend it to
+ * cover the object. This keeps the tables of to-segments up to date
+ * while objects are forwarded into them.
+ */
+
+static void amcSegStartsAppend(Seg seg, Addr base, Addr limit)
+{
+  amcSeg amcseg = MustBeA_CRITICAL(amcSeg, seg);
+  if (amcseg->starts != NULL && amcseg->startsLimit == base) {
+    BTSet(amcseg->starts, amcSegStartsIndex(seg, base));
+    amcseg->startsLimit = limit;
+  }
+}
+
+
 /* amcSegCreateNailboard -- create nailboard for segment */
 
 static Res amcSegCreateNailboard(Seg seg)
@@ -693,6 +859,48 @@ static Bool amcPinnedBase(AMC amc, Nailboard board, Addr base, Addr limit)
 }
 
 
+/* amcSegAmbigPin -- decide what an ambiguous reference pins
+ *
+ * Return FALSE if the ambiguous reference ref to an address in the
+ * segment can't keep any object alive. Otherwise, update *pinReturn
+ * to the address that should be nailed: the client pointer of the
+ * object that ref pins, if the segment's object-start table covers
+ * ref, or ref itself if not. <design/poolamc#.starts.nail>.
+ */
+
+static Bool amcSegAmbigPin(Ref *pinReturn, Seg seg, Ref ref)
+{
+  Pool pool = SegPool(seg);
+  AMC amc = MustBeA_CRITICAL(AMCZPool, pool);
+  Arena arena = PoolArena(pool);
+  Format format = pool->format;
+  Addr limit, base, clientP;
+
+  *pinReturn = ref;
+  if (!amc->objectStarts)
+    return TRUE;
+  limit = SegBufferScanLimit(seg);
+  if (ref >= limit)
+    return TRUE;
+
+  ShieldExpose(arena, seg);
+  if (!amcSegStartsUpdate(seg, limit)) {
+    ShieldCover(arena, seg);
+    return TRUE;
+  }
+  base = amcSegStartsFind(seg, ref);
+  ShieldCover(arena, seg);
+  clientP = AddrAdd(base, format->headerSize);
+
+  if (amc->pinned == amcPinnedBase
+      && AddrAlignDown(ref, PoolAlignment(pool))
+         != AddrAlignDown(clientP, PoolAlignment(pool)))
+    return FALSE;
+  *pinReturn = clientP;
+  return TRUE;
+}
+
+
 /* amcVarargs -- decode obsolete varargs */
 
 static void AMCVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
@@ -706,6 +914,11 @@ static void AMCVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
 }
 
 
+ARG_DEFINE_KEY(AMC_PROMOTE_SURVIVAL, double);
+ARG_DEFINE_KEY(AMC_OBJECT_STARTS, Bool);
+ARG_DEFINE_KEY(AMC_AUTO_RAMP, Bool);
+
+
 /* amcInitComm -- initialize AMC/Z pool
  *
  * <design/poolamc#.init>.
@@ -723,6 +936,9 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   Chain chain;
   Size extendBy = AMC_EXTEND_BY_DEFAULT;
   Size largeSize = AMC_LARGE_SIZE_DEFAULT;
+  double promoteSurvival = AMC_PROMOTE_SURVIVAL_DEFAULT;
+  Bool objectStarts = AMC_OBJECT_STARTS_DEFAULT;
+  Bool autoRamp = AMC_AUTO_RAMP_DEFAULT;
   ArgStruct arg;
 
   AVER(pool != NULL);
@@ -741,6 +957,12 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
     extendBy = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_LARGE_SIZE))
     largeSize = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_PROMOTE_SURVIVAL))
+    promoteSurvival = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_OBJECT_STARTS))
+    objectStarts = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_AUTO_RAMP))
+    autoRamp = arg.val.b;
 
   AVERT(Chain, chain);
   AVER(chain->arena == arena);
@@ -751,6 +973,10 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
    * unacceptable fragmentation due to the padding objects. This
    * assertion catches this bad case. */
   AVER(largeSize >= extendBy);
+  AVER(promoteSurvival >= 0.0);
+  AVER(promoteSurvival <= 1.0);
+  AVERT(Bool, objectStarts);
+  AVERT(Bool, autoRamp);
 
   res = NextMethod(Pool, AMCZPool, init)(pool, arena, klass, args);
   if (res != ResOK)
@@ -775,6 +1001,13 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
 
   amc->rampCount = 0;
   amc->rampMode = RampOUTSIDE;
+  amc->autoRamp = autoRamp;
+  amc->autoRamping = FALSE;
+  amc->autoRampVotes = 0;
+  amc->autoRampEpoch = ArenaEpoch(arena);
+  amc->autoRampClock = ClockNow();
+  amc->autoRampFilled = 0.0;
+  amc->autoRampRate = 0.0;
 
   if (interior) {
     amc->pinned = amcPinnedInterior;
@@ -784,6 +1017,8 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   /* .extend-by.aligned: extendBy is aligned to the arena alignment. */
   amc->extendBy = SizeArenaGrains(extendBy, arena);
   amc->largeSize = largeSize;
+  amc->promoteSurvival = promoteSurvival;
+  amc->objectStarts = objectStarts;
 
   SetClassOfPoly(pool, klass);
   amc->sig = AMCSig;
@@ -945,6 +1180,8 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   }
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, amcKeySegGen, p, gen);
+    /* <design/buffer#.zeroed> */
+    MPS_ARGS_ADD(args, PoolGenZeroed, BufferIsZeroed(buffer));
     res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize, args);
   } MPS_ARGS_END(args);
   if(res != ResOK)
@@ -979,6 +1216,7 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
 
     limit = AddrAdd(base, size);
     AVER(limit <= SegLimit(seg));
+    MustBeA(amcSeg, seg)->large = TRUE;
 
     padSize = grainsSize - size;
     AVER(SizeIsAligned(padSize, PoolAlignment(pool)));
@@ -992,6 +1230,8 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
 
   PoolGenAccountForFill(pgen, SegSize(seg));
   MustBeA(amcSeg, seg)->accountedAsBuffered = TRUE;
+  if (BufferIsMutator(buffer))
+    amc->autoRampFilled += (double)AddrOffset(base, limit);
 
   *baseReturn = base;
   *limitReturn = limit;
@@ -1008,7 +1248,6 @@ static void amcSegBufferEmpty(Seg seg, Buffer buffer)
   amcSeg amcseg = MustBeA(amcSeg, seg);
   Pool pool = SegPool(seg);
   Arena arena = PoolArena(pool);
-  AMC amc = MustBeA(AMCZPool, pool);
   Addr base, init, limit;
   TraceId ti;
   Trace trace;
@@ -1021,7 +1260,7 @@ static void amcSegBufferEmpty(Seg seg, Buffer buffer)
   AVER(SegBase(seg) <= base);
   AVER(base <= init);
   AVER(init <= limit);
-  if(SegSize(seg) < amc->largeSize) {
+  if (!amcseg->large) {
     /* Small or Medium segment: buffer had the entire seg. */
     AVER(limit == SegLimit(seg));
   } else {
@@ -1053,16 +1292,10 @@ static void amcSegBufferEmpty(Seg seg, Buffer buffer)
 }
 
 
-/* AMCRampBegin -- note an entry into a ramp pattern */
+/* amcRampEnter -- count an entry into a ramp pattern */
 
-static void AMCRampBegin(Pool pool, Buffer buf, Bool collectAll)
+static void amcRampEnter(AMC amc)
 {
-  AMC amc = MustBeA(AMCZPool, pool);
-
-  AVERT(Buffer, buf);
-  AVERT(Bool, collectAll);
-  UNUSED(collectAll); /* obsolete */
-
   AVER(amc->rampCount < UINT_MAX);
   ++amc->rampCount;
   if(amc->rampCount == 1) {
@@ -1072,13 +1305,11 @@ static void AMCRampBegin(Pool pool, Buffer buf, Bool collectAll)
 }
 
 
-/* AMCRampEnd -- note an exit from a ramp pattern */
+/* amcRampLeave -- count an exit from a ramp pattern */
 
-static void AMCRampEnd(Pool pool, Buffer buf)
+static void amcRampLeave(AMC amc)
 {
-  AMC amc = MustBeA(AMCZPool, pool);
-
-  AVERT(Buffer, buf);
+  Pool pool = MustBeA(AbstractPool, amc);
 
   AVER(amc->rampCount > 0);
   --amc->rampCount;
@@ -1127,6 +1358,101 @@ static void AMCRampEnd(Pool pool, Buffer buf)
 }
 
 
+/* AMCRampBegin -- note an entry into a ramp pattern
+ *
+ * The client's ramp takes over from an automatically detected one.
+ * <design/poolamc#.ramp.auto.manual>.
+ */
+
+static void AMCRampBegin(Pool pool, Buffer buf, Bool collectAll)
+{
+  AMC amc = MustBeA(AMCZPool, pool);
+
+  AVERT(Buffer, buf);
+  AVERT(Bool, collectAll);
+  UNUSED(collectAll); /* obsolete */
+
+  if (amc->autoRamping) {
+    amc->autoRamping = FALSE;
+    return;
+  }
+  amcRampEnter(amc);
+}
+
+
+/* AMCRampEnd -- note an exit from a ramp pattern */
+
+static void AMCRampEnd(Pool pool, Buffer buf)
+{
+  AMC amc = MustBeA(AMCZPool, pool);
+
+  AVERT(Buffer, buf);
+  AVER(!amc->autoRamping);
+
+  amcRampLeave(amc);
+}
+
+
+/* amcAutoRamp -- detect the start and end of ramps
+ *
+ * Called when a trace condemns the nursery generation, once per
+ * trace. Takes one sample of the nursery's survival estimate and the
+ * rate at which mutator buffers have been filled since the previous
+ * sample, and enters or leaves a ramp when enough consecutive samples
+ * agree. <design/poolamc#.ramp.auto>.
+ */
+
+static void amcAutoRamp(AMC amc)
+{
+  Pool pool = MustBeA(AbstractPool, amc);
+  Arena arena = PoolArena(pool);
+  Clock now = ClockNow();
+  double survival = amc->nursery->survival;
+  double rate, interval;
+  Bool busy, change;
+
+  AVER(amc->autoRamp);
+  if (amc->autoRampEpoch == ArenaEpoch(arena))
+    return;
+  amc->autoRampEpoch = ArenaEpoch(arena);
+
+  interval = (double)(now - amc->autoRampClock) / (double)ClocksPerSec();
+  if (interval <= 0.0)
+    return;
+  rate = amc->autoRampFilled / interval;
+  busy = rate >= amc->autoRampRate * AMC_AUTO_RAMP_RATE;
+  amc->autoRampRate += (rate - amc->autoRampRate) * AMC_AUTO_RAMP_ALPHA;
+  amc->autoRampClock = now;
+  amc->autoRampFilled = 0.0;
+
+  /* The client's own ramps take precedence. */
+  if (amc->rampCount > 0 && !amc->autoRamping) {
+    amc->autoRampVotes = 0;
+    return;
+  }
+
+  if (amc->autoRamping)
+    change = !busy || survival <= AMC_AUTO_RAMP_LEAVE;
+  else
+    change = busy && survival >= AMC_AUTO_RAMP_ENTER;
+  if (!change) {
+    amc->autoRampVotes = 0;
+    return;
+  }
+  ++amc->autoRampVotes;
+  if (amc->autoRampVotes < AMC_AUTO_RAMP_SAMPLES)
+    return;
+
+  amc->autoRampVotes = 0;
+  amc->autoRamping = !amc->autoRamping;
+  if (amc->autoRamping)
+    amcRampEnter(amc);
+  else
+    amcRampLeave(amc);
+  EVENT4(AMCRamp, pool, BOOLOF(amc->autoRamping), survival, rate);
+}
+
+
 /* amcSegPoolGen -- get pool generation for a segment */
 
 static PoolGen amcSegPoolGen(Pool pool, Seg seg)
@@ -1138,11 +1464,84 @@ static PoolGen amcSegPoolGen(Pool pool, Seg seg)
 }
 
 
+/* amcGenNoteSurvival -- update the survival estimate for a generation
+ *
+ * <design/poolamc#.promote.survival>
+ */
+
+static void amcGenNoteSurvival(amcGen gen, Seg seg, Size survived)
+{
+  double ratio;
+
+  AVERT(amcGen, gen);
+  AVERT(Seg, seg);
+
+  ratio = (double)survived / (double)SegSize(seg);
+  if (ratio > 1.0)
+    ratio = 1.0;
+  gen->survival += (ratio - gen->survival) * AMC_SURVIVAL_ALPHA;
+}
+
+
+/* amcSegPromote -- promote a segment in place instead of condemning it
+ *
+ * Returns TRUE if the segment was moved to the generation that its
+ * generation forwards to, in which case it must not be condemned.
+ * <design/poolamc#.promote>
+ */
+
+static Bool amcSegPromote(Seg seg, Trace trace)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  AMC amc = MustBeA(AMCZPool, SegPool(seg));
+  amcGen gen, toGen;
+  Size oldSize, newSize;
+
+  gen = amcSegGen(seg);
+  AVERT(amcGen, gen);
+
+  if (gen->survival <= amc->promoteSurvival)
+    return FALSE;
+  /* Buffered, deferred, and nailed segments have accounting or
+   * pinning that would need to follow them; just condemn them. */
+  if (SegHasBuffer(seg) || amcseg->accountedAsBuffered || amcseg->deferred
+      || SegNailed(seg) != TraceSetEMPTY || SegWhite(seg) != TraceSetEMPTY)
+    return FALSE;
+  /* Ramps redirect the forwarding buffers, so leave them alone. */
+  if (amc->rampMode != RampOUTSIDE)
+    return FALSE;
+  toGen = amcBufGen(gen->forward);
+  if (toGen == NULL || toGen == gen
+      || TraceSetIsMember(toGen->pgen.gen->activeTraces, trace))
+    return FALSE;
+  /* <design/poolamc#.promote.sample> */
+  ++gen->promoteTick;
+  if (gen->promoteTick % AMC_PROMOTE_SAMPLE == 0)
+    return FALSE;
+
+  if (amcseg->old) {
+    oldSize = SegSize(seg);
+    newSize = 0;
+  } else {
+    oldSize = 0;
+    newSize = SegSize(seg);
+  }
+  PoolGenTransfer(&toGen->pgen, &gen->pgen, seg, 0, oldSize, newSize);
+  amcseg->gen = toGen;
+  amcseg->old = FALSE;
+  ++gen->promoted;
+  /* <design/poolamc#.promote.mortality> */
+  GenDescPromoted(gen->pgen.gen, trace, SegSize(seg));
+  return TRUE;
+}
+
+
 /* amcSegWhiten -- condemn the segment for the trace
  *
  * If the segment has a mutator buffer on it, we nail the buffer,
  * because we can't scan or reclaim uncommitted buffers.
  */
+
 static Res amcSegWhiten(Seg seg, Trace trace)
 {
   Size condemned = 0;
@@ -1155,6 +1554,9 @@ static Res amcSegWhiten(Seg seg, Trace trace)
 
   AVERT(Trace, trace);
 
+  if (amcSegPromote(seg, trace))
+    return ResOK;
+
   if (SegBuffer(&buffer, seg)) {
     AVERT(Buffer, buffer);
 
@@ -1237,6 +1639,9 @@ static Res amcSegWhiten(Seg seg, Trace trace)
 
   /* Ensure we are forwarding into the right generation. */
 
+  if (amc->autoRamp && gen == amc->nursery)
+    amcAutoRamp(amc);
+
   /* see <design/poolamc#.gen.ramp> */
   /* This switching needs to be more complex for multiple traces. */
   AVER(TraceSetIsSingle(PoolArena(pool)->busyTraces));
@@ -1261,8 +1666,8 @@ static Res amcSegWhiten(Seg seg, Trace trace)
  * limit have been scanned.  It is not touched otherwise.
  */
 static Res amcSegScanNailedRange(Bool *totalReturn, Bool *moreReturn,
-                                 ScanState ss, AMC amc, Nailboard board,
-                                 Addr base, Addr limit)
+                                 ScanState ss, AMC amc, Seg seg,
+                                 Nailboard board, Addr base, Addr limit)
 {
   Format format;
   Size headerSize;
@@ -1270,6 +1675,35 @@ static Res amcSegScanNailedRange(Bool *totalReturn, Bool *moreReturn,
   Pool pool = MustBeA(AbstractPool, amc);
   format = pool->format;
   headerSize = format->headerSize;
+
+  /* <design/poolamc#.starts.scan> */
+  if (amcSegStartsUpdate(seg, limit)) {
+    Addr nail;
+    p = base;
+    while (p < limit && NailboardFindNail(&nail, board, p, limit)) {
+      Addr objBase = amcSegStartsFind(seg, nail);
+      Addr clientP = AddrAdd(objBase, headerSize);
+      Addr clientQ = (*format->skip)(clientP);
+      AVER(p <= objBase);
+      if (p < objBase)
+        *totalReturn = FALSE;   /* skipped some unnailed objects */
+      if ((*amc->pinned)(amc, board, clientP, clientQ)) {
+        Res res = TraceScanFormat(ss, clientP, clientQ);
+        if(res != ResOK) {
+          *totalReturn = FALSE;
+          *moreReturn = TRUE;
+          return res;
+        }
+      } else {
+        *totalReturn = FALSE;
+      }
+      p = AddrSub(clientQ, headerSize);
+    }
+    if (p < limit)
+      *totalReturn = FALSE;
+    return ResOK;
+  }
+
   p = AddrAdd(base, headerSize);
   clientLimit = AddrAdd(limit, headerSize);
   while (p < clientLimit) {
@@ -1322,7 +1756,7 @@ static Res amcSegScanNailedOnce(Bool *totalReturn, Bool *moreReturn,
       goto returnGood;
     }
     res = amcSegScanNailedRange(totalReturn, moreReturn,
-                                ss, amc, board, p, limit);
+                                ss, amc, seg, board, p, limit);
     if (res != ResOK)
       return res;
     p = limit;
@@ -1331,7 +1765,7 @@ static Res amcSegScanNailedOnce(Bool *totalReturn, Bool *moreReturn,
   limit = SegLimit(seg);
   /* @@@@ Shouldn't p be set to BufferLimit here?! */
   res = amcSegScanNailedRange(totalReturn, moreReturn,
-                              ss, amc, board, p, limit);
+                              ss, amc, seg, board, p, limit);
   if (res != ResOK)
     return res;
 
@@ -1558,6 +1992,9 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
   /* managing a nailed segment.  This involves marking the segment */
   /* as nailed, and setting up a per-word mark table */
   if(ss->rank == RankAMBIG) {
+    Ref pin;
+    if (!amcSegAmbigPin(&pin, seg, *refIO))
+      return ResOK;
     /* .nail.new: Check to see whether we need a Nailboard for */
     /* this seg.  We use "SegNailed(seg) == TraceSetEMPTY" */
     /* rather than "!amcSegHasNailboard(seg)" because this avoids */
@@ -1573,7 +2010,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
       STATISTIC(++ss->nailCount);
       SegSetNailed(seg, TraceSetUnion(SegNailed(seg), ss->traces));
     }
-    amcSegFixInPlace(seg, ss, refIO);
+    amcSegFixInPlace(seg, ss, &pin);
     return ResOK;
   }
 
@@ -1622,6 +2059,20 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
 
     ss->wasMarked = FALSE; /* <design/fix#.was-marked.not> */
 
+    /* A large segment holds just one object, followed by padding, so
+     * rather than copying the object, nail the whole segment and move
+     * it to the next generation when it is reclaimed.
+     * <design/poolamc#.large.promote> */
+    if (MustBeA_CRITICAL(amcSeg, seg)->large && base == SegBase(seg)
+        && SegNailed(seg) == TraceSetEMPTY && !SegHasBuffer(seg)) {
+      MustBeA_CRITICAL(amcSeg, seg)->promote = TRUE;
+      SegSetNailed(seg, ss->traces);
+      if(SegRankSet(seg) != RankSetEMPTY) /* not for AMCZ */
+        SegSetGrey(seg, TraceSetUnion(SegGrey(seg), ss->traces));
+      res = ResOK;
+      goto returnRes;
+    }
+
     /* Get the forwarding buffer from the object's generation. */
     gen = amcSegGen(seg);
     buffer = gen->forward;
@@ -1654,6 +2105,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
 
       ShieldCover(arena, toSeg);
     } while (!BUFFER_COMMIT(buffer, newBase, length));
+    amcSegStartsAppend(toSeg, newBase, AddrAdd(newBase, length));
 
     STATISTIC(ss->copiedSize += length);
     TRACE_SET_ITER(ti, trace, ss->traces, ss->arena)
@@ -1679,6 +2131,36 @@ returnRes:
 }
 
 
+/* amcSegPromoteLarge -- move a preserved large segment to the next generation
+ *
+ * <design/poolamc#.large.promote>
+ */
+
+static void amcSegPromoteLarge(Seg seg)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  amcGen gen, toGen;
+
+  AVER(amcseg->promote);
+  if (SegNailed(seg) != TraceSetEMPTY)
+    return;   /* still nailed for another trace */
+  amcseg->promote = FALSE;
+
+  gen = amcSegGen(seg);
+  AVERT(amcGen, gen);
+  toGen = amcBufGen(gen->forward);
+  if (toGen == NULL || toGen == gen || amcseg->deferred || SegHasBuffer(seg))
+    return;
+
+  /* A condemned segment is accounted as old in its entirety. */
+  AVER(amcseg->old);
+  PoolGenTransfer(&toGen->pgen, &gen->pgen, seg, 0, SegSize(seg), 0);
+  amcseg->gen = toGen;
+  amcseg->old = FALSE;
+  ++gen->promoted;
+}
+
+
 /* amcSegReclaimNailed -- reclaim what you can from a nailed segment */
 
 static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
@@ -1753,6 +2235,7 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     STATISTIC(bytesReclaimed += padLength);
   }
   ShieldCover(arena, seg);
+  amcSegStartsReset(seg);
 
   SegSetNailed(seg, TraceSetDel(SegNailed(seg), trace));
   SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
@@ -1773,6 +2256,9 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
   }
   GenDescSurvived(pgen->gen, trace, MustBeA(amcSeg, seg)->forwarded[trace->ti],
                   preservedInPlaceSize);
+  amcGenNoteSurvival(amcSegGen(seg), seg,
+                     MustBeA(amcSeg, seg)->forwarded[trace->ti]
+                     + preservedInPlaceSize);
 
   /* Free the seg if we can; fixes .nailboard.limitations.middle. */
   if(preservedInPlaceCount == 0
@@ -1783,6 +2269,8 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     AVER(!SegHasBuffer(seg));
 
     PoolGenFree(pgen, seg, 0, SegSize(seg), 0, MustBeA(amcSeg, seg)->deferred);
+  } else if (MustBeA(amcSeg, seg)->promote) {
+    amcSegPromoteLarge(seg);
   }
 }
 
@@ -1825,6 +2313,7 @@ static void amcSegReclaim(Seg seg, Trace trace)
   STATISTIC(trace->reclaimSize += SegSize(seg));
 
   GenDescSurvived(gen->pgen.gen, trace, amcseg->forwarded[trace->ti], 0);
+  amcGenNoteSurvival(gen, seg, amcseg->forwarded[trace->ti]);
   PoolGenFree(&gen->pgen, seg, 0, SegSize(seg), 0, amcseg->deferred);
 }
 
@@ -1971,7 +2460,20 @@ static Res AMCAddrObject(Addr *pReturn, Pool pool, Addr addr)
     limit = SegLimit(seg);
 
   ShieldExpose(arena, seg);
-  res = amcAddrObjectSearch(pReturn, pool, base, limit, addr);
+  if (amcSegStartsUpdate(seg, limit)
+      && addr < MustBeA(amcSeg, seg)->startsLimit) {
+    /* <design/poolamc#.starts.addr-object> */
+    Addr objRef = AddrAdd(amcSegStartsFind(seg, addr),
+                          pool->format->headerSize);
+    if (NULL == (*pool->format->isMoved)(objRef)) {
+      *pReturn = objRef;
+      res = ResOK;
+    } else {
+      res = ResFAIL;
+    }
+  } else {
+    res = amcAddrObjectSearch(pReturn, pool, base, limit, addr);
+  }
   ShieldCover(arena, seg);
   return res;
 }
@@ -2048,6 +2550,11 @@ static Res AMCDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   }
   res = WriteF(stream, depth + 2,
                rampmode, " ($U)\n", (WriteFU)amc->rampCount,
+               "promoteSurvival $D\n", (WriteFD)amc->promoteSurvival,
+               "objectStarts $S\n", WriteFYesNo(amc->objectStarts),
+               "autoRamp $S\n", WriteFYesNo(amc->autoRamp),
+               "autoRamping $S\n", WriteFYesNo(amc->autoRamping),
+               "autoRampRate $D\n", (WriteFD)amc->autoRampRate,
                NULL);
   if(res != ResOK)
     return res;
@@ -2081,7 +2588,7 @@ DEFINE_CLASS(Pool, AMCZPool, klass)
   klass->instClassStruct.describe = AMCDescribe;
   klass->instClassStruct.finish = AMCFinish;
   klass->size = sizeof(AMCStruct);
-  klass->attr |= AttrMOVINGGC;
+  klass->attr |= AttrMOVINGGC | AttrZEROFILL;
   klass->varargs = AMCVarargs;
   klass->init = AMCZInit;
   klass->bufferFill = AMCBufferFill;
@@ -2193,6 +2700,17 @@ static Bool AMCCheck(AMC amc)
     CHECKD(amcGen, amc->afterRampGen);
   }
 
+  CHECKL(BoolCheck(amc->objectStarts));
+  CHECKL(BoolCheck(amc->autoRamp));
+  CHECKL(BoolCheck(amc->autoRamping));
+  CHECKL(amc->autoRamp || !amc->autoRamping);
+  /* an automatic ramp holds one count. */
+  CHECKL(!amc->autoRamping || amc->rampCount == 1);
+  CHECKL(amc->autoRampFilled >= 0.0);
+  CHECKL(amc->autoRampRate >= 0.0);
+  CHECKL(amc->promoteSurvival >= 0.0);
+  CHECKL(amc->promoteSurvival <= 1.0);
+
   CHECKL(amc->rampMode >= RampOUTSIDE);
   CHECKL(amc->rampMode <= RampCOLLECTING);
 
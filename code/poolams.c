@@ -156,6 +156,27 @@ void AMSSegFreeCheck(AMSSeg amsseg)
 }
 
 
+/* amsObjectNext -- find the address of the block following an object
+ *
+ * p is the address of an allocated object in the pool, including any
+ * header.  If the pool has a fixed object size, every object occupies
+ * one slot of that size, so there is no need to call the format's
+ * skip method <design/poolams#.size.skip>.  The caller is responsible
+ * for exposing the segment if the skip method might be called.
+ */
+
+static Addr amsObjectNext(AMS ams, Format format, Addr p)
+{
+  if (ams->objectSize != 0)
+    return AddrAdd(p, ams->objectSize);
+  if (format->skip != NULL) {
+    Addr next = (*format->skip)(AddrAdd(p, format->headerSize));
+    return AddrSub(next, format->headerSize);
+  }
+  return AddrAdd(p, PoolAlignment(AMSPool(ams)));
+}
+
+
 /* amsCreateTables -- create the tables for an AMS seg */
 
 static Res amsCreateTables(AMS ams, BT *allocReturn,
@@ -775,12 +796,14 @@ static void AMSDebugVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
  */
 
 ARG_DEFINE_KEY(AMS_SUPPORT_AMBIGUOUS, Bool);
+ARG_DEFINE_KEY(AMS_OBJECT_SIZE, Size);
 
 static Res AMSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
   Res res;
   Chain chain;
   Bool supportAmbiguous = AMS_SUPPORT_AMBIGUOUS_DEFAULT;
+  Size objectSize = AMS_OBJECT_SIZE_DEFAULT;
   unsigned gen = AMS_GEN_DEFAULT;
   ArgStruct arg;
   AMS ams;
@@ -800,11 +823,17 @@ static Res AMSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
     gen = arg.val.u;
   if (ArgPick(&arg, args, MPS_KEY_AMS_SUPPORT_AMBIGUOUS))
     supportAmbiguous = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_AMS_OBJECT_SIZE))
+    objectSize = arg.val.size;
 
   AVERT(Chain, chain);
   AVER(gen <= ChainGens(chain));
   AVER(chain->arena == arena);
 
+  /* <design/poolams#.size.debug> */
+  if (objectSize != 0 && IsSubclass(klass, AMSDebugPool))
+    return ResPARAM;
+
   res = NextMethod(Pool, AMSPool, init)(pool, arena, klass, args);
   if (res != ResOK)
     goto failNextInit;
@@ -817,7 +846,15 @@ static Res AMSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   /* .ambiguous.noshare: If the pool is required to support ambiguous */
   /* references, the alloc and white tables cannot be shared. */
   ams->shareAllocTable = !supportAmbiguous;
+  /* <design/poolams#.size> */
+  if (!SizeIsAligned(objectSize, pool->alignment)) {
+    res = ResPARAM;
+    goto failObjectSize;
+  }
+  ams->objectSize = objectSize;
   ams->pgen = NULL;
+  STATISTIC(ams->segFreesAvoided = 0);
+  STATISTIC(ams->emptySegFills = 0);
 
   /* The next four might be overridden by a subclass. */
   ams->segSize = AMSSegSizePolicy;
@@ -838,6 +875,7 @@ static Res AMSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   return ResOK;
 
 failGenInit:
+failObjectSize:
   NextMethod(Inst, AMSPool, finish)(MustBeA(Inst, pool));
 failNextInit:
   AVER(res != ResOK);
@@ -976,9 +1014,15 @@ static Res AMSBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* <design/poolams#.fill.slow> */
   rankSet = BufferRankSet(buffer);
   RING_FOR(node, &pool->segRing, nextNode) {
+    STATISTIC_DECL(Bool empty)
     seg = SegOfPoolRing(node);
-    if (SegBufferFill(baseReturn, limitReturn, seg, size, rankSet))
+    STATISTIC(empty = (Seg2AMSSeg(seg)->freeGrains
+                       == Seg2AMSSeg(seg)->grains));
+    if (SegBufferFill(baseReturn, limitReturn, seg, size, rankSet)) {
+      /* <design/poolams#.reclaim.cache> */
+      STATISTIC(if (empty) ++PoolAMS(pool)->emptySegFills);
       return ResOK;
+    }
   }
 
   /* No segment had enough space, so make a new one. */
@@ -1014,6 +1058,9 @@ static void amsSegBufferEmpty(Seg seg, Buffer buffer)
   AVER(bufferBase <= init);
   AVER(init <= limit);
   AVER(limit <= SegLimit(seg));
+  /* <design/poolams#.size.slot> */
+  AVER(PoolAMS(pool)->objectSize == 0
+       || AddrOffset(bufferBase, init) % PoolAMS(pool)->objectSize == 0);
 
   initIndex = PoolIndexOfAddr(segBase, pool, init);
   limitIndex = PoolIndexOfAddr(segBase, pool, limit);
@@ -1199,6 +1246,7 @@ static Res semSegIterate(Seg seg, AMSObjectFunction f, void *closure)
   Res res;
   Pool pool;
   AMSSeg amsseg;
+  AMS ams;
   Format format;
   Align alignment;
   Index i;
@@ -1214,13 +1262,14 @@ static Res semSegIterate(Seg seg, AMSObjectFunction f, void *closure)
   AVERT(AMSSeg, amsseg);
   pool = SegPool(seg);
   AVERT(Pool, pool);
+  ams = amsseg->ams;
   format = pool->format;
   AVERT(Format, format);
   alignment = PoolAlignment(pool);
 
   /* If we're using the alloc table as a white table, we can't use it to */
   /* determine where there are objects. */
-  AVER(!amsseg->ams->shareAllocTable || !amsseg->colourTablesInUse);
+  AVER(!ams->shareAllocTable || !amsseg->colourTablesInUse);
 
   p = SegBase(seg);
   limit = SegLimit(seg);
@@ -1253,12 +1302,7 @@ static Res semSegIterate(Seg seg, AMSObjectFunction f, void *closure)
           next = limit;
         }
       } else { /* there is an object here */
-        if (format->skip != NULL) {
-            next = (*format->skip)(AddrAdd(p, format->headerSize));
-            next = AddrSub(next, format->headerSize);
-        } else {
-          next = AddrAdd(p, alignment);
-        }
+        next = amsObjectNext(ams, format, p);
         AVER(AddrIsAligned(next, alignment));
         res = (*f)(seg, i, p, next, closure);
         if (res != ResOK)
@@ -1337,7 +1381,6 @@ static Res amsSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   Arena arena = PoolArena(pool);
   struct amsScanClosureStruct closureStruct;
   Format format;
-  Align alignment;
 
   AVER(totalReturn != NULL);
   AVERT(ScanState, ss);
@@ -1363,7 +1406,6 @@ static Res amsSegScan(Bool *totalReturn, Seg seg, ScanState ss)
     AVER(amsseg->colourTablesInUse);
     format = pool->format;
     AVERT(Format, format);
-    alignment = PoolAlignment(AMSPool(ams));
     do { /* <design/poolams#.scan.iter> */
       amsseg->marksChanged = FALSE; /* <design/poolams#.marked.scan> */
       /* <design/poolams#.ambiguous.middle> */
@@ -1385,13 +1427,8 @@ static Res amsSegScan(Bool *totalReturn, Seg seg, ScanState ss)
           AVER(!AMS_IS_INVALID_COLOUR(seg, i));
           p = PoolAddrOfIndex(SegBase(seg), pool, i);
           clientP = AddrAdd(p, format->headerSize);
-          if (format->skip != NULL) {
-            clientNext = (*format->skip)(clientP);
-            next = AddrSub(clientNext, format->headerSize);
-          } else {
-            clientNext = AddrAdd(clientP, alignment);
-            next = AddrAdd(p, alignment);
-          }
+          next = amsObjectNext(ams, format, p);
+          clientNext = AddrAdd(next, format->headerSize);
           j = PoolIndexOfAddr(SegBase(seg), pool, next);
           res = TraceScanFormat(ss, clientP, clientNext);
           if (res != ResOK) {
@@ -1422,6 +1459,7 @@ static Res amsSegFix(Seg seg, ScanState ss, Ref *refIO)
 {
   AMSSeg amsseg = MustBeA_CRITICAL(AMSSeg, seg);
   Pool pool = SegPool(seg);
+  AMS ams = PoolAMS(pool);
   Index i;                      /* the index of the fixed grain */
   Addr base;
   Ref clientRef;
@@ -1461,6 +1499,14 @@ static Res amsSegFix(Seg seg, ScanState ss, Ref *refIO)
     return ResOK;
   }
 
+  /* Not a real reference if not at the start of a slot, when the pool
+     has a fixed object size <design/poolams#.size.slot>. */
+  if (ams->objectSize != 0
+      && AddrOffset(SegBase(seg), base) % ams->objectSize != 0) {
+    AVER(ss->rank == RankAMBIG);
+    return ResOK;
+  }
+
   i = PoolIndexOfAddr(SegBase(seg), pool, base);
   AVER_CRITICAL(i < amsseg->grains);
   AVER_CRITICAL(!AMS_IS_INVALID_COLOUR(seg, i));
@@ -1473,7 +1519,7 @@ static Res amsSegFix(Seg seg, ScanState ss, Ref *refIO)
 
   switch (ss->rank) {
   case RankAMBIG:
-    if (PoolAMS(pool)->shareAllocTable)
+    if (ams->shareAllocTable)
       /* In this state, the pool doesn't support ambiguous references (see */
       /* .ambiguous.noshare), so this is not a reference. */
       break;
@@ -1490,12 +1536,15 @@ static Res amsSegFix(Seg seg, ScanState ss, Ref *refIO)
         STATISTIC(++ss->preservedInPlaceCount); /* Size updated on reclaim */
         if (SegRankSet(seg) == RankSetEMPTY && ss->rank != RankAMBIG) {
           /* <design/poolams#.fix.to-black> */
-          Addr clientNext, next;
+          Addr next;
 
-          ShieldExpose(PoolArena(pool), seg);
-          clientNext = (*pool->format->skip)(clientRef);
-          ShieldCover(PoolArena(pool), seg);
-          next = AddrSub(clientNext, format->headerSize);
+          if (ams->objectSize != 0) {
+            next = AddrAdd(base, ams->objectSize);
+          } else {
+            ShieldExpose(PoolArena(pool), seg);
+            next = amsObjectNext(ams, format, base);
+            ShieldCover(PoolArena(pool), seg);
+          }
           /* Part of the object might be grey, because of ambiguous */
           /* fixes, but that's OK, because scan will ignore that. */
           AMS_RANGE_WHITE_BLACKEN(seg, i, PoolIndexOfAddr(SegBase(seg), pool, next));
@@ -1620,11 +1669,17 @@ static void amsSegReclaim(Seg seg, Trace trace)
   if (amsseg->freeGrains == grains && !SegHasBuffer(seg)) {
     /* No survivors */
     AVER(amsseg->bufferedGrains == 0);
-    PoolGenFree(pgen, seg,
-                PoolGrainsSize(pool, amsseg->freeGrains),
-                PoolGrainsSize(pool, amsseg->oldGrains),
-                PoolGrainsSize(pool, amsseg->newGrains),
-                FALSE);
+    /* Keep it for the next buffer fill if the pool is short of free
+       space. <design/poolams#.reclaim.cache> */
+    if (pgen->freeSize <= AMS_SEG_CACHE_SIZE) {
+      STATISTIC(++amsseg->ams->segFreesAvoided);
+    } else {
+      PoolGenFree(pgen, seg,
+                  PoolGrainsSize(pool, amsseg->freeGrains),
+                  PoolGrainsSize(pool, amsseg->oldGrains),
+                  PoolGrainsSize(pool, amsseg->newGrains),
+                  FALSE);
+    }
   }
 }
 
@@ -1636,6 +1691,7 @@ static void amsSegWalk(Seg seg, Format format, FormattedObjectsVisitor f,
 {
   AMSSeg amsseg = MustBeA(AMSSeg, seg);
   Pool pool = SegPool(seg);
+  AMS ams = PoolAMS(pool);
   Addr object, base, limit;
 
   AVERT(Format, format);
@@ -1669,12 +1725,10 @@ static void amsSegWalk(Seg seg, Format format, FormattedObjectsVisitor f,
       object = AddrAdd(object, PoolAlignment(pool));
       continue;
     }
-    object = AddrAdd(object, format->headerSize);
-    next = format->skip(object);
-    next = AddrSub(next, format->headerSize);
+    next = amsObjectNext(ams, format, object);
     AVER(AddrIsAligned(next, PoolAlignment(pool)));
     if (!amsseg->colourTablesInUse || !AMS_IS_WHITE(seg, i))
-      (*f)(object, pool->format, pool, p, s);
+      (*f)(AddrAdd(object, format->headerSize), pool->format, pool, p, s);
     object = next;
   }
 }
@@ -1748,6 +1802,11 @@ static Res AMSDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
     return res;
 
   res = WriteF(stream, depth + 2,
+               "objectSize $W\n", (WriteFW)ams->objectSize,
+               STATISTIC_WRITE("segFreesAvoided $U\n",
+                               (WriteFU)ams->segFreesAvoided)
+               STATISTIC_WRITE("emptySegFills $U\n",
+                               (WriteFU)ams->emptySegFills)
                "segments: * black  + grey  - white  . alloc  ! bad\n"
                "buffers: [ base  < scan limit  | init  > alloc  ] limit\n",
                NULL);
@@ -1840,6 +1899,7 @@ Bool AMSCheck(AMS ams)
   CHECKD(Pool, AMSPool(ams));
   CHECKL(IsA(AMSPool, ams));
   CHECKL(PoolAlignment(AMSPool(ams)) == AMSPool(ams)->format->alignment);
+  CHECKL(SizeIsAligned(ams->objectSize, PoolAlignment(AMSPool(ams))));
   if (ams->pgen != NULL) {
     CHECKL(ams->pgen == &ams->pgenStruct);
     CHECKD(PoolGen, ams->pgen);
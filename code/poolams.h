@@ -48,6 +48,9 @@ typedef struct AMSStruct {
   AMSSegsDestroyFunction segsDestroy;
   AMSSegClassFunction segClass;/* fn to get the class for segments */
   Bool shareAllocTable;        /* the alloc table is also used as white table */
+  Size objectSize;             /* size of every object, or 0 if variable */
+  STATISTIC_DECL(Count segFreesAvoided) /* empty segs kept at reclaim */
+  STATISTIC_DECL(Count emptySegFills) /* fills from existing empty segs */
   Sig sig;                     /* design.mps.sig.field.end.outer */
 } AMSStruct;
 
@@ -101,6 +101,7 @@ typedef struct AWLPoolStruct {
   PoolGen pgen;             /* NULL or pointer to pgenStruct */
   Count succAccesses;       /* number of successive single accesses */
   FindDependentFunction findDependent; /*  to find a dependent object */
+  Bool recordSplats;        /* record splatted weak references? */
   awlStatTotalStruct stats;
   Sig sig;                  /* design.mps.sig.field.end.outer */
 } AWLPoolStruct, *AWL;
@@ -137,6 +138,7 @@ typedef struct AWLSegStruct {
   Count newGrains;          /* grains allocated since last collection */
   Count oldGrains;          /* grains allocated prior to last collection */
   Count singleAccesses;     /* number of accesses processed singly */
+  BT splatted;              /* NULL, or splatted slots .awlseg.splatted */
   awlStatSegStruct stats;
   Sig sig;                  /* design.mps.sig.field.end.outer */
 } AWLSegStruct, *AWLSeg;
@@ -154,6 +156,8 @@ static Bool AWLSegCheck(AWLSeg awlseg)
   CHECKL(awlseg->grains > 0);
   CHECKL(awlseg->grains == awlseg->freeGrains + awlseg->bufferedGrains
          + awlseg->newGrains + awlseg->oldGrains);
+  CHECKL(awlseg->splatted == NULL
+         || RankSetIsMember(SegRankSet(MustBeA(Seg, awlseg)), RankWEAK));
   return TRUE;
 }
 
@@ -190,6 +194,7 @@ static Res AWLSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   Res res;
   Size tableSize;
   void *v;
+  BT splatted = NULL;
   ArgStruct arg;
 
   ArgRequire(&arg, args, awlKeySegRankSet);
@@ -215,9 +220,18 @@ static Res AWLSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   res = ControlAlloc(&v, arena, 3 * tableSize);
   if (res != ResOK)
     goto failControlAlloc;
+  /* <design/poolawl#.awlseg.splatted> */
+  if (MustBeA(AWLPool, pool)->recordSplats && rankSet == RankSetSingle(RankWEAK)) {
+    Count slots = size / sizeof(Ref);
+    res = BTCreate(&splatted, arena, slots);
+    if (res != ResOK)
+      goto failSplatted;
+    BTResRange(splatted, 0, slots);
+  }
   awlseg->mark = v;
   awlseg->scanned = PointerAdd(v, tableSize);
   awlseg->alloc = PointerAdd(v, 2 * tableSize);
+  awlseg->splatted = splatted;
   awlseg->grains = bits;
   BTResRange(awlseg->mark, 0, bits);
   BTResRange(awlseg->scanned, 0, bits);
@@ -236,6 +250,8 @@ static Res AWLSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   return ResOK;
 
+failSplatted:
+  ControlFree(arena, v, 3 * tableSize);
 failControlAlloc:
   NextMethod(Inst, AWLSeg, finish)(MustBeA(Inst, seg));
 failSuperInit:
@@ -261,6 +277,8 @@ static void AWLSegFinish(Inst inst)
   AVER(segGrains == awlseg->grains);
   tableSize = BTSize(segGrains);
   ControlFree(arena, awlseg->mark, 3 * tableSize);
+  if (awlseg->splatted != NULL)
+    BTDestroy(awlseg->splatted, arena, SegSize(seg) / sizeof(Ref));
   awlseg->sig = SigInvalid;
 
   /* finish the superclass fields last */
@@ -348,6 +366,11 @@ static Bool awlSegCanTrySingleAccess(Arena arena, Seg seg, Addr addr)
   awlseg = MustBeA(AWLSeg, seg);
   awl = MustBeA(AWLPool, SegPool(seg));
 
+  /* A single-reference scan can't record splats, so scan the whole
+     segment instead. <design/poolawl#.awlseg.splatted.single> */
+  if (awlseg->splatted != NULL)
+    return FALSE;
+
   /* If there have been too many single accesses in a row then don't
      keep trying them, even if it means retaining objects. */
   if(AWLHaveTotalSALimit) {
@@ -533,11 +556,13 @@ static Addr awlNoDependent(Addr addr)
 /* AWLInit -- initialize an AWL pool */
 
 ARG_DEFINE_KEY(AWL_FIND_DEPENDENT, Fun);
+ARG_DEFINE_KEY(AWL_RECORD_SPLATS, Bool);
 
 static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
   AWL awl;
   FindDependentFunction findDependent = awlNoDependent;
+  Bool recordSplats = AWL_RECORD_SPLATS_DEFAULT;
   Chain chain;
   Res res;
   ArgStruct arg;
@@ -550,6 +575,8 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 
   if (ArgPick(&arg, args, MPS_KEY_AWL_FIND_DEPENDENT))
     findDependent = (FindDependentFunction)arg.val.addr_method;
+  if (ArgPick(&arg, args, MPS_KEY_AWL_RECORD_SPLATS))
+    recordSplats = arg.val.b;
   if (ArgPick(&arg, args, MPS_KEY_CHAIN))
     chain = arg.val.chain;
   else {
@@ -572,6 +599,9 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   AVER(FUNCHECK(findDependent));
   awl->findDependent = findDependent;
 
+  AVERT(Bool, recordSplats);
+  awl->recordSplats = recordSplats;
+
   AVERT(Chain, chain);
   AVER(gen <= ChainGens(chain));
   AVER(chain->arena == PoolArena(pool));
@@ -952,6 +982,7 @@ static Res awlSegScanSinglePass(Bool *anyScannedReturn, ScanState ss,
 
 static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
 {
+  AWLSeg awlseg = MustBeA(AWLSeg, seg);
   Bool anyScanned;
   Bool scanAllObjects;
   Res res;
@@ -974,9 +1005,14 @@ static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   scanAllObjects =
     (TraceSetDiff(ss->traces, SegWhite(seg)) != TraceSetEMPTY);
 
+  /* <design/poolawl#.awlseg.splatted> */
+  if (awlseg->splatted != NULL)
+    ScanStateSetSplatTable(ss, awlseg->splatted, SegBase(seg), SegLimit(seg));
+
   do {
     res = awlSegScanSinglePass(&anyScanned, ss, seg, scanAllObjects);
     if (res != ResOK) {
+      ScanStateSetSplatTable(ss, NULL, NULL, NULL);
       *totalReturn = FALSE;
       return res;
     }
@@ -985,6 +1021,8 @@ static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   /* gotten fixed) */
   } while(!scanAllObjects && anyScanned);
 
+  ScanStateSetSplatTable(ss, NULL, NULL, NULL);
+
   *totalReturn = scanAllObjects;
   AWLNoteScan(seg, ss);
   return ResOK;
@@ -1095,6 +1133,10 @@ static void awlSegReclaim(Seg seg, Trace trace)
       BTResRange(awlseg->mark, i, j);
       BTSetRange(awlseg->scanned, i, j);
       BTResRange(awlseg->alloc, i, j);
+      if (awlseg->splatted != NULL)
+        BTResRange(awlseg->splatted,
+                   AddrOffset(base, p) / sizeof(Ref),
+                   AddrOffset(base, q) / sizeof(Ref));
       reclaimedGrains += j - i;
     }
     i = j;
@@ -1217,6 +1259,73 @@ static void awlSegWalk(Seg seg, Format format, FormattedObjectsVisitor f,
 }
 
 
+/* awlSegSplatsWalk -- visit and forget splatted slots in a segment
+ *
+ * <design/poolawl#.fun.splats-walk>.
+ */
+
+static void awlSegSplatsWalk(Seg seg, mps_awl_splat_visitor_t visitor,
+                             void *closure)
+{
+  AWLSeg awlseg = MustBeA(AWLSeg, seg);
+  Pool pool = SegPool(seg);
+  Arena arena = PoolArena(pool);
+  Format format = pool->format;
+  Count slots = SegSize(seg) / sizeof(Ref);
+  Addr object, base, limit;
+  Buffer buffer;
+  Bool hasBuffer;
+
+  AVER(FUNCHECK(visitor));
+  /* closure is arbitrary and can't be checked */
+
+  if (awlseg->splatted == NULL || BTIsResRange(awlseg->splatted, 0, slots))
+    return;
+
+  base = SegBase(seg);
+  limit = SegLimit(seg);
+  hasBuffer = SegBuffer(&buffer, seg);
+  ShieldExpose(arena, seg);
+  object = base;
+  while (object < limit) {
+    Addr next;
+    Index i, slot, slotLimit;
+
+    if (hasBuffer
+        && object == BufferScanLimit(buffer)
+        && BufferScanLimit(buffer) != BufferLimit(buffer)) {
+      object = BufferLimit(buffer);
+      continue;
+    }
+    i = PoolIndexOfAddr(base, pool, object);
+    if (!BTGet(awlseg->alloc, i)) {
+      object = AddrAdd(object, PoolAlignment(pool));
+      continue;
+    }
+    next = AddrSub(format->skip(AddrAdd(object, format->headerSize)),
+                   format->headerSize);
+    AVER(AddrIsAligned(next, PoolAlignment(pool)));
+
+    /* An unmarked object may be dead, so keep its splats until it is
+       either marked or reclaimed. */
+    if (BTGet(awlseg->mark, i)) {
+      slot = AddrOffset(base, object) / sizeof(Ref);
+      slotLimit = AddrOffset(base, next) / sizeof(Ref);
+      while (slot < slotLimit
+             && BTFindFirstSet(&slot, awlseg->splatted, slot, slotLimit)) {
+        BTRes(awlseg->splatted, slot);
+        (*visitor)(AddrAdd(object, format->headerSize),
+                   (mps_addr_t *)AddrAdd(base, slot * sizeof(Ref)),
+                   closure);
+        ++slot;
+      }
+    }
+    object = next;
+  }
+  ShieldCover(arena, seg);
+}
+
+
 /* AWLTotalSize -- total memory allocated from the arena */
 /* TODO: This code is repeated in AMS */
 
@@ -1261,6 +1370,33 @@ mps_pool_class_t mps_class_awl(void)
 }
 
 
+/* mps_awl_splats_walk -- visit and forget splatted weak references
+ *
+ * <design/poolawl#.fun.splats-walk>.
+ */
+
+void mps_awl_splats_walk(mps_pool_t mps_pool,
+                         mps_awl_splat_visitor_t visitor, void *closure)
+{
+  Pool pool = (Pool)mps_pool;
+  Arena arena;
+  Ring node, nextNode;
+
+  AVER(TESTT(Pool, pool));
+  arena = PoolArena(pool);
+  ArenaEnter(arena);
+  AVERC(AWLPool, pool);
+  AVER(FUNCHECK(visitor));
+
+  RING_FOR(node, &pool->segRing, nextNode) {
+    Seg seg = SegOfPoolRing(node);
+    awlSegSplatsWalk(seg, visitor, closure);
+  }
+
+  ArenaLeave(arena);
+}
+
+
 /* AWLCheck -- check an AWL pool */
 
 ATTRIBUTE_UNUSED
@@ -1273,6 +1409,7 @@ static Bool AWLCheck(AWL awl)
     CHECKD(PoolGen, awl->pgen);
   /* Nothing to check about succAccesses. */
   CHECKL(FUNCHECK(awl->findDependent));
+  CHECKL(BoolCheck(awl->recordSplats));
   /* Don't bother to check stats. */
   return TRUE;
 }
@@ -97,6 +97,20 @@ static void MRGRefPartSetRef(Arena arena, RefPart refPart, Ref ref)
 }
 
 
+/* MRGGen -- guardians for references to one generation
+ *
+ * <design/poolmrg#.alloc.gen>.
+ */
+
+typedef struct MRGGenStruct *MRGGen;
+typedef struct MRGGenStruct {
+  RingStruct mrgRing;       /* link in ring of generations in the pool */
+  Bool hasGen;              /* references are to a generation? */
+  Serial serial;            /* serial of that generation, if hasGen */
+  RingStruct freeRing;      /* free guardians for the generation */
+} MRGGenStruct;
+
+
 /* MRGStruct -- MRG pool structure */
 
 #define MRGSig          ((Sig)0x519369B0) /* SIGnature MRG POol */
@@ -104,9 +118,10 @@ static void MRGRefPartSetRef(Arena arena, RefPart refPart, Ref ref)
 typedef struct MRGStruct {
   PoolStruct poolStruct;    /* generic pool structure */
   RingStruct entryRing;     /* <design/poolmrg#.poolstruct.entry> */
-  RingStruct freeRing;      /* <design/poolmrg#.poolstruct.free> */
+  RingStruct genRing;       /* <design/poolmrg#.poolstruct.free> */
   RingStruct refRing;       /* <design/poolmrg#.poolstruct.refring> */
   Size extendBy;            /* <design/poolmrg#.extend> */
+  Bool migrate;             /* <design/poolmrg#.migrate> */
   Sig sig;                  /* design.mps.sig.field.end.outer */
 } MRGStruct;
 
@@ -127,9 +142,10 @@ static Bool MRGCheck(MRG mrg)
   CHECKD(Pool, pool);
   CHECKC(MRGPool, mrg);
   CHECKD_NOSIG(Ring, &mrg->entryRing);
-  CHECKD_NOSIG(Ring, &mrg->freeRing);
+  CHECKD_NOSIG(Ring, &mrg->genRing);
   CHECKD_NOSIG(Ring, &mrg->refRing);
   CHECKL(mrg->extendBy == ArenaGrainSize(PoolArena(pool)));
+  CHECKL(BoolCheck(mrg->migrate));
   return TRUE;
 }
 
@@ -150,6 +166,8 @@ typedef struct MRGRefSegStruct {
   GCSegStruct gcSegStruct;  /* superclass fields must come first */
   RingStruct mrgRing;       /* <design/poolmrg#.mrgseg.ref.segring> */
   MRGLinkSeg linkSeg;       /* <design/poolmrg#.mrgseg.ref.linkseg> */
+  MRGGen gen;               /* <design/poolmrg#.mrgseg.ref.gen> */
+  Bool scanned;             /* <design/poolmrg#.mrgseg.ref.scanned> */
   Sig sig;                  /* design.mps.sig.field.end.outer */
 } MRGRefSegStruct;
 
@@ -195,6 +213,9 @@ static Bool MRGRefSegCheck(MRGRefSeg refseg)
   CHECKD_NOSIG(Ring, &refseg->mrgRing);
   CHECKD(MRGLinkSeg, refseg->linkSeg);
   CHECKL(refseg->linkSeg->refSeg == refseg);
+  CHECKL(refseg->gen != NULL);
+  CHECKD_NOSIG(Ring, &refseg->gen->freeRing);
+  CHECKL(BoolCheck(refseg->scanned));
   return TRUE;
 }
 
@@ -243,11 +264,14 @@ static void mrgLinkSegFinish(Inst inst)
 
 ARG_DEFINE_KEY(mrg_seg_link_seg, Pointer);
 #define mrgKeyLinkSeg (&_mps_key_mrg_seg_link_seg)
+ARG_DEFINE_KEY(mrg_seg_gen, Pointer);
+#define mrgKeyGen (&_mps_key_mrg_seg_gen)
 
 static Res MRGRefSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 {
   MRGLinkSeg linkseg;
   MRGRefSeg refseg;
+  MRGGen gen;
   MRG mrg = MustBeA(MRGPool, pool);
   Res res;
   ArgStruct arg;
@@ -258,6 +282,8 @@ static Res MRGRefSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
      It's initialized here to the newly initialized ref segment. */
   ArgRequire(&arg, args, mrgKeyLinkSeg);
   linkseg = arg.val.p;
+  ArgRequire(&arg, args, mrgKeyGen);
+  gen = arg.val.p;
 
   /* Initialize the superclass fields first via next-method call */
   res = NextMethod(Seg, MRGRefSeg, init)(seg, pool, base, size, args);
@@ -274,6 +300,8 @@ static Res MRGRefSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   RingInit(&refseg->mrgRing);
   RingAppend(&mrg->refRing, &refseg->mrgRing);
   refseg->linkSeg = linkseg;
+  refseg->gen = gen;
+  refseg->scanned = FALSE;
   AVER(NULL == linkseg->refSeg); /* .link.nullref */
 
   SetClassOfPoly(seg, CLASS(MRGRefSeg));
@@ -347,6 +375,19 @@ static Count MRGGuardiansPerSeg(MRG mrg)
   ((RefPart)SegBase(MustBeA(Seg, refseg)) + (index))
 
 
+static MRGRefSeg MRGRefSegOfLink(Link link, Arena arena)
+{
+  Seg seg = NULL;       /* suppress "may be used uninitialized" */
+  Bool b;
+
+  AVER(link != NULL); /* Better checks done by SegOfAddr */
+
+  b = SegOfAddr(&seg, arena, (Addr)link);
+  AVER(b);
+  return MustBeA(MRGLinkSeg, seg)->refSeg;
+}
+
+
 static RefPart MRGRefPartOfLink(Link link, Arena arena)
 {
   Seg seg = NULL;       /* suppress "may be used uninitialized" */
@@ -400,17 +441,23 @@ static Link MRGLinkOfRefPart(RefPart refPart, Arena arena)
 #endif
 
 
-/* MRGGuardianInit -- Initialises both parts of a guardian */
+/* MRGGuardianInit -- Initialises both parts of a guardian
+ *
+ * The guardian goes on the free ring for the generation of its ref
+ * segment. <design/poolmrg#.alloc.gen>.
+ */
 
-static void MRGGuardianInit(MRG mrg, Link link, RefPart refPart)
+static void MRGGuardianInit(MRG mrg, MRGRefSeg refseg,
+                            Link link, RefPart refPart)
 {
   AVERT(MRG, mrg);
+  AVERT(MRGRefSeg, refseg);
   AVER(link != NULL);
   AVER(refPart != NULL);
 
   RingInit(&link->the.linkRing);
   link->state = MRGGuardianFREE;
-  RingAppend(&mrg->freeRing, &link->the.linkRing);
+  RingAppend(&refseg->gen->freeRing, &link->the.linkRing);
   /* <design/poolmrg#.free.overwrite> */
   MRGRefPartSetRef(PoolArena(MustBeA(AbstractPool, mrg)), refPart, 0);
 }
@@ -438,7 +485,8 @@ static void MRGMessageDelete(Message message)
   link = linkOfMessage(message);
   AVER(link->state == MRGGuardianFINAL);
   MessageFinish(message);
-  MRGGuardianInit(MustBeA(MRGPool, pool), link, MRGRefPartOfLink(link, arena));
+  MRGGuardianInit(MustBeA(MRGPool, pool), MRGRefSegOfLink(link, arena),
+                  link, MRGRefPartOfLink(link, arena));
 }
 
 
@@ -495,9 +543,13 @@ static void MRGSegPairDestroy(MRGRefSeg refseg)
 }
 
 
-/* MRGSegPairCreate -- create a pair of segments (link & ref) */
+/* MRGSegPairCreate -- create a pair of segments (link & ref)
+ *
+ * The guardians in the new pair are for references to the given
+ * generation. <design/poolmrg#.alloc.gen>.
+ */
 
-static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
+static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg, MRGGen gen)
 {
   Pool pool = MustBeA(AbstractPool, mrg);
   Arena arena = PoolArena(pool);
@@ -512,6 +564,7 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
   Size linkSegSize;
 
   AVER(refSegReturn != NULL);
+  AVER(gen != NULL);
 
   nGuardians = MRGGuardiansPerSeg(mrg);
   linkSegSize = nGuardians * sizeof(LinkStruct);
@@ -526,6 +579,7 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
 
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, mrgKeyLinkSeg, p, linkseg); /* .ref.initarg */
+    MPS_ARGS_ADD_FIELD(args, mrgKeyGen, p, gen);
     res = SegAlloc(&segRefPart, CLASS(MRGRefSeg),
                    LocusPrefDefault(), mrg->extendBy, pool,
                    args);
@@ -538,7 +592,7 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
   refPartBase = (RefPart)SegBase(segRefPart);
 
   for(i = 0; i < nGuardians; ++i)
-    MRGGuardianInit(mrg, linkBase + i, refPartBase + i);
+    MRGGuardianInit(mrg, refseg, linkBase + i, refPartBase + i);
   AVER((Addr)(&linkBase[i]) <= SegLimit(segLink));
   AVER((Addr)(&refPartBase[i]) <= SegLimit(segRefPart));
 
@@ -577,6 +631,160 @@ static void MRGFinalize(Arena arena, MRGLinkSeg linkseg, Index indx)
 }
 
 
+/* mrgRefGen -- find the generation of the referent of a guardian
+ *
+ * Returns TRUE and the serial number of the generation if ref points
+ * into a segment that belongs to a generation, or FALSE otherwise.
+ * Only segments allocated by PoolGenAlloc are in a generation, and
+ * they are on its ring of segments.
+ */
+
+static Bool mrgRefGen(Serial *serialReturn, Arena arena, Ref ref)
+{
+  Seg seg;
+  PoolGen pgen;
+
+  AVER(serialReturn != NULL);
+
+  if (!SegOfAddr(&seg, arena, (Addr)ref) || !IsA(GCSeg, seg)
+      || RingIsSingle(&SegGCSeg(seg)->genRing))
+    return FALSE;
+  pgen = PoolSegPoolGen(SegPool(seg), seg);
+  AVERT(PoolGen, pgen);
+  *serialReturn = pgen->gen->serial;
+  return TRUE;
+}
+
+
+/* mrgGenFind -- find or create the guardians for a generation
+ *
+ * <design/poolmrg#.alloc.gen>.
+ */
+
+static Res mrgGenFind(MRGGen *genReturn, MRG mrg, Bool hasGen, Serial serial)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
+  Ring node, nextNode;
+  MRGGen gen;
+  void *p;
+  Res res;
+
+  AVER(genReturn != NULL);
+  AVERT(Bool, hasGen);
+
+  RING_FOR(node, &mrg->genRing, nextNode) {
+    gen = RING_ELT(MRGGen, mrgRing, node);
+    if (gen->hasGen == hasGen && (!hasGen || gen->serial == serial)) {
+      *genReturn = gen;
+      return ResOK;
+    }
+  }
+
+  res = ControlAlloc(&p, arena, sizeof(MRGGenStruct));
+  if (res != ResOK)
+    return res;
+  gen = p;
+  RingInit(&gen->mrgRing);
+  gen->hasGen = hasGen;
+  gen->serial = hasGen ? serial : 0;
+  RingInit(&gen->freeRing);
+  RingAppend(&mrg->genRing, &gen->mrgRing);
+
+  *genReturn = gen;
+  return ResOK;
+}
+
+
+/* mrgGuardianMigrate -- move the indexth guardian to its referent's
+ * generation
+ *
+ * If the referent of a registered guardian is no longer in the
+ * generation that the guardian's ref segment is for, the guardian is
+ * moved to a free guardian for the referent's generation, keeping its
+ * place on the entry ring, so that collections of the generation it
+ * left no longer scan it. If there is no free guardian for that
+ * generation and one can't be made, the guardian stays where it is,
+ * which is safe. <design/poolmrg#.migrate>.
+ */
+
+static void mrgGuardianMigrate(MRG mrg, MRGRefSeg refseg, Index indx)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
+  Link link, newLink;
+  Ref ref;
+  Bool hasGen;
+  Serial serial = 0;
+  MRGGen gen;
+  MRGRefSeg junk; /* unused */
+
+  link = linkOfIndex(refseg->linkSeg, indx);
+  AVER(link->state == MRGGuardianPREFINAL);
+
+  ref = MRGRefPartRef(arena, refPartOfIndex(refseg, indx));
+  hasGen = mrgRefGen(&serial, arena, ref);
+  if (refseg->gen->hasGen == hasGen
+      && (!hasGen || refseg->gen->serial == serial))
+    return;
+
+  if (mrgGenFind(&gen, mrg, hasGen, serial) != ResOK)
+    return;
+  if (RingIsSingle(&gen->freeRing)
+      && MRGSegPairCreate(&junk, mrg, gen) != ResOK)
+    return;
+
+  newLink = linkOfRing(RingNext(&gen->freeRing));
+  AVER(newLink->state == MRGGuardianFREE);
+  RingRemove(&newLink->the.linkRing);
+  newLink->state = MRGGuardianPREFINAL;
+  /* Insert before the old link, so the entry ring order is kept. */
+  RingAppend(&link->the.linkRing, &newLink->the.linkRing);
+  MRGRefPartSetRef(arena, MRGRefPartOfLink(newLink, arena), ref);
+
+  RingRemove(&link->the.linkRing);
+  RingFinish(&link->the.linkRing);
+  MRGGuardianInit(mrg, refseg, link, refPartOfIndex(refseg, indx));
+}
+
+
+/* mrgMigrate -- move guardians whose referents changed generation
+ *
+ * Only the ref segments that have been scanned since the last call
+ * are examined, because only a collection can move a referent to
+ * another generation. Grey segments are left for a later call, so
+ * that reading their references doesn't scan them through the
+ * barrier. Called at the end of each trace (see MRGMigrate) and
+ * before each registration. <design/poolmrg#.migrate>.
+ */
+
+static void mrgMigrate(MRG mrg)
+{
+  Ring node, nextNode;
+  Count nGuardians;
+  Index i;
+
+  AVERT(MRG, mrg);
+
+  if (!mrg->migrate)
+    return;
+  mrg->migrate = FALSE;
+
+  nGuardians = MRGGuardiansPerSeg(mrg);
+  RING_FOR(node, &mrg->refRing, nextNode) {
+    MRGRefSeg refseg = RING_ELT(MRGRefSeg, mrgRing, node);
+    if (!refseg->scanned)
+      continue;
+    if (SegGrey(MustBeA(Seg, refseg)) != TraceSetEMPTY) {
+      mrg->migrate = TRUE;
+    } else {
+      refseg->scanned = FALSE;
+      for (i = 0; i < nGuardians; ++i)
+        if (linkOfIndex(refseg->linkSeg, i)->state == MRGGuardianPREFINAL)
+          mrgGuardianMigrate(mrg, refseg, i);
+    }
+  }
+}
+
+
 static Res mrgRefSegScan(Bool *totalReturn, Seg seg, ScanState ss)
 {
   MRGRefSeg refseg = MustBeA(MRGRefSeg, seg);
@@ -622,6 +830,10 @@ static Res mrgRefSegScan(Bool *totalReturn, Seg seg, ScanState ss)
     }
   } TRACE_SCAN_END(ss);
 
+  /* <design/poolmrg#.migrate> */
+  refseg->scanned = TRUE;
+  mrg->migrate = TRUE;
+
   *totalReturn = TRUE;
   return ResOK;
 }
@@ -645,9 +857,10 @@ static Res MRGInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   mrg = CouldBeA(MRGPool, pool);
 
   RingInit(&mrg->entryRing);
-  RingInit(&mrg->freeRing);
+  RingInit(&mrg->genRing);
   RingInit(&mrg->refRing);
   mrg->extendBy = ArenaGrainSize(PoolArena(pool));
+  mrg->migrate = FALSE;
 
   SetClassOfPoly(pool, CLASS(MRGPool));
   mrg->sig = MRGSig;
@@ -690,8 +903,11 @@ static void MRGFinish(Inst inst)
   if (!RingIsSingle(&mrg->entryRing)) {
     RingRemove(&mrg->entryRing);
   }
-  if (!RingIsSingle(&mrg->freeRing)) {
-    RingRemove(&mrg->freeRing);
+  RING_FOR(node, &mrg->genRing, nextNode) {
+    MRGGen gen = RING_ELT(MRGGen, mrgRing, node);
+    if (!RingIsSingle(&gen->freeRing)) {
+      RingRemove(&gen->freeRing);
+    }
   }
 
   RING_FOR(node, &mrg->refRing, nextNode) {
@@ -699,7 +915,16 @@ static void MRGFinish(Inst inst)
     MRGSegPairDestroy(refseg);
   }
 
+  RING_FOR(node, &mrg->genRing, nextNode) {
+    MRGGen gen = RING_ELT(MRGGen, mrgRing, node);
+    RingRemove(&gen->mrgRing);
+    RingFinish(&gen->mrgRing);
+    RingFinish(&gen->freeRing);
+    ControlFree(PoolArena(pool), gen, sizeof(MRGGenStruct));
+  }
+
   mrg->sig = SigInvalid;
+  RingFinish(&mrg->genRing);
   RingFinish(&mrg->refRing);
   /* <design/poolmrg#.trans.no-finish> */
 
@@ -718,17 +943,38 @@ Res MRGRegister(Pool pool, Ref ref)
   RefPart refPart;
   Res res;
   MRGRefSeg junk; /* unused */
+  MRGGen gen;
+  Bool hasGen;
+  Serial serial = 0;
 
   AVER(ref != 0);
 
+  /* <design/poolmrg#.migrate> */
+  mrgMigrate(mrg);
+
+  /* <design/poolmrg#.alloc.gen> */
+  hasGen = mrgRefGen(&serial, arena, ref);
+  res = mrgGenFind(&gen, mrg, hasGen, serial);
+
   /* <design/poolmrg#.alloc.grow> */
-  if (RingIsSingle(&mrg->freeRing)) {
-    res = MRGSegPairCreate(&junk, mrg);
-    if (res != ResOK)
+  if (res == ResOK && RingIsSingle(&gen->freeRing))
+    res = MRGSegPairCreate(&junk, mrg, gen);
+  if (res != ResOK) {
+    /* <design/poolmrg#.alloc.gen.fallback> */
+    Ring node, nextNode;
+    gen = NULL;
+    RING_FOR(node, &mrg->genRing, nextNode) {
+      MRGGen other = RING_ELT(MRGGen, mrgRing, node);
+      if (!RingIsSingle(&other->freeRing)) {
+        gen = other;
+        break;
+      }
+    }
+    if (gen == NULL)
       return res;
   }
-  AVER(!RingIsSingle(&mrg->freeRing));
-  freeNode = RingNext(&mrg->freeRing);
+  AVER(!RingIsSingle(&gen->freeRing));
+  freeNode = RingNext(&gen->freeRing);
 
   link = linkOfRing(freeNode);
   AVER(link->state == MRGGuardianFREE);
@@ -745,6 +991,32 @@ Res MRGRegister(Pool pool, Ref ref)
 }
 
 
+/* MRGRegisterUndo -- undo the most recent registrations
+ *
+ * Deregister the guardians for the last count calls to MRGRegister,
+ * which must not have been finalized since. This allows a batch of
+ * registrations to be backed out if one of them fails.
+ */
+
+void MRGRegisterUndo(Pool pool, Count count)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Arena arena = PoolArena(pool);
+
+  while (count > 0) {
+    Ring node = RingPrev(&mrg->entryRing);
+    Link link = linkOfRing(node);
+    AVER(node != &mrg->entryRing);
+    AVER(link->state == MRGGuardianPREFINAL);
+    RingRemove(node);
+    RingFinish(node);
+    MRGGuardianInit(mrg, MRGRefSegOfLink(link, arena),
+                    link, MRGRefPartOfLink(link, arena));
+    -- count;
+  }
+}
+
+
 /* MRGDeregister -- deregister (once) an object for finalization
  *
  * TODO: Definalization loops over all finalizable objects in the heap,
@@ -784,7 +1056,7 @@ Res MRGDeregister(Pool pool, Ref obj)
           && MRGRefPartRef(arena, refPart) == obj) {
         RingRemove(&link->the.linkRing);
         RingFinish(&link->the.linkRing);
-        MRGGuardianInit(mrg, link, refPart);
+        MRGGuardianInit(mrg, refSeg, link, refPart);
         return ResOK;
       }
     }
@@ -793,6 +1065,47 @@ Res MRGDeregister(Pool pool, Ref obj)
 }
 
 
+/* MRGMigrate -- move guardians whose referents changed generation
+ *
+ * Called by traceReclaim when a trace has finished, with the arena
+ * lock held and outside any scan. <design/poolmrg#.migrate.end>.
+ */
+
+void MRGMigrate(Pool pool)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  mrgMigrate(mrg);
+}
+
+
+/* MRGGuardianCount -- count the registered guardians for a generation
+ *
+ * Returns the number of guardians that are registered and not yet
+ * finalized, and whose ref segments are for references to gen.
+ * <design/poolmrg#.alloc.gen>.
+ */
+
+Count MRGGuardianCount(Pool pool, GenDesc gen)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Ring node, nextNode;
+  Count nGuardians, count = 0;
+  Index i;
+
+  AVERT(GenDesc, gen);
+
+  nGuardians = MRGGuardiansPerSeg(mrg);
+  RING_FOR(node, &mrg->refRing, nextNode) {
+    MRGRefSeg refseg = RING_ELT(MRGRefSeg, mrgRing, node);
+    if (refseg->gen->hasGen && refseg->gen->serial == gen->serial)
+      for (i = 0; i < nGuardians; ++i)
+        if (linkOfIndex(refseg->linkSeg, i)->state == MRGGuardianPREFINAL)
+          ++ count;
+  }
+  return count;
+}
+
+
 /* MRGDescribe -- describe an MRG pool
  *
  * This could be improved by implementing MRGSegDescribe
@@ -9,12 +9,16 @@
 #define poolmrg_h
 
 #include "mpmtypes.h"
+#include "locus.h"
 
 typedef struct MRGStruct *MRG;
 
 extern PoolClass PoolClassMRG(void);
 extern Res MRGRegister(Pool, Ref);
+extern void MRGRegisterUndo(Pool, Count);
 extern Res MRGDeregister(Pool, Ref);
+extern void MRGMigrate(Pool);
+extern Count MRGGuardianCount(Pool, GenDesc);
 
 #endif /* poolmrg_h */
 
@@ -81,6 +81,51 @@ ZoneSet ZoneSetOfSeg(Arena arena, Seg seg)
 }
 
 
+/* FineZoneSetAddRange -- add a range of addresses to a fine zone set
+ *
+ * A fine zone set is an array of MPS_WORD_WIDTH zone sets, one for
+ * each zone. Each zone stripe is divided into MPS_WORD_WIDTH fine
+ * stripes, and fineZoneSet[z] has bit i set if the range overlaps
+ * fine stripe i of a stripe of zone z. <design/trace#.fix.fine>.
+ */
+
+void FineZoneSetAddRange(ZoneSet fineZoneSet[MPS_WORD_WIDTH],
+                         Arena arena, Addr base, Addr limit)
+{
+  Word zbase, zlimit;
+  Index i;
+
+  AVER(fineZoneSet != NULL);
+  AVERT(Arena, arena);
+  AVER(limit > base);
+
+  /* If the range spans all zones, it covers a whole stripe of every
+     zone, so the fine zone set is universal. */
+  zbase = (Word)base >> arena->zoneShift;
+  zlimit = (((Word)limit-1) >> arena->zoneShift) + 1;
+  if (zlimit - zbase > MPS_WORD_WIDTH) {
+    for (i = 0; i < MPS_WORD_WIDTH; ++i)
+      fineZoneSet[i] = ZoneSetUNIV;
+    return;
+  }
+
+  /* Otherwise add the fine stripes of each zone stripe in turn. Within
+     a zone stripe they are contiguous and don't wrap around. */
+  while (base < limit) {
+    Addr stripeLimit = (Addr)(((Word)base | (ArenaStripeSize(arena) - 1)) + 1);
+    Word fbase, flast;
+    if (stripeLimit <= base || stripeLimit > limit) /* wrapped or past end */
+      stripeLimit = limit;
+    fbase = AddrFineZone(arena, base);
+    flast = AddrFineZone(arena, AddrSub(stripeLimit, 1));
+    AVER(fbase <= flast);
+    fineZoneSet[AddrZone(arena, base)] |=
+      (((ZoneSet)2 << flast) - 1) & ~(((ZoneSet)1 << fbase) - 1);
+    base = stripeLimit;
+  }
+}
+
+
 /* RangeInZoneSetFirst -- find an area of address space within a zone set
  *
  * Given a range of addresses, find the first sub-range of at least size that
@@ -122,6 +122,7 @@ static Res segAbsInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   NextMethod(Inst, Seg, init)(CouldBeA(Inst, seg));
 
   limit = AddrAdd(base, size);
+  seg->base = base;
   seg->limit = limit;
   seg->rankSet = RankSetEMPTY;
   seg->white = TraceSetEMPTY;
@@ -207,7 +208,7 @@ static void segAbsFinish(Inst inst)
 
   limit = SegLimit(seg);
 
-  TRACT_TRACT_FOR(tract, addr, arena, seg->firstTract, limit) {
+  TRACT_TRACT_FOR(tract, addr, arena, seg->firstTract, seg->base, limit) {
     AVERT(Tract, tract);
     TRACT_UNSET_SEG(tract);
   }
@@ -870,9 +871,9 @@ Bool SegCheck(Seg seg)
   CHECKU(Pool, pool);
   arena = PoolArena(pool);
   CHECKU(Arena, arena);
-  CHECKL(AddrIsArenaGrain(TractBase(seg->firstTract), arena));
+  CHECKL(AddrIsArenaGrain(seg->base, arena));
   CHECKL(AddrIsArenaGrain(seg->limit, arena));
-  CHECKL(seg->limit > TractBase(seg->firstTract));
+  CHECKL(seg->limit > seg->base);
   /* CHECKL(BoolCheck(seq->queued)); <design/type#.bool.bitfield.check> */
 
   /* Each tract of the segment must agree about the segment and its
@@ -883,7 +884,9 @@ Bool SegCheck(Seg seg)
   {
     Tract tract;
     Addr addr;
-    TRACT_TRACT_FOR(tract, addr, arena, seg->firstTract, seg->limit) {
+    CHECKL(TractBase(seg->firstTract) == seg->base);
+    TRACT_TRACT_FOR(tract, addr, arena, seg->firstTract, seg->base,
+                    seg->limit) {
       Seg trseg = NULL; /* suppress compiler warning */
 
       CHECKD_NOSIG(Tract, tract);
@@ -1178,6 +1181,7 @@ static Res segTrivSplit(Seg seg, Seg segHi,
   AVERT(Seg, seg);
 
   InstInit(CouldBeA(Inst, segHi));
+  segHi->base = mid;
   segHi->limit = limit;
   segHi->rankSet = seg->rankSet;
   segHi->white = seg->white;
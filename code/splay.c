@@ -1331,6 +1331,130 @@ Bool SplayFindLast(Tree *nodeReturn, SplayTree splay,
 }
 
 
+/* SplayLookupFirst, SplayLookupLast -- find a node without splaying
+ *
+ * As SplayFindFirst and SplayFindLast, but descend the tree without
+ * restructuring it. This relies on testTree being exact: if it
+ * returns TRUE for a sub-tree, then some node in that sub-tree
+ * satisfies testNode. Then the descent never needs to backtrack. (If
+ * testTree is not exact, these may fail to find a node that satisfies
+ * testNode.) <design/splay#.function.splay.lookup.first>.
+ */
+
+Bool SplayLookupFirst(Tree *nodeReturn, SplayTree splay,
+                      SplayTestNodeFunction testNode,
+                      SplayTestTreeFunction testTree,
+                      void *testClosure)
+{
+  Tree node;
+
+  AVER_CRITICAL(nodeReturn != NULL);
+  AVERT_CRITICAL(SplayTree, splay);
+  AVER_CRITICAL(FUNCHECK(testNode));
+  AVER_CRITICAL(FUNCHECK(testTree));
+
+  node = SplayTreeRoot(splay);
+  if (node == TreeEMPTY || !(*testTree)(splay, node, testClosure))
+    return FALSE; /* no suitable nodes in tree */
+
+  for (;;) {
+    if (TreeHasLeft(node)
+        && (*testTree)(splay, TreeLeft(node), testClosure))
+      node = TreeLeft(node);
+    else if ((*testNode)(splay, node, testClosure))
+      break;
+    else if (TreeHasRight(node)
+             && (*testTree)(splay, TreeRight(node), testClosure))
+      node = TreeRight(node);
+    else
+      return FALSE; /* testTree was not exact */
+  }
+
+  *nodeReturn = node;
+  return TRUE;
+}
+
+Bool SplayLookupLast(Tree *nodeReturn, SplayTree splay,
+                     SplayTestNodeFunction testNode,
+                     SplayTestTreeFunction testTree,
+                     void *testClosure)
+{
+  Tree node;
+
+  AVER_CRITICAL(nodeReturn != NULL);
+  AVERT_CRITICAL(SplayTree, splay);
+  AVER_CRITICAL(FUNCHECK(testNode));
+  AVER_CRITICAL(FUNCHECK(testTree));
+
+  node = SplayTreeRoot(splay);
+  if (node == TreeEMPTY || !(*testTree)(splay, node, testClosure))
+    return FALSE; /* no suitable nodes in tree */
+
+  for (;;) {
+    if (TreeHasRight(node)
+        && (*testTree)(splay, TreeRight(node), testClosure))
+      node = TreeRight(node);
+    else if ((*testNode)(splay, node, testClosure))
+      break;
+    else if (TreeHasLeft(node)
+             && (*testTree)(splay, TreeLeft(node), testClosure))
+      node = TreeLeft(node);
+    else
+      return FALSE; /* testTree was not exact */
+  }
+
+  *nodeReturn = node;
+  return TRUE;
+}
+
+
+/* SplayTreeBalance -- rebalance a splay tree
+ *
+ * Rebalances the tree in linear time, then updates the client
+ * property of every node, children before parents. A tree that is
+ * searched with SplayLookupFirst/Last is never
+ * restructured by searches, so a client may call this from time to
+ * time instead <design/splay#.function.splay.tree.balance>.
+ *
+ * The update is a post-order traversal with an explicit stack, which
+ * is bounded because the balanced tree has height at most the number
+ * of bits in a word <code/splay.c#.note.stack>.
+ */
+
+void SplayTreeBalance(SplayTree splay)
+{
+  Tree stack[MPS_WORD_WIDTH + 1];
+  Tree node, last = TreeEMPTY;
+  Count depth = 0;
+
+  AVERT(SplayTree, splay);
+
+  TreeBalance(&splay->root);
+
+  if (!SplayHasUpdate(splay))
+    return;
+
+  node = SplayTreeRoot(splay);
+  while (node != TreeEMPTY || depth > 0) {
+    if (node != TreeEMPTY) {
+      AVER(depth < NELEMS(stack));
+      stack[depth] = node;
+      ++depth;
+      node = TreeLeft(node);
+    } else {
+      Tree top = stack[depth - 1];
+      if (TreeHasRight(top) && TreeRight(top) != last) {
+        node = TreeRight(top);
+      } else {
+        splay->updateNode(splay, top);
+        last = top;
+        --depth;
+      }
+    }
+  }
+}
+
+
 /* SplayNodeRefresh -- updates the client property that has changed at a node
  *
  * This function undertakes to call the client updateNode callback for each
@@ -67,6 +67,15 @@ extern Bool SplayFindLast(Tree *nodeReturn, SplayTree splay,
                           SplayTestNodeFunction testNode,
                           SplayTestTreeFunction testTree,
                           void *closure);
+extern Bool SplayLookupFirst(Tree *nodeReturn, SplayTree splay,
+                             SplayTestNodeFunction testNode,
+                             SplayTestTreeFunction testTree,
+                             void *closure);
+extern Bool SplayLookupLast(Tree *nodeReturn, SplayTree splay,
+                            SplayTestNodeFunction testNode,
+                            SplayTestTreeFunction testTree,
+                            void *closure);
+extern void SplayTreeBalance(SplayTree splay);
 
 extern void SplayNodeRefresh(SplayTree splay, Tree node);
 extern void SplayNodeInit(SplayTree splay, Tree node);
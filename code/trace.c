@@ -8,8 +8,10 @@
  * .design: design.mps.trace.
  */
 
+#include "bt.h"
 #include "locus.h"
 #include "mpm.h"
+#include "poolmrg.h"
 #include <limits.h> /* for LONG_MAX */
 
 SRCID(trace, "$Id$");
@@ -49,12 +51,16 @@ Bool ScanStateCheck(ScanState ss)
     white = ZoneSetUnion(white, ss->arena->trace[ti].white);
   TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
   CHECKL(ScanStateWhite(ss) == white);
+  CHECKL(ss->fineWhite == NULL
+         || (ss->arena->fineZones && TraceSetIsSingle(ss->traces)));
   CHECKU(Arena, ss->arena);
   /* Summaries could be anything, and can't be checked. */
   CHECKL(TraceSetCheck(ss->traces));
   CHECKL(TraceSetSuper(ss->arena->busyTraces, ss->traces));
   CHECKL(RankCheck(ss->rank));
   CHECKL(BoolCheck(ss->wasMarked));
+  CHECKL(ss->splatTable != NULL || ss->splatBase == ss->splatLimit);
+  CHECKL(ss->splatBase <= ss->splatLimit);
   /* @@@@ checks for counts missing */
   return TRUE;
 }
@@ -88,6 +94,7 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
      of sets of traces in TraceFix.  See also impl.c.trans.park. */
   ss->fix = NULL;
   ss->fixClosure = NULL;
+  ss->fineWhite = NULL;
   TRACE_SET_ITER(ti, trace, ts, arena) {
     if (ss->fix == NULL) {
       ss->fix = trace->fix;
@@ -96,6 +103,10 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
       AVER(ss->fix == trace->fix);
       AVER(ss->fixClosure == trace->fixClosure);
     }
+    /* The fine zone filter is only used when scanning for a single
+       trace. <design/trace#.fix.fine.single> */
+    if (arena->fineZones && TraceSetIsSingle(ts))
+      ss->fineWhite = trace->fineWhite;
   } TRACE_SET_ITER_END(ti, trace, ts, arena);
   AVER(ss->fix != NULL);
 
@@ -111,6 +122,9 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   ScanStateSetZoneShift(ss, arena->zoneShift);
   ScanStateSetUnfixedSummary(ss, RefSetEMPTY);
   ss->fixedSummary = RefSetEMPTY;
+  ss->splatTable = NULL;
+  ss->splatBase = NULL;
+  ss->splatLimit = NULL;
   ss->arena = arena;
   ss->wasMarked = TRUE;
   ScanStateSetWhite(ss, white);
@@ -405,6 +419,9 @@ Res TraceAddWhite(Trace trace, Seg seg)
     /* Add the segment to the approximation of the white set if the
        pool made it white. */
     trace->white = ZoneSetUnion(trace->white, ZoneSetOfSeg(trace->arena, seg));
+    if (trace->arena->fineZones)
+      FineZoneSetAddRange(trace->fineWhite, trace->arena,
+                          SegBase(seg), SegLimit(seg));
 
     /* if the pool is a moving GC, then condemned objects may move */
     if (PoolHasAttr(pool, AttrMOVINGGC)) {
@@ -681,6 +698,7 @@ static Res traceFlip(Trace trace)
   arena->flippedTraces = TraceSetAdd(arena->flippedTraces, trace);
 
   EVENT2(TraceFlipEnd, trace, arena);
+  TracePostGCEvent(trace, GCEventFLIP);
 
   ShieldRelease(arena);
   return ResOK;
@@ -691,6 +709,14 @@ failRootFlip:
 }
 
 
+/* traceWork -- a measure of the work done for this trace.
+ *
+ * <design/type#.work>.
+ */
+
+#define traceWork(trace) ((Work)((trace)->segScanSize + (trace)->rootScanSize))
+
+
 /* TraceCreate -- create a Trace object
  *
  * Allocates and initializes a new Trace object with a TraceId which is
@@ -722,6 +748,7 @@ Res TraceCreate(Trace *traceReturn, Arena arena, TraceStartWhy why)
 {
   TraceId ti;
   Trace trace;
+  Index zone;
 
   AVER(traceReturn != NULL);
   AVERT(Arena, arena);
@@ -739,6 +766,8 @@ found:
   trace->arena = arena;
   trace->why = why;
   trace->white = ZoneSetEMPTY;
+  for (zone = 0; zone < NELEMS(trace->fineWhite); ++zone)
+    trace->fineWhite[zone] = ZoneSetEMPTY;
   trace->mayMove = ZoneSetEMPTY;
   trace->ti = ti;
   trace->state = TraceINIT;
@@ -751,6 +780,8 @@ found:
   trace->notCondemned = (Size)0;
   trace->foundation = (Size)0;  /* nothing grey yet */
   trace->quantumWork = (Work)0; /* computed in TraceStart */
+  trace->flipTime = (Clock)0;
+  trace->advanceTime = (Clock)0;
   STATISTIC(trace->greySegCount = (Count)0);
   STATISTIC(trace->greySegMax = (Count)0);
   STATISTIC(trace->rootScanCount = (Count)0);
@@ -881,6 +912,17 @@ void TraceDestroyFinished(Trace trace)
   STATISTIC(EVENT4(TraceStatReclaim, trace, trace->arena,
                    trace->reclaimCount, trace->reclaimSize));
 
+  /* <design/strategy#.policy.model> */
+  {
+    GenDesc gen = GenDescOldestCondemned(trace);
+    if (gen != NULL)
+      GenDescAccountForCollection(gen, trace, traceWork(trace),
+                                  (double)trace->advanceTime
+                                  / (double)ClocksPerSec(),
+                                  (double)trace->flipTime
+                                  / (double)ClocksPerSec());
+  }
+
   traceDestroyCommon(trace);
 }
 
@@ -935,8 +977,14 @@ static void traceReclaim(Trace trace)
   ArenaCompact(arena, trace);  /* let arenavm drop chunks */
 
   TracePostMessage(trace);  /* trace end */
+  TracePostGCEvent(trace, GCEventEND);
   /* Immediately pre-allocate messages for next time; failure is okay */
   (void)TraceIdMessagesCreate(arena, trace->ti);
+
+  /* Move finalization guardians after the objects that the trace
+     promoted. <design/poolmrg#.migrate.end> */
+  if (arena->isFinalPool)
+    MRGMigrate(arena->finalPool);
 }
 
 /* TraceRankForAccess -- Returns rank to scan at if we hit a barrier.
@@ -947,6 +995,12 @@ static void traceReclaim(Trace trace)
  * .scan.conservative: It's safe to scan at EXACT unless the band is
  * WEAK and in that case the segment should be weak.
  *
+ * If the trace band is AMBIG then the trace has flipped but has not
+ * yet looked for grey segments (traceFindGrey advances the band), so
+ * nothing has been scanned and we scan EXACT, as for the EXACT band.
+ * This happens if the mutator hits a barrier straight after a
+ * collection is started by mps_arena_start_collect.
+ *
  * If the trace band is EXACT then we scan EXACT. This might prevent
  * finalisation messages and may preserve objects pointed to only by weak
  * references but tough luck -- the mutator wants to look.
@@ -986,8 +1040,6 @@ Rank TraceRankForAccess(Arena arena, Seg seg)
   rankSet = SegRankSet(seg);
   switch(band) {
   case RankAMBIG:
-    NOTREACHED;
-    break;
   case RankEXACT:
     return RankEXACT;
   case RankFINAL:
@@ -1126,6 +1178,29 @@ void ScanStateSetSummary(ScanState ss, RefSet summary)
 }
 
 
+/* ScanStateSetSplatTable -- record splatted references in a table
+ *
+ * While the table is not NULL, whenever a fix splats a reference
+ * (replaces it with NULL because the rank is weak and the referent
+ * is dead) and the reference was fixed in place in the area [base,
+ * limit), the bit for its slot is set in the table, which must have
+ * one bit for each reference-sized slot in the area. Pass NULL to
+ * stop recording. <design/trace#.fix.splat>
+ */
+
+void ScanStateSetSplatTable(ScanState ss, BT table, Addr base, Addr limit)
+{
+  AVERT(ScanState, ss);
+  AVER(table != NULL || base == limit);
+  AVER(base <= limit);
+  AVER(AddrIsAligned(base, sizeof(Ref)));
+
+  ss->splatTable = table;
+  ss->splatBase = base;
+  ss->splatLimit = limit;
+}
+
+
 /* ScanStateSummary -- calculate the summary of scanned references
  *
  * The summary of the scanned references is the summary of the unfixed
@@ -1386,6 +1461,13 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
   STATISTIC(++ss->fixRefCount);
   EVENT_CRITICAL4(TraceFix, ss, mps_ref_io, ref, ss->rank);
 
+  /* Second zone test, against the fine white set, which is cheaper
+     than finding the segment. <design/trace#.fix.fine> */
+  if (ss->fineWhite != NULL
+      && !ZoneSetIsMember(ss->fineWhite[AddrZone(ss->arena, ref)],
+                          AddrFineZone(ss->arena, ref)))
+    goto done;
+
   /* This sequence of tests is equivalent to calling TractOfAddr(),
    * but inlined so that we can distinguish between "not pointing to
    * chunk" and "pointing to chunk but not to tract" so that we can
@@ -1445,6 +1527,13 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
     return res;
   }
 
+  /* <design/trace#.fix.splat> */
+  if (ref == (Ref)0 && ss->splatTable != NULL
+      && ss->splatBase <= (Addr)mps_ref_io
+      && (Addr)mps_ref_io < ss->splatLimit)
+    BTSet(ss->splatTable,
+          AddrOffset(ss->splatBase, (Addr)mps_ref_io) / sizeof(Ref));
+
 done:
   /* <design/trace#.fix.fixed.all> */
   ss->fixedSummary = RefSetAdd(ss->arena, ss->fixedSummary, ref);
@@ -1610,6 +1699,7 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
   Arena arena;
   Res res;
   Seg seg;
+  Clock start;
 
   AVERT(Trace, trace);
   AVER(trace->state == TraceINIT);
@@ -1689,22 +1779,24 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
 
   trace->state = TraceUNFLIPPED;
   TracePostStartMessage(trace);
+  TracePostGCEvent(trace, GCEventSTART);
 
   /* All traces must flip at beginning at the moment. */
-  return traceFlip(trace);
+  start = ClockNow();
+  res = traceFlip(trace);
+  trace->flipTime += ClockNow() - start;
+  return res;
 }
 
 
-/* traceWork -- a measure of the work done for this trace.
+/* TraceAdvance -- progress a trace by one step
  *
- * <design/type#.work>.
+ * A step is typically the scan of a single segment, so reading the
+ * clock here would be a large overhead. Callers charge the processor
+ * time for a whole quantum of steps to trace->advanceTime instead.
+ * <design/strategy#.policy.model.measure>.
  */
 
-#define traceWork(trace) ((Work)((trace)->segScanSize + (trace)->rootScanSize))
-
-
-/* TraceAdvance -- progress a trace by one step */
-
 void TraceAdvance(Trace trace)
 {
   Arena arena;
@@ -1785,7 +1877,7 @@ Res TraceStartCollectAll(Trace *traceReturn, Arena arena, TraceStartWhy why)
   res = TraceCondemnEnd(&mortality, trace);
   if(res != ResOK) /* should try some other trace, really @@@@ */
     goto failCondemn;
-  finishingTime = (double)ArenaAvail(arena)
+  finishingTime = (double)ArenaSoftAvail(arena)
     - (double)trace->condemned * (1.0 - mortality);
   if(finishingTime < 0) {
     /* Run out of time, should really try a smaller collection. @@@@ */
@@ -1829,6 +1921,7 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
   Trace trace;
   Arena arena;
   Work oldWork, newWork, work, endWork;
+  Clock start;
 
   AVERT(Globals, globals);
   arena = GlobalsArena(globals);
@@ -1845,9 +1938,11 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
   AVER(arena->busyTraces == TraceSetSingle(trace));
   oldWork = traceWork(trace);
   endWork = oldWork + trace->quantumWork;
+  start = ClockNow();
   do {
     TraceAdvance(trace);
   } while (trace->state != TraceFINISHED && traceWork(trace) < endWork);
+  trace->advanceTime += ClockNow() - start;
   newWork = traceWork(trace);
   AVER(newWork >= oldWork);
   work = newWork - oldWork;
@@ -16,6 +16,10 @@
  *
  *   - TraceIdMessages.  Pre-allocated messages for traceid.
  *
+ *   - GC event hooks.  Called when the MPS leaves the arena.
+ *
+ *   - Memory pressure.  Reported to the client's handler like GC events.
+ *
  *   - ArenaRelease, ArenaClamp, ArenaPark.
  */
 
@@ -504,6 +508,357 @@ void TraceIdMessagesDestroy(Arena arena, TraceId ti)
 
 
 
+/* --------  GC event hooks  -------- */
+
+
+/* ArenaGCEventHookSet -- install the client's GC event hook
+ *
+ * A NULL hook turns off GC events. Any events queued for the previous
+ * hook are discarded. <design/message-gc#.hook>.
+ */
+
+void ArenaGCEventHookSet(Arena arena, GCEventHook hook, void *closure)
+{
+  AVERT(Arena, arena);
+  /* hook and closure are arbitrary and can't be checked */
+
+  arena->gcEventHook = hook;
+  arena->gcEventClosure = closure;
+  arena->gcEventCount = 0;
+}
+
+
+/* arenaGCEventNew -- queue a GC event, if anyone is listening
+ *
+ * Returns the new event with its common fields filled in, or NULL if
+ * there is no hook or the queue is full. Unlike messages, events
+ * don't need any memory to be allocated, so they can be posted from
+ * anywhere. <design/message-gc#.hook.queue>.
+ */
+
+static GCEvent arenaGCEventNew(Arena arena, GCEventKind kind)
+{
+  GCEvent event;
+
+  AVERT(Arena, arena);
+  AVER(kind < GCEventLIMIT);
+
+  if (arena->gcEventHook == NULL)
+    return NULL;
+  if (arena->gcEventCount >= ArenaGCEventQueueLENGTH) {
+    arena->droppedGCEvents += 1;
+    return NULL;
+  }
+
+  event = &arena->gcEvents[arena->gcEventCount];
+  ++ arena->gcEventCount;
+  event->kind = kind;
+  event->clock = ClockNow();
+  event->why = NULL;
+  event->condemned_size = 0;
+  event->live_size = 0;
+  event->not_condemned_size = 0;
+  event->requested_size = 0;
+  event->committed = ArenaCommitted(arena);
+  return event;
+}
+
+
+/* TracePostGCEvent -- queue a start, flip, or end event for a trace
+ *
+ * The event carries the same data as the corresponding message (see
+ * .message.data), as far as it is known at that point.
+ */
+
+void TracePostGCEvent(Trace trace, GCEventKind kind)
+{
+  GCEvent event;
+
+  AVERT(Trace, trace);
+
+  event = arenaGCEventNew(trace->arena, kind);
+  if (event == NULL)
+    return;
+
+  event->condemned_size = trace->condemned;
+  switch (kind) {
+  case GCEventSTART:
+    event->why = TraceStartWhyToString(trace->why);
+    break;
+  case GCEventFLIP:
+    break;
+  case GCEventEND:
+    event->live_size = trace->forwardedSize + trace->preservedInPlaceSize;
+    event->not_condemned_size = trace->notCondemned;
+    break;
+  default:
+    NOTREACHED;
+  }
+}
+
+
+/* ArenaPostPressureEvent -- queue a memory pressure event
+ *
+ * Posted when an allocation of size bytes fails because it would
+ * exceed the commit limit.
+ */
+
+void ArenaPostPressureEvent(Arena arena, Size size)
+{
+  GCEvent event = arenaGCEventNew(arena, GCEventPRESSURE);
+  if (event != NULL)
+    event->requested_size = size;
+}
+
+
+/* ArenaGCEventsTake -- remove the queued GC events
+ *
+ * Copies the queued events into the events array, which must have
+ * room for ArenaGCEventQueueLENGTH events, empties the queue, and
+ * returns the number of events, together with the hook to call
+ * with them. This is called with the arena lock held, so that the
+ * hook can be called after the lock is released.
+ * <design/message-gc#.hook.deliver>.
+ */
+
+Count ArenaGCEventsTake(GCEventStruct events[], GCEventHook *hookReturn,
+                        void **closureReturn, Arena arena)
+{
+  Count i, count;
+
+  AVER(events != NULL);
+  AVER(hookReturn != NULL);
+  AVER(closureReturn != NULL);
+  AVERT(Arena, arena);
+
+  count = arena->gcEventCount;
+  for (i = 0; i < count; ++i)
+    events[i] = arena->gcEvents[i];
+  arena->gcEventCount = 0;
+  *hookReturn = arena->gcEventHook;
+  *closureReturn = arena->gcEventClosure;
+  return count;
+}
+
+/* --------  Memory pressure  -------- */
+
+
+/* ArenaPressureHandlerSet -- install the client's pressure handler
+ *
+ * The thresholds are fractions of the arena's limit. A NULL handler
+ * turns off pressure reports. <design/message-gc#.pressure>.
+ */
+
+void ArenaPressureHandlerSet(Arena arena, PressureHandler handler,
+                             void *closure, double moderate,
+                             double critical)
+{
+  AVERT(Arena, arena);
+  /* handler and closure are arbitrary and can't be checked */
+  AVER(0.0 < moderate);
+  AVER(moderate <= critical);
+  AVER(critical <= 1.0);
+
+  arena->pressureHandler = handler;
+  arena->pressureClosure = closure;
+  arena->pressureModerate = moderate;
+  arena->pressureCritical = critical;
+  arena->pressureLevel = PressureNONE;
+  arena->pressurePending = PressureNONE;
+  arena->pressureTarget = 0;
+  arena->pressureAsked = FALSE;
+  arena->pressureCredit = 0;
+
+  /* Report straight away if the arena is already over a threshold. */
+  ArenaPressureCheck(arena);
+}
+
+
+/* arenaPressureTarget -- size to release to get below a threshold
+ *
+ * This is the size that brings the memory in use ArenaPressureRELIEF
+ * of the limit below the threshold, so that the handler isn't called
+ * again as soon as the next allocation takes the arena back over.
+ * <design/message-gc#.pressure.target>.
+ */
+
+static Size arenaPressureTarget(Size inUse, Size limit, double threshold)
+{
+  double goal = (double)limit * (threshold - ArenaPressureRELIEF);
+  if (goal < 0.0)
+    goal = 0.0;
+  if ((double)inUse <= goal)
+    return 0;
+  return (Size)((double)inUse - goal);
+}
+
+
+/* ArenaPressureCheck -- compare the memory in use with the thresholds
+ *
+ * Called whenever the arena allocates or frees memory. If the memory
+ * in use has crossed a threshold upwards since the last check, post
+ * pressure at that level. The level falls without a report, so that
+ * crossing a threshold again is reported again.
+ */
+
+void ArenaPressureCheck(Arena arena)
+{
+  Size limit, inUse;
+  PressureLevel level;
+  double threshold;
+
+  AVERT(Arena, arena);
+
+  if (arena->pressureHandler == NULL)
+    return;
+
+  limit = ArenaSoftLimit(arena);
+  if (arena->commitLimit < limit)
+    limit = arena->commitLimit;
+  inUse = arena->committed - arena->spareCommitted;
+
+  if ((double)inUse >= (double)limit * arena->pressureCritical) {
+    level = PressureCRITICAL;
+    threshold = arena->pressureCritical;
+  } else if ((double)inUse >= (double)limit * arena->pressureModerate) {
+    level = PressureMODERATE;
+    threshold = arena->pressureModerate;
+  } else {
+    arena->pressureLevel = PressureNONE;
+    return;
+  }
+
+  if (level > arena->pressureLevel)
+    ArenaPostPressure(arena, level,
+                      arenaPressureTarget(inUse, limit, threshold));
+  arena->pressureLevel = level;
+}
+
+
+/* ArenaPostPressure -- queue a report of memory pressure
+ *
+ * Reports are combined until they are delivered by
+ * ArenaLeaveRelieved: the handler is called once, with the highest
+ * level and the largest target.
+ */
+
+void ArenaPostPressure(Arena arena, PressureLevel level, Size target)
+{
+  AVERT(Arena, arena);
+  AVER(PressureNONE < level);
+  AVER(level < PressureLIMIT);
+
+  if (arena->pressureHandler == NULL)
+    return;
+  if (level > arena->pressurePending)
+    arena->pressurePending = level;
+  if (target > arena->pressureTarget)
+    arena->pressureTarget = target;
+}
+
+
+/* ArenaPressureDefer -- ask the client for memory before collecting
+ *
+ * Called by the policy when it is about to collect the world because
+ * memory is short, and target is the shortfall. If the client hasn't
+ * already been asked, post critical pressure and return TRUE: the
+ * policy should defer the collection until the handler has run. See
+ * <design/message-gc#.pressure.defer>.
+ */
+
+Bool ArenaPressureDefer(Arena arena, Size target)
+{
+  AVERT(Arena, arena);
+
+  if (arena->pressureHandler == NULL || arena->pressureAsked)
+    return FALSE;
+  arena->pressureAsked = TRUE;
+  ArenaPostPressure(arena, PressureCRITICAL, target);
+  return TRUE;
+}
+
+
+/* ArenaPressureCreditTake -- size released since last policy decision
+ *
+ * Returns the size that the client's handler has said it released
+ * since the last call, and resets it to zero.
+ */
+
+Size ArenaPressureCreditTake(Arena arena)
+{
+  Size credit;
+
+  AVERT(Arena, arena);
+
+  credit = arena->pressureCredit;
+  arena->pressureCredit = 0;
+  return credit;
+}
+
+
+/* ArenaPressureTake -- remove the queued pressure report
+ *
+ * If there is a report, return TRUE and update the return arguments
+ * with the level, target and the handler to call. Otherwise, return
+ * FALSE. This is called with the arena lock held, so that the
+ * handler can be called after the lock is released.
+ *
+ * While the handler is running, further reports stay queued, so that
+ * calls to the MPS from the handler don't call it again, and so that
+ * it is not called on two threads at once.
+ */
+
+Bool ArenaPressureTake(PressureLevel *levelReturn, Size *targetReturn,
+                       PressureHandler *handlerReturn,
+                       void **closureReturn, Arena arena)
+{
+  AVER(levelReturn != NULL);
+  AVER(targetReturn != NULL);
+  AVER(handlerReturn != NULL);
+  AVER(closureReturn != NULL);
+  AVERT(Arena, arena);
+
+  if (arena->pressurePending == PressureNONE || arena->pressureDelivering)
+    return FALSE;
+  AVER(arena->pressureHandler != NULL);
+  arena->pressureDelivering = TRUE;
+
+  *levelReturn = arena->pressurePending;
+  *targetReturn = arena->pressureTarget;
+  *handlerReturn = arena->pressureHandler;
+  *closureReturn = arena->pressureClosure;
+  arena->pressurePending = PressureNONE;
+  arena->pressureTarget = 0;
+  return TRUE;
+}
+
+
+/* ArenaPressureRelieved -- record the result of calling the handler
+ *
+ * The released size is credited to the next policy decision. If the
+ * handler released all that was asked for, it may be asked again
+ * before the next collection of the world.
+ * <design/message-gc#.pressure.account>.
+ */
+
+void ArenaPressureRelieved(Arena arena, PressureLevel level, Size target,
+                           Size released)
+{
+  AVERT(Arena, arena);
+  AVER(PressureNONE < level);
+  AVER(level < PressureLIMIT);
+  AVER(arena->pressureDelivering);
+
+  arena->pressureDelivering = FALSE;
+  arena->pressureReleased += released;
+  arena->pressureCredit += released;
+  if (released >= target)
+    arena->pressureAsked = FALSE;
+  EVENT4(PressureRelieved, arena, level, target, released);
+}
+
+
+
 /* -----  ArenaRelease, ArenaClamp, ArenaPark, ArenaPostmortem  ----- */
 
 
@@ -549,12 +904,14 @@ void ArenaPark(Globals globals)
   start = ClockNow();
 
   while(arena->busyTraces != TraceSetEMPTY) {
-    /* Advance all active traces. */
+    /* Run each active trace to completion. */
     TRACE_SET_ITER(ti, trace, arena->busyTraces, arena)
-      TraceAdvance(trace);
-      if(trace->state == TraceFINISHED) {
-        TraceDestroyFinished(trace);
-      }
+      Clock traceStart = ClockNow();
+      do {
+        TraceAdvance(trace);
+      } while (trace->state != TraceFINISHED);
+      trace->advanceTime += ClockNow() - traceStart;
+      TraceDestroyFinished(trace);
     TRACE_SET_ITER_END(ti, trace, arena->busyTraces, arena);
   }
 
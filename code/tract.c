@@ -44,7 +44,6 @@ Bool TractCheck(Tract tract)
 {
   if (TractHasPool(tract)) {
     CHECKU(Pool, TractPool(tract));
-    CHECKL(AddrIsArenaGrain(TractBase(tract), TractArena(tract)));
   }
   if (TractHasSeg(tract)) {
     CHECKU(Seg, TractSeg(tract));
@@ -55,13 +54,12 @@ Bool TractCheck(Tract tract)
 
 /* TractInit -- initialize a tract */
 
-void TractInit(Tract tract, Pool pool, Addr base)
+void TractInit(Tract tract, Pool pool)
 {
   AVER_CRITICAL(tract != NULL);
   AVERT_CRITICAL(Pool, pool);
 
   tract->pool = pool;
-  tract->base = base;
   tract->seg = NULL;
 
   AVERT(Tract, tract);
@@ -89,15 +87,28 @@ void TractFinish(Tract tract)
  */
 
 
-/* TractBase -- return the base address of a tract */
+/* TractBase -- return the base address of a tract
+ *
+ * The tract doesn't store its base address: the page table is in the
+ * chunk's overhead, so the chunk containing the tract structure is
+ * the chunk whose memory the tract describes, and the base follows
+ * from the tract's index in the page table. <design/arena#.tract.base>
+ */
 
-Addr (TractBase)(Tract tract)
+Addr TractBase(Tract tract)
 {
-  Addr base;
+  Chunk chunk = NULL; /* suppress "may be used uninitialized" */
+  Bool found;
+  Index i;
+
   AVERT_CRITICAL(Tract, tract); /* .tract.critical */
+  AVER_CRITICAL(TractHasPool(tract));
 
-  base = tract->base;
-  return base;
+  found = ChunkOfAddr(&chunk, TractArena(tract), (Addr)tract);
+  AVER_CRITICAL(found);
+  i = (Index)(PageOfTract(tract) - chunk->pageTable);
+  AVER_CRITICAL(i < chunk->pages);
+  return PageIndexBase(chunk, i);
 }
 
 
@@ -322,11 +333,21 @@ TreeKey ChunkKey(Tree tree)
 Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr)
 {
   Tree tree;
+  Chunk primary;
 
   AVER_CRITICAL(chunkReturn != NULL);
   AVERT_CRITICAL(Arena, arena);
   /* addr is arbitrary */
 
+  /* Try the primary chunk first. In an arena with a single chunk,
+     every reference into the arena points into it, so the lookup is
+     just two comparisons. <design/arena#.chunk.lookup.primary> */
+  primary = arena->primary;
+  if (primary != NULL && primary->base <= addr && addr < primary->limit) {
+    *chunkReturn = primary;
+    return TRUE;
+  }
+
   if (TreeFind(&tree, ArenaChunkTree(arena), TreeKeyOfAddrVar(addr),
                ChunkCompare)
       == CompareEQUAL)
@@ -452,7 +473,6 @@ Tract TractOfBaseAddr(Arena arena, Addr addr)
 void PageAlloc(Chunk chunk, Index pi, Pool pool)
 {
   Tract tract;
-  Addr base;
   Page page;
 
   AVERT_CRITICAL(Chunk, chunk);
@@ -463,9 +483,8 @@ void PageAlloc(Chunk chunk, Index pi, Pool pool)
 
   page = ChunkPage(chunk, pi);
   tract = PageTract(page);
-  base = PageIndexBase(chunk, pi);
   BTSet(chunk->allocTable, pi);
-  TractInit(tract, pool, base);
+  TractInit(tract, pool);
 }
 
 
@@ -23,12 +23,10 @@
 typedef struct TractStruct { /* Tract structure */
   Pool pool;      /* MUST BE FIRST <design/arena#.tract.field.pool> */
   Seg seg;                     /* NULL or segment containing tract */
-  Addr base;                   /* Base address of the tract */
 } TractStruct;
 
 
-extern Addr (TractBase)(Tract tract);
-#define TractBase(tract)         ((tract)->base)
+extern Addr TractBase(Tract tract);
 extern Addr TractLimit(Tract tract, Arena arena);
 
 #define TractHasPool(tract) (TractPool(tract) != NULL)
@@ -37,7 +35,7 @@ extern Addr TractLimit(Tract tract, Arena arena);
 #define TractSeg(tract)          RVALUE((tract)->seg)
 
 extern Bool TractCheck(Tract tract);
-extern void TractInit(Tract tract, Pool pool, Addr base);
+extern void TractInit(Tract tract, Pool pool);
 extern void TractFinish(Tract tract);
 
 
@@ -176,10 +174,12 @@ extern Index IndexOfAddr(Chunk chunk, Addr addr);
  * <design/arena-tract-iter#.if.macro>.
  * Parameters arena & limit are evaluated multiple times.
  * Check first tract & last tract lie with the same chunk.
+ * base must be the base address of firstTract: it is passed in
+ * because computing it is not free <design/arena#.tract.base>.
  */
 
-#define TRACT_TRACT_FOR(tract, addr, arena, firstTract, limit) \
-  tract = (firstTract); addr = TractBase(tract); \
+#define TRACT_TRACT_FOR(tract, addr, arena, firstTract, base, limit) \
+  tract = (firstTract); addr = (base); \
   TractAverContiguousRange(arena, addr, limit); \
   for(; tract != NULL; \
       (addr = AddrAdd(addr, ArenaGrainSize(arena))), \
@@ -195,7 +195,8 @@ extern Index IndexOfAddr(Chunk chunk, Addr addr);
  */
 
 #define TRACT_FOR(tract, addr, arena, base, limit) \
-  TRACT_TRACT_FOR(tract, addr, arena, TractOfBaseAddr(arena, base), limit)
+  TRACT_TRACT_FOR(tract, addr, arena, TractOfBaseAddr(arena, base), \
+                  base, limit)
 
 
 extern void PageAlloc(Chunk chunk, Index pi, Pool pool);
@@ -26,6 +26,9 @@ Bool VMCheck(VM vm)
   CHECKL(vm->block != NULL);
   CHECKL((Addr)vm->block <= vm->base);
   CHECKL(vm->mapped <= vm->reserved);
+  CHECKL(BoolCheck(vm->hugePages));
+  CHECKL(BoolCheck(vm->hugeTLB));
+  CHECKL(!vm->hugeTLB || vm->hugePages);
   return TRUE;
 }
 
@@ -80,6 +83,16 @@ Size (VMMapped)(VM vm)
 }
 
 
+/* VMHugePages -- return whether huge pages were requested */
+
+Bool (VMHugePages)(VM vm)
+{
+  AVERT(VM, vm);
+
+  return VMHugePages(vm);
+}
+
+
 /* VMCopy -- copy VM descriptor */
 
 void VMCopy(VM dest, VM src)
@@ -26,6 +26,8 @@ typedef struct VMStruct {
   Addr base, limit;             /* aligned boundaries of reserved space */
   Size reserved;                /* total reserved address space */
   Size mapped;                  /* total mapped memory */
+  Bool hugePages;               /* asked the OS for huge pages? */
+  Bool hugeTLB;                 /* reserved explicit huge pages? */
 } VMStruct;
 
 
@@ -34,19 +36,24 @@ typedef struct VMStruct {
 #define VMLimit(vm) RVALUE((vm)->limit)
 #define VMReserved(vm) RVALUE((vm)->reserved)
 #define VMMapped(vm) RVALUE((vm)->mapped)
+#define VMHugePages(vm) RVALUE((vm)->hugePages)
 
 extern Size PageSize(void);
+extern Size HugePageSize(void);
 extern Size (VMPageSize)(VM vm);
 extern Bool VMCheck(VM vm);
 extern Res VMParamFromArgs(void *params, size_t paramSize, ArgList args);
+extern Size VMParamHugePageSize(void *params);
 extern Res VMInit(VM vmReturn, Size size, Size grainSize, void *params);
 extern void VMFinish(VM vm);
 extern Addr (VMBase)(VM vm);
 extern Addr (VMLimit)(VM vm);
 extern Res VMMap(VM vm, Addr base, Addr limit);
 extern void VMUnmap(VM vm, Addr base, Addr limit);
+extern Bool VMMapZeroes(VM vm);
 extern Size (VMReserved)(VM vm);
 extern Size (VMMapped)(VM vm);
+extern Bool (VMHugePages)(VM vm);
 extern void VMCopy(VM dest, VM src);
 
 
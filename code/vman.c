@@ -20,6 +20,17 @@ Size PageSize(void)
 }
 
 
+/* HugePageSize -- return the huge page size
+ *
+ * There are no huge pages in the ANSI VM.
+ */
+
+Size HugePageSize(void)
+{
+  return PageSize();
+}
+
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
   AVER(params != NULL);
@@ -29,6 +40,16 @@ Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 }
 
 
+/* VMParamHugePageSize -- return the huge page size requested */
+
+Size VMParamHugePageSize(void *params)
+{
+  AVER(params != NULL);
+  UNUSED(params);
+  return PageSize();
+}
+
+
 /* VMInit -- reserve some virtual address space, and create a VM structure */
 
 Res VMInit(VM vm, Size size, Size grainSize, void *params)
@@ -71,6 +92,8 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit < AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = (Size)0;
+  vm->hugePages = FALSE;
+  vm->hugeTLB = FALSE;
 
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -147,6 +170,19 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMMapZeroes -- do newly mapped pages contain zeros?
+ *
+ * No: unmapped pages are filled with junk and mapping doesn't clear
+ * them.
+ */
+
+Bool VMMapZeroes(VM vm)
+{
+  AVERT(VM, vm);
+  return FALSE;
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
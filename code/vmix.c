@@ -36,6 +36,15 @@
  * .remap: Possibly this should use mremap to reduce the number of
  * distinct mappings.  According to our current testing, it doesn't
  * seem to be a problem.
+ *
+ * .lazy: If VM_DECOMMIT_LAZY is defined (see config.h), mapping and
+ * unmapping change the protection of the pages, and unmapping also
+ * calls madvise(2) so that the operating system can take the pages
+ * back. See <design/vm#.impl.ix.lazy>.
+ *
+ * .huge: If huge pages are requested with MPS_KEY_ARENA_HUGE_PAGES,
+ * the reservation is advised with MADV_HUGEPAGE, or if VM_HUGETLB is
+ * defined, reserved with MAP_HUGETLB. See <design/vm#.impl.ix.huge>.
  */
 
 #include "mpm.h"
@@ -72,21 +81,68 @@ Size PageSize(void)
 }
 
 
+/* HugePageSize -- return the huge page size
+ *
+ * If the operating system has no way to request huge pages, this is
+ * the same as the page size. See <design/vm#.impl.ix.huge.size>.
+ */
+
+Size HugePageSize(void)
+{
+#if defined(MADV_HUGEPAGE) || defined(VM_HUGETLB)
+  if (VM_HUGE_PAGE_SIZE > PageSize())
+    return VM_HUGE_PAGE_SIZE;
+#endif
+  return PageSize();
+}
+
+
+typedef struct VMParamsStruct {
+  Bool hugePages;
+} VMParamsStruct, *VMParams;
+
+static const VMParamsStruct vmParamsDefaults = {
+  /* .hugePages = */ FALSE,
+};
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
+  VMParams vmParams;
+  ArgStruct arg;
   AVER(params != NULL);
   AVERT(ArgList, args);
+  AVER(paramSize >= sizeof(VMParamsStruct));
   UNUSED(paramSize);
+  vmParams = (VMParams)params;
+  (void)mps_lib_memcpy(vmParams, &vmParamsDefaults, sizeof(VMParamsStruct));
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_HUGE_PAGES))
+    vmParams->hugePages = arg.val.b;
   return ResOK;
 }
 
 
+/* VMParamHugePageSize -- return the huge page size requested
+ *
+ * This is the page size if huge pages weren't requested or aren't
+ * available.
+ */
+
+Size VMParamHugePageSize(void *params)
+{
+  VMParams vmParams = params;
+  AVER(params != NULL);
+  return vmParams->hugePages ? HugePageSize() : PageSize();
+}
+
+
 /* VMInit -- reserve some virtual address space, and create a VM structure */
 
 Res VMInit(VM vm, Size size, Size grainSize, void *params)
 {
   Size pageSize, reserved;
-  void *vbase;
+  void *vbase = MAP_FAILED;
+  VMParams vmParams = params;
+  Bool hugePages, hugeTLB = FALSE;
 
   AVER(vm != NULL);
   AVERT(ArenaGrainSize, grainSize);
@@ -98,25 +154,60 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   /* Grains must consist of whole pages. */
   AVER(grainSize % pageSize == 0);
 
+  /* Huge pages are only worth having if grains consist of whole huge
+     pages, so that the arena never splits them. See
+     <design/vm#.impl.ix.huge.grain>. */
+  hugePages = VMParamHugePageSize(vmParams) > pageSize
+    && grainSize % HugePageSize() == 0;
+
   /* Check that the rounded-up sizes will fit in a Size. */
   size = SizeRoundUp(size, grainSize);
   if (size < grainSize || size > (Size)(size_t)-1)
     return ResRESOURCE;
-  reserved = size + grainSize - pageSize;
-  if (reserved < grainSize || reserved > (Size)(size_t)-1)
-    return ResRESOURCE;
 
-  /* See .assume.not-last. */
-  vbase = mmap(0, reserved,
-               PROT_NONE, MAP_ANON | MAP_PRIVATE,
-               -1, 0);
-  /* On Darwin the MAP_FAILED return value is not documented, but does
-   * work.  MAP_FAILED _is_ documented by POSIX.
-   */
+#if defined(VM_HUGETLB)
+  if (hugePages) {
+    /* Explicit huge page mappings are aligned to the huge page size,
+       and must be mapped and unmapped in whole huge pages. If the pool
+       of huge pages can't cover the reservation, fall back to
+       transparent huge pages. See <design/vm#.impl.ix.huge.tlb>. */
+    reserved = size + grainSize - HugePageSize();
+    if (reserved >= grainSize && reserved <= (Size)(size_t)-1) {
+      vbase = mmap(0, reserved,
+                   PROT_NONE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB,
+                   -1, 0);
+      if (vbase != MAP_FAILED) {
+        pageSize = HugePageSize();
+        hugeTLB = TRUE;
+      }
+    }
+  }
+#endif
+
   if (vbase == MAP_FAILED) {
-    int e = errno;
-    AVER(e == ENOMEM); /* .assume.mmap.err */
-    return ResRESOURCE;
+    reserved = size + grainSize - pageSize;
+    if (reserved < grainSize || reserved > (Size)(size_t)-1)
+      return ResRESOURCE;
+
+    /* See .assume.not-last. */
+    vbase = mmap(0, reserved,
+                 PROT_NONE, MAP_ANON | MAP_PRIVATE,
+                 -1, 0);
+    /* On Darwin the MAP_FAILED return value is not documented, but does
+     * work.  MAP_FAILED _is_ documented by POSIX.
+     */
+    if (vbase == MAP_FAILED) {
+      int e = errno;
+      AVER(e == ENOMEM); /* .assume.mmap.err */
+      return ResRESOURCE;
+    }
+
+#if defined(MADV_HUGEPAGE)
+    /* This is only advice: the kernel may have been built without
+       transparent huge pages, or they may be disabled. */
+    if (hugePages)
+      (void)madvise(vbase, (size_t)reserved, MADV_HUGEPAGE);
+#endif
   }
 
   vm->pageSize = pageSize;
@@ -127,6 +218,8 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = 0;
+  vm->hugePages = hugePages;
+  vm->hugeTLB = hugeTLB;
 
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -166,12 +259,56 @@ void VMFinish(VM vm)
 static sig_atomic_t vm_prot = PROT_READ | PROT_WRITE | PROT_EXEC;
 
 
+#if defined(VM_DECOMMIT_LAZY)
+
+/* Advice to give when unmapping pages. MADV_FREE lets the operating
+ * system reclaim the pages when it needs memory, but leaves them in
+ * place until then. Kernels that don't support it reject it with
+ * EINVAL, and then we fall back to MADV_DONTNEED, which discards the
+ * pages at once but still avoids changing the mapping. */
+
+#if defined(MADV_FREE)
+static sig_atomic_t vm_advice = MADV_FREE;
+#else
+static sig_atomic_t vm_advice = MADV_DONTNEED;
+#endif
+
+#endif /* VM_DECOMMIT_LAZY */
+
+
+/* vmCommit -- make reserved pages accessible
+ *
+ * Returns TRUE if successful, or FALSE with errno set if not.
+ */
+
+static Bool vmCommit(VM vm, Addr base, Size size, int prot)
+{
+  if (vm->hugeTLB)
+    /* Replacing the mapping would lose the huge pages. */
+    return mprotect((void *)base, (size_t)size, prot) == 0;
+#if defined(VM_DECOMMIT_LAZY)
+  return mprotect((void *)base, (size_t)size, prot) == 0;
+#else
+  if (mmap((void *)base, (size_t)size, prot,
+           MAP_ANON | MAP_PRIVATE | MAP_FIXED,
+           -1, 0) == MAP_FAILED)
+    return FALSE;
+#if defined(MADV_HUGEPAGE)
+  /* The new mapping doesn't inherit the advice given in VMInit. */
+  if (vm->hugePages)
+    (void)madvise((void *)base, (size_t)size, MADV_HUGEPAGE);
+#endif
+  return TRUE;
+#endif
+}
+
+
 /* VMMap -- map the given range of memory */
 
 Res VMMap(VM vm, Addr base, Addr limit)
 {
   Size size;
-  void *result;
+  Bool committed;
 
   AVERT(VM, vm);
   AVER(sizeof(void *) == sizeof(Addr));
@@ -183,10 +320,8 @@ Res VMMap(VM vm, Addr base, Addr limit)
 
   size = AddrOffset(base, limit);
 
-  result = mmap((void *)base, (size_t)size, (int)vm_prot,
-                MAP_ANON | MAP_PRIVATE | MAP_FIXED,
-                -1, 0);
-  if (MAYBE_HARDENED_RUNTIME && result == MAP_FAILED && errno == EACCES
+  committed = vmCommit(vm, base, size, (int)vm_prot);
+  if (MAYBE_HARDENED_RUNTIME && !committed && errno == EACCES
       && (vm_prot & PROT_WRITE) && (vm_prot & PROT_EXEC))
   {
     /* Apple Hardened Runtime is enabled, so that we cannot have
@@ -194,11 +329,9 @@ Res VMMap(VM vm, Addr base, Addr limit)
      * this by dropping the executable part of the request. See
      * <design/vm#impl.xc.prot.exec> for details. */
     vm_prot = PROT_READ | PROT_WRITE;
-    result = mmap((void *)base, (size_t)size, vm_prot,
-                  MAP_ANON | MAP_PRIVATE | MAP_FIXED,
-                  -1, 0);
+    committed = vmCommit(vm, base, size, (int)vm_prot);
   }
-  if (result == MAP_FAILED) {
+  if (!committed) {
     AVER(errno == ENOMEM); /* .assume.mmap.err */
     return ResMEMORY;
   }
@@ -216,7 +349,11 @@ Res VMMap(VM vm, Addr base, Addr limit)
 void VMUnmap(VM vm, Addr base, Addr limit)
 {
   Size size;
+#if defined(VM_DECOMMIT_LAZY)
+  int r;
+#else
   void *addr;
+#endif
 
   AVERT(VM, vm);
   AVER(base < limit);
@@ -228,11 +365,42 @@ void VMUnmap(VM vm, Addr base, Addr limit)
   size = AddrOffset(base, limit);
   AVER(size <= VMMapped(vm));
 
+#if defined(VM_HUGETLB)
+  if (vm->hugeTLB) {
+    /* Explicit huge pages belong to a pool set aside for them, so
+       there is no point in advising the kernel to take them lazily,
+       and replacing the mapping might lose them to another process.
+       Kernels before Linux 5.18 reject MADV_DONTNEED on these pages,
+       and then they stay resident until reused. See
+       <design/vm#.impl.ix.huge.tlb>. */
+    int e;
+    (void)madvise((void *)base, (size_t)size, MADV_DONTNEED);
+    e = mprotect((void *)base, (size_t)size, PROT_NONE);
+    AVER(e == 0);
+    UNUSED(e);
+    vm->mapped -= size;
+    EVENT3(VMUnmap, vm, base, limit);
+    return;
+  }
+#endif
+
+#if defined(VM_DECOMMIT_LAZY)
+  r = madvise((void *)base, (size_t)size, (int)vm_advice);
+  if (r != 0 && vm_advice != MADV_DONTNEED) {
+    AVER(errno == EINVAL);
+    vm_advice = MADV_DONTNEED;
+    r = madvise((void *)base, (size_t)size, (int)vm_advice);
+  }
+  AVER(r == 0);
+  r = mprotect((void *)base, (size_t)size, PROT_NONE);
+  AVER(r == 0);
+#else
   /* see <design/vmo1#.fun.unmap.offset> */
   addr = mmap((void *)base, (size_t)size,
               PROT_NONE, MAP_ANON | MAP_PRIVATE | MAP_FIXED,
               -1, 0);
   AVER(addr == (void *)base);
+#endif
 
   vm->mapped -= size;
 
@@ -240,6 +408,28 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMMapZeroes -- do newly mapped pages contain zeros?
+ *
+ * A fresh anonymous mapping, or an anonymous page discarded with
+ * MADV_DONTNEED, reads as zeros. But a page released with MADV_FREE
+ * keeps its old contents if the operating system didn't get round
+ * to reclaiming it, and explicit huge pages may not have been
+ * discarded at all (see VMUnmap). See <design/vm#.if.map.zeroes>.
+ */
+
+Bool VMMapZeroes(VM vm)
+{
+  AVERT(VM, vm);
+  if (vm->hugeTLB)
+    return FALSE;
+#if defined(VM_DECOMMIT_LAZY)
+  return vm_advice == MADV_DONTNEED;
+#else
+  return TRUE;
+#endif
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
@@ -66,6 +66,19 @@ Size PageSize(void)
 }
 
 
+/* HugePageSize -- return the huge page size
+ *
+ * Windows large pages need the "Lock pages in memory" privilege and
+ * can't be decommitted, so they don't suit the arena, and
+ * MPS_KEY_ARENA_HUGE_PAGES has no effect on this platform.
+ */
+
+Size HugePageSize(void)
+{
+  return PageSize();
+}
+
+
 typedef struct VMParamsStruct {
   /* TODO: Add sig and check with AVERT in VMInit and CHECKD in
      VMArenaCheck. */
@@ -92,6 +105,16 @@ Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 }
 
 
+/* VMParamHugePageSize -- return the huge page size requested */
+
+Size VMParamHugePageSize(void *params)
+{
+  AVER(params != NULL);
+  UNUSED(params);
+  return PageSize();
+}
+
+
 /* VMInit -- reserve some virtual address space, and create a VM structure */
 
 Res VMInit(VM vm, Size size, Size grainSize, void *params)
@@ -141,6 +164,8 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = 0;
+  vm->hugePages = FALSE;
+  vm->hugeTLB = FALSE;
 
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -229,6 +254,18 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMMapZeroes -- do newly mapped pages contain zeros?
+ *
+ * Committing pages with VirtualAlloc always fills them with zeros.
+ */
+
+Bool VMMapZeroes(VM vm)
+{
+  AVERT(VM, vm);
+  return TRUE;
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2020 Ravenbrook Limited <https://www.ravenbrook.com/>.
@@ -292,6 +292,7 @@ static Res ArenaRootsWalk(Globals arenaGlobals, mps_roots_stepper_t f,
   Rank rank;
   Res res;
   Seg seg;
+  Index i;
 
   AVERT(Globals, arenaGlobals);
   AVER(FUNCHECK(f));
@@ -312,8 +313,11 @@ static Res ArenaRootsWalk(Globals arenaGlobals, mps_roots_stepper_t f,
   /* .roots-walk.first-stage: In order to fool MPS_FIX12 into calling
      _mps_fix2 for a reference in a root, the reference must pass the
      first-stage test (against the summary of the trace's white
-     set), so make the summary universal. */
+     set), so make the summary universal. The same goes for the fine
+     zone test in _mps_fix2. */
   trace->white = ZoneSetUNIV;
+  for (i = 0; i < NELEMS(trace->fineWhite); ++i)
+    trace->fineWhite[i] = ZoneSetUNIV;
 
   /* .roots-walk.second-stage: In order to fool _mps_fix2 into calling
      our fix function (RootsWalkFix), the reference must be to a
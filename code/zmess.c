@@ -12,6 +12,8 @@
  *  - Check GC messages are correctly generated, posted, and queued,
  *    regardless of when the client gets them.  (Note: "get" means
  *    "mps_message_get", throughout).  See job001989.
+ *  - Check the GC event hook is called with the start, flip, and end
+ *    of each collection, by the time mps_arena_collect returns.
  *
  * Please add tests for other message behaviour into this file.
  * Expand the script language as necessary!  RHSK 2008-12-19.
@@ -109,6 +111,7 @@
 #include "mpstd.h"
 
 #include <stdio.h> /* printf */
+#include <string.h> /* strcmp */
 
 
 #define testArenaSIZE   ((size_t)16<<20)
@@ -133,6 +136,41 @@ enum {
 };
 static int state[myrootCOUNT];
 
+/* gcEvents -- GC events seen by gcEventHook since last checked */
+static char gcEvents[16];
+static size_t gcEventsCount = 0;
+static mps_clock_t gcEventsClock = 0;
+
+
+/* gcEventHook -- record the kinds of GC events */
+
+static void gcEventHook(mps_arena_t arena, const mps_gc_event_s *event,
+                        void *closure)
+{
+  char kind = '?';
+  Insist(closure == &gcEventsCount);
+  Insist(event->clock >= gcEventsClock);
+  gcEventsClock = event->clock;
+  Insist(event->committed <= mps_arena_committed(arena));
+  switch (event->kind) {
+  case MPS_GC_EVENT_START:
+    Insist(event->why != NULL);
+    kind = 'S';
+    break;
+  case MPS_GC_EVENT_FLIP:
+    kind = 'F';
+    break;
+  case MPS_GC_EVENT_END:
+    kind = 'E';
+    break;
+  default:
+    cdie(0, "GC event kind");
+  }
+  Insist(gcEventsCount < NELEMS(gcEvents) - 1);
+  gcEvents[gcEventsCount++] = kind;
+  gcEvents[gcEventsCount] = '\0';
+}
+
 
 /* report -- get and check messages
  *
@@ -239,7 +277,11 @@ static void testscriptC(mps_arena_t arena, const char *script)
       }
       case 'C': {
         printf("  Collect\n");
+        gcEventsCount = 0;
+        gcEvents[0] = '\0';
         die(mps_arena_collect(arena), "mps_arena_collect");
+        printf("  GC events \"%s\"\n", gcEvents);
+        cdie(strcmp(gcEvents, "SFE") == 0, "GC events");
         break;
       }
       case 'F': {
@@ -368,6 +410,7 @@ static void testscriptB(testDataStruct *testData)
   mps_message_type_enable(arena, mps_message_type_gc_start());
   mps_message_type_enable(arena, mps_message_type_gc());
   mps_message_type_enable(arena, mps_message_type_finalization());
+  mps_arena_gc_event_hook_set(arena, gcEventHook, &gcEventsCount);
 
   testscriptC(arena, script);
 